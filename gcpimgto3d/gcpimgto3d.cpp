@@ -183,7 +183,7 @@ int main(){
 					std::string txtnameImg = dir_iter->path().string();
 					std::string txtnameParam = "C:/Users/Wolfgang Brandenburg/Documents/Schnoeggersburg/Daten/OrientierungIII/DLR/" + dir_iter->path().stem().string() + "_param.txt";
 
-					while (!pool.runTask(boost::bind(gcpimgto3d, txtnameImg, txtnameParam, gcps, dir_iter->path().stem().string())));
+					pool.runTask(boost::bind(gcpimgto3d, txtnameImg, txtnameParam, gcps, dir_iter->path().stem().string()));
 				}
 			}
 		}
@@ -29,7 +29,9 @@
 * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *************************************************************************/
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>
 
@@ -46,6 +48,78 @@
 
 typedef double ElementType;
 
+/**
+	Computes the normals of a ply file and writes the pointcloud with the normals into another
+	file. Reading, the computation of the normals and writing run as stages of a pipeline on 
+	chunks of consecutive vertices, so they overlap and only a bounded number of chunks is in 
+	memory. The neighbors of a vertex are searched in its chunk and the halo of the adjacent 
+	chunks, i.e. among the neighbors in file order. The result equals the computation on the 
+	entire pointcloud only if the file is ordered spatially, e.g. in scan order or after 
+	pointcloud::reorderSpatially, so the pipeline has to be enabled explicitly.
+
+	@param[in] input Name of the input file
+	@param[in] output Name of the output file
+	@param[in] neighbors Number of neighbors which will be considered for computation normals
+	@param[in] normal_params Parameter for computing normals
+	@param[in] chunk_size Number of vertices per chunk
+	@param[in] halo Number of vertices of the adjacent chunks which are considered as neighbors
+	@param[in] parallelism Number of threads which compute normals of different chunks
+*/
+template<typename ElementType> void computeNormalsPipeline(
+	char* input,
+	char* output,
+	size_t neighbors,
+	const pointcloud::NormalParams& normal_params,
+	size_t chunk_size,
+	size_t halo,
+	size_t parallelism)
+{
+	typedef std::shared_ptr<pointcloud::PointcloudChunk<ElementType>> ChunkPtr;
+
+	io::PlyChunkReader<ElementType> reader(input);
+	io::PlyChunkWriter<ElementType> writer(output, reader.getNumberOfVertices(), reader.isColor(), true);
+
+	utils::Pipeline pipeline(2 * parallelism);
+
+	/**
+		Read the file chunk by chunk
+	*/
+	utils::Channel<ChunkPtr>& chunks = pipeline.source<ChunkPtr>([&](const utils::Emit<ChunkPtr>& emit_) {
+		reader.read(chunk_size, emit_);
+	});
+
+	/**
+		Extend the chunks by the halo of the adjacent chunks
+	*/
+	pointcloud::HaloWindow<ElementType> window(halo);
+	utils::Channel<ChunkPtr>& extended_chunks = pipeline.stageWithFlush<ChunkPtr>(chunks,
+		[&](ChunkPtr& chunk_, const utils::Emit<ChunkPtr>& emit_) { window.push(chunk_, emit_); },
+		[&](const utils::Emit<ChunkPtr>& emit_) { window.flush(emit_); });
+
+	/**
+		Compute the normals of several chunks at once
+	*/
+	utils::Channel<ChunkPtr>& normal_chunks = pipeline.stage<ChunkPtr>(extended_chunks,
+		[&](ChunkPtr& chunk_, const utils::Emit<ChunkPtr>& emit_) {
+			pointcloud::computeNormals<ElementType>(*chunk_, neighbors, normal_params);
+			emit_(chunk_);
+		}, parallelism);
+
+	/**
+		Write the chunks in the order of the input file
+	*/
+	utils::Reorder<ChunkPtr> reorder;
+	pipeline.sink(normal_chunks, [&](ChunkPtr& chunk_) {
+		reorder.push(chunk_->sequence, chunk_, [&](ChunkPtr ordered_) {
+			writer.write(*ordered_);
+			return true;
+		});
+	});
+
+	pipeline.run();
+	writer.close();
+}
+
 int main(int argc, char* argv[]) {
 
 	std::cout << "----------------------- Main -----------------------" << std::endl;
@@ -54,36 +128,86 @@ int main(int argc, char* argv[]) {
 		Parameter
 	*/
 	utils::Timer time;
-	int cores = (unsigned int)std::thread::hardware_concurrency();
+	int cores = std::max(1, (int)std::thread::hardware_concurrency()); // at least one, as zero means unknown
 	size_t neighbors = 50;
-	
+	size_t chunk_size = 100000;
+	size_t halo = 10000;
+	bool pipeline = false;
+	size_t spill = 0;
+	std::string spill_directory;
+
+	for (int i = 1; i < argc; i++) {
+		std::string option(argv[i]);
+		if (option == "--pipeline") {
+			pipeline = true;
+		}
+		else if (option == "--spill" && i + 1 < argc) {
+			spill = std::stoull(argv[++i]);
+		}
+		else if (option == "--spill-directory" && i + 1 < argc) {
+			spill_directory = argv[++i];
+		}
+	}
+
 	/**
-		Read pointcloud
+		Matrices with at least spill megabytes are mapped to temporary files, so that 
+		pointclouds larger than the main memory can be processed
 	*/
-	pointcloud::PointcloudSoA<ElementType> pointcloud;
+	utils::setSpill(spill_directory, spill << 20);
 
+	/**
+		The calling thread works as well, so one thread less is needed
+	*/
+	utils::setExecutorSize(cores - 1);
+	
 	//char* file = "C:/Users/Wolfgang Brandenburg/OneDrive/Dokumente/3DModelle/Ettlingen/Ettlingen1.ply";
 	//char* file = "C:/Users/Wolfgang Brandenburg/OneDrive/Dokumente/3DModelle/Sonstiges/buny.ply";
 	char* file = "C:/Users/Wolfgang Brandenburg/OneDrive/Dokumente/3DModelle/Gebaeude51/Gebaeude511.ply";
 	//char *file = "C:/Users/Wolfgang Brandenburg/OneDrive/Dokumente/3DModelle/Unikirche/UnikircheII.ply";
+	char* result = "C:/Users/Wolfgang Brandenburg/OneDrive/Dokumente/3DModelle/result.ply";
+
+	pointcloud::NormalParams normal_params;
+		normal_params.setCores(cores);
+		normal_params.setNormalComputation(NormalComputation::PLANESVD);
+		normal_params.setWeightFunction(WeightFunction::LINEAR);
 
-	time.start();
-	if (io::readPly<ElementType>(file, pointcloud)) {
-		std::cout << "File with " << pointcloud.getNumberOfVertices() << " point has been read in "
-			<< time.stop() << " s into Pointcloud" << std::endl;
+	pointcloud::PointcloudSoA<ElementType> pointcloud;
+
+	if (pipeline) {
+		/**
+			----------------------- Computation of the normals in chunks -----------------------
+		*/
+		time.start();
+		computeNormalsPipeline<ElementType>(file, result, neighbors, normal_params, chunk_size, halo, 
+			std::max(1, cores / 2));
+		std::cout << "Computation of Normals in " << time.stop() << " s" << std::endl;
+
+		/**
+			Read pointcloud with normals
+		*/
+		time.start();
+		if (io::readPly<ElementType>(result, pointcloud)) {
+			std::cout << "File with " << pointcloud.getNumberOfVertices() << " point has been read in "
+				<< time.stop() << " s into Pointcloud" << std::endl;
+		}
 	}
-	/**
-		----------------------- Computation of the normals -----------------------
-	*/
-	time.start();
-	
-		pointcloud::NormalParams normal_params;
-			normal_params.setCores(cores);
-			normal_params.setNormalComputation(NormalComputation::PLANESVD);
-			normal_params.setWeightFunction(WeightFunction::LINEAR);
-		pointcloud::computeNormals<ElementType>(pointcloud, neighbors, normal_params);
+	else {
+		/**
+			Read pointcloud
+		*/
+		time.start();
+		if (io::readPly<ElementType>(file, pointcloud)) {
+			std::cout << "File with " << pointcloud.getNumberOfVertices() << " point has been read in "
+				<< time.stop() << " s into Pointcloud" << std::endl;
+		}
 
-	std::cout << "Computation of Normals in " << time.stop() << " s" << std::endl;
+		/**
+			----------------------- Computation of the normals -----------------------
+		*/
+		time.start();
+		pointcloud::computeNormals<ElementType>(pointcloud, neighbors, normal_params);
+		std::cout << "Computation of Normals in " << time.stop() << " s" << std::endl;
+	}
 		
 	/**
 		----------------------- Computation of the surfaces -----------------------
@@ -91,10 +215,10 @@ int main(int argc, char* argv[]) {
 		/**
 			Build kdtree
 		*/
-		utils::Matrix<ElementType> pointcloud_matrix;
-		pointcloud.getMatrix(pointcloud_matrix);
+		utils::Matrix<ElementType> pointcloud_matrix = pointcloud.getPointsMatrix();
 		trees::Index<ElementType> kdtree_index(pointcloud_matrix, trees::KDTreeIndexParams(neighbors));
 		kdtree_index.buildIndex();
+
 		utils::randSeed();
 		do{
 			/**
@@ -106,7 +230,7 @@ int main(int argc, char* argv[]) {
 
 			trees::TreeParams tree_params;
 			tree_params.setCores(normal_params.getCores());
-			utils::Matrix<size_t> indices(1, neighbors);
+			utils::Matrix<uint32_t> indices(1, neighbors);
 			utils::Matrix<ElementType> dists(1, neighbors);
 
 			kdtree_index.knnSearch(point.transpose(), indices, dists, neighbors, tree_params);
@@ -241,10 +365,5 @@ int main(int argc, char* argv[]) {
 			glview.mainLoop();
 		} while (true);
 
-	/**
-		Write results
-	*/
-	io::writePly("C:/Users/Wolfgang Brandenburg/OneDrive/Dokumente/3DModelle/result.ply", pointcloud);
-
 	return(0);
 }
\ No newline at end of file
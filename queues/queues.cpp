@@ -0,0 +1,299 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tools/utils/pipeline.h"
+#include "tools/utils/queue.h"
+
+/**
+	Stress test and throughput benchmark of the ring buffers in utils/queue.h and the channels of 
+	utils/pipeline.h. Every test checks that each element is taken exactly once, the program 
+	returns a non-zero value if a test fails.
+
+	Usage: queues [--items N] [--capacity N] [--threads N]
+*/
+
+/**
+	Returns the seconds since a point in time
+
+	@param[in] begin Point in time
+	@return Seconds
+*/
+double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+	Prints the result of a test
+
+	@param[in] name Name of the test
+	@param[in] items Number of transferred elements
+	@param[in] seconds Duration
+	@param[in] passed Flag whether the elements have been transferred correctly
+	@return passed
+*/
+bool report(const std::string& name, size_t items, double seconds, bool passed)
+{
+	std::cout << (passed ? "[passed] " : "[FAILED] ") << name << ": " << items << " elements in "
+		<< seconds << " s, " << (double)items / seconds / 1.0e6 << " M elements/s" << std::endl;
+	return passed;
+}
+
+/**
+	One producer and one consumer transfer increasing numbers, the consumer checks the order
+
+	@param[in] items Number of elements
+	@param[in] capacity Capacity of the ring
+	@param[in] batch Number of elements which are put and taken at once, the blocking functions 
+		push and pop are only used if the ring is full or empty. 0 uses only push and pop.
+	@return True if the test has passed
+*/
+bool testSPSC(size_t items, size_t capacity, size_t batch)
+{
+	utils::SPSCQueue<uint64_t> queue(capacity);
+	std::atomic<bool> ordered(true);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::thread consumer([&]() {
+		uint64_t expected = 0;
+		std::vector<uint64_t> elements(std::max<size_t>(1, batch));
+		while (expected < items) {
+			size_t number = 1;
+			if (batch) {
+				number = queue.tryPopBatch(elements.data(), batch);
+				if (!number) {
+					queue.pop(elements[0]);
+					number = 1;
+				}
+			}
+			else {
+				queue.pop(elements[0]);
+			}
+			for (size_t i = 0; i < number; i++) {
+				if (elements[i] != expected++) {
+					ordered = false;
+				}
+			}
+		}
+	});
+
+	std::vector<uint64_t> elements(std::max<size_t>(1, batch));
+	for (uint64_t next = 0; next < items;) {
+		if (batch) {
+			size_t number = std::min<size_t>(batch, items - next);
+			for (size_t i = 0; i < number; i++) {
+				elements[i] = next + i;
+			}
+			number = queue.tryPushBatch(elements.data(), number);
+			if (!number) {
+				queue.push(elements[0]);
+				number = 1;
+			}
+			next += number;
+		}
+		else {
+			queue.push(next++);
+		}
+	}
+	consumer.join();
+
+	return report("SPSC " + (batch ? "batch " + std::to_string(batch) : std::string("blocking")), 
+		items, secondsSince(begin), ordered);
+}
+
+/**
+	Several producers and consumers transfer the numbers 1..items, the consumers sum and count 
+	the taken elements
+
+	@param[in] items Number of elements
+	@param[in] capacity Capacity of the ring
+	@param[in] producers Number of producer threads
+	@param[in] consumers Number of consumer threads
+	@return True if the test has passed
+*/
+bool testMPMC(size_t items, size_t capacity, size_t producers, size_t consumers)
+{
+	utils::MPMCQueue<uint64_t> queue(capacity);
+	std::atomic<uint64_t> sum(0);
+	std::atomic<uint64_t> count(0);
+	std::atomic<uint64_t> next(1);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < producers; i++) {
+		threads.push_back(std::thread([&]() {
+			for (uint64_t element = next++; element <= items; element = next++) {
+				queue.push(element);
+			}
+		}));
+	}
+
+	/**
+		Every consumer takes elements until the sentinel 0, which is put once per consumer 
+		after all producers have finished
+	*/
+	for (size_t i = 0; i < consumers; i++) {
+		threads.push_back(std::thread([&]() {
+			uint64_t local_sum = 0, local_count = 0, element;
+			for (queue.pop(element); element; queue.pop(element)) {
+				local_sum += element;
+				local_count++;
+			}
+			sum += local_sum;
+			count += local_count;
+		}));
+	}
+
+	for (size_t i = 0; i < producers; i++) {
+		threads[i].join();
+	}
+	for (size_t i = 0; i < consumers; i++) {
+		queue.push(0);
+	}
+	for (size_t i = producers; i < threads.size(); i++) {
+		threads[i].join();
+	}
+
+	return report("MPMC " + std::to_string(producers) + ":" + std::to_string(consumers) + 
+		", capacity " + std::to_string(queue.getCapacity()), items, 
+		secondsSince(begin), count == items && sum == (uint64_t)items * (items + 1) / 2);
+}
+
+/**
+	A pipeline with a source, a parallel stage and a sink transfers the numbers 1..items, and a 
+	closed channel has to release a consumer which is blocked on it
+
+	@param[in] items Number of elements
+	@param[in] capacity Capacity of the channels
+	@param[in] parallelism Number of threads of the stage
+	@return True if the test has passed
+*/
+bool testPipeline(size_t items, size_t capacity, size_t parallelism)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	uint64_t sum = 0, count = 0;
+	utils::Pipeline pipeline(capacity);
+	utils::Channel<uint64_t>& numbers = pipeline.source<uint64_t>([&](const utils::Emit<uint64_t>& emit_) {
+		for (uint64_t i = 1; i <= items; i++) {
+			emit_(i);
+		}
+	});
+	utils::Channel<uint64_t>& doubled = pipeline.stage<uint64_t>(numbers, 
+		[](uint64_t& element_, const utils::Emit<uint64_t>& emit_) { emit_(2 * element_); }, parallelism);
+	pipeline.sink(doubled, [&](uint64_t& element_) {
+		sum += element_;
+		count++;
+	});
+	pipeline.run();
+
+	bool passed = count == items && sum == (uint64_t)items * (items + 1);
+
+	/**
+		A consumer which waits on an empty channel returns after the channel has been closed
+	*/
+	utils::Channel<uint64_t> channel(capacity);
+	std::atomic<bool> released(false);
+	std::thread consumer([&]() {
+		uint64_t element;
+		released = !channel.pop(element);
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	channel.close();
+	consumer.join();
+
+	return report("Pipeline 1:" + std::to_string(parallelism) + ":1", items, secondsSince(begin), 
+		passed && released);
+}
+
+int main(int argc, char* argv[]) {
+
+	std::cout << "----------------------- Main -----------------------" << std::endl;
+
+	/**
+		Parameter
+	*/
+	size_t items = 10000000;
+	size_t capacity = 1024;
+	size_t threads = std::max<size_t>(2, std::thread::hardware_concurrency() / 2);
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option(argv[i]);
+		if (option == "--items") {
+			items = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--capacity") {
+			capacity = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--threads") {
+			threads = std::stoull(argv[i + 1]);
+		}
+	}
+
+	bool passed = true;
+
+	/**
+		----------------------- Single producer, single consumer -----------------------
+	*/
+	passed &= testSPSC(items, capacity, 0);
+	passed &= testSPSC(items, capacity, 1);
+	passed &= testSPSC(items, capacity, 64);
+
+	/**
+		A ring of one element makes both sides sleep and wake each other constantly
+	*/
+	passed &= testSPSC(items / 10, 1, 0);
+
+	/**
+		----------------------- Multiple producers, multiple consumers -----------------------
+	*/
+	passed &= testMPMC(items, capacity, 1, 1);
+	for (size_t i = 2; i <= threads; i *= 2) {
+		passed &= testMPMC(items, capacity, i, i);
+	}
+	passed &= testMPMC(items / 10, 2, threads, threads);
+
+	/**
+		----------------------- Pipeline -----------------------
+	*/
+	passed &= testPipeline(items / 10, 4, threads);
+
+	return passed ? 0 : 1;
+}
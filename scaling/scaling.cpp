@@ -0,0 +1,197 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tools/parameters.h"
+#include "tools/utils/matrix.h"
+#include "tools/utils/numa.h"
+#include "tools/utils/parallel.h"
+
+/**
+	Scaling benchmark of the numa mode. A large matrix is initialized, copied and read repeatedly 
+	by parallel loops of the process-wide executor. Without the numa mode the pages of the 
+	buffers are placed by the calling thread and the workers of other sockets read remote 
+	memory, with the numa mode every worker reads the pages it has touched first. The size of the
+	executor is fixed at its first use, so without --threads the program runs itself once per 
+	number of threads and mode and prints the bandwidths of all runs.
+
+	Usage: scaling [--megabytes N] [--passes N] [--threads N --numa 0|1]
+*/
+
+/**
+	Returns the seconds since a point in time
+
+	@param[in] begin Point in time
+	@return Seconds
+*/
+double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+	Prints the bandwidth of a phase
+
+	@param[in] name Name of the phase
+	@param[in] bytes Number of processed bytes
+	@param[in] seconds Duration
+*/
+void report(const std::string& name, size_t bytes, double seconds)
+{
+	std::cout << "\t" << name << ": " << seconds << " s, " << (double)bytes / seconds / 1.0e9 << " GB/s" << std::endl;
+}
+
+/**
+	Measures one configuration of the executor
+
+	@param[in] megabytes Size of the matrix in megabytes
+	@param[in] passes Number of passes which read the matrix
+	@param[in] threads Number of threads including the calling thread
+	@param[in] numa Flag whether the numa mode is enabled
+*/
+void measure(size_t megabytes, size_t passes, size_t threads, bool numa)
+{
+	utils::setNumaMode(numa);
+	utils::setExecutorSize(std::max<size_t>(1, threads) - 1);
+	utils::getExecutor();
+
+	std::cout << "Threads " << std::max<size_t>(1, threads) << ", numa mode " << (numa ? "on" : "off") << std::endl;
+
+	const size_t cols = 4;
+	const size_t rows = (megabytes << 20) / (sizeof(float) * cols);
+	const size_t bytes = sizeof(float) * rows * cols;
+
+	/**
+		Allocation and first touch
+	*/
+	auto begin = std::chrono::steady_clock::now();
+	utils::Matrix<float> matrix(rows, cols);
+	report("initialize", bytes, secondsSince(begin));
+
+	utils::parallel_for(0, rows, 1 << 14, [&](size_t begin_, size_t end_) {
+		for (size_t i = begin_; i < end_; i++) {
+			for (size_t j = 0; j < cols; j++) {
+				matrix[i][j] = (float)((i + j) % 7);
+			}
+		}
+	});
+
+	/**
+		Copy into a new matrix
+	*/
+	begin = std::chrono::steady_clock::now();
+	utils::Matrix<float> copy(matrix);
+	report("copy", 2 * bytes, secondsSince(begin));
+
+	/**
+		Read the copy with the partition of the parallel loops
+	*/
+	double total = 0;
+	std::mutex mutex;
+	begin = std::chrono::steady_clock::now();
+	for (size_t p = 0; p < passes; p++) {
+		utils::parallel_for(0, rows, 1 << 14, [&](size_t begin_, size_t end_) {
+			double subtotal = 0;
+			for (size_t i = begin_; i < end_; i++) {
+				const float* row = copy[i];
+				subtotal += row[0] + row[1] + row[2] + row[3];
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			total += subtotal;
+		});
+	}
+	report("read", passes * bytes, secondsSince(begin));
+
+	std::cout << "\tchecksum " << total << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+	std::cout << "----------------------- Main -----------------------" << std::endl;
+
+	/**
+		Parameter
+	*/
+	size_t megabytes = 1024;
+	size_t passes = 10;
+	size_t threads = 0;
+	bool numa = false;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option(argv[i]);
+		if (option == "--megabytes") {
+			megabytes = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--passes") {
+			passes = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--threads") {
+			threads = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--numa") {
+			numa = std::stoi(argv[i + 1]) != 0;
+		}
+	}
+
+	if (threads) {
+		measure(megabytes, passes, threads, numa);
+		return 0;
+	}
+
+	/**
+		----------------------- Sweep over the number of threads -----------------------
+	*/
+	const size_t processors = std::max<size_t>(1, std::thread::hardware_concurrency());
+	std::vector<size_t> counts;
+	for (size_t t = 1; t < processors; t *= 2) {
+		counts.push_back(t);
+	}
+	counts.push_back(processors);
+
+	int result = 0;
+	for (size_t t : counts) {
+		for (int mode = 0; mode < 2; mode++) {
+			std::string command = std::string("\"") + argv[0] + "\" --megabytes " + std::to_string(megabytes) +
+				" --passes " + std::to_string(passes) + " --threads " + std::to_string(t) + " --numa " + std::to_string(mode);
+			result |= std::system(command.c_str());
+		}
+	}
+
+	return result ? 1 : 0;
+}
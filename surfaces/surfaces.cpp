@@ -0,0 +1,194 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "tools/parameters.h"
+#include "tools/math.h"
+#include "tools/pointcloud.h"
+#include "tools/utils.h"
+
+#include "trees/trees.hpp"
+
+/**
+	Benchmark of the polynomial surfaces of all neighborhoods of a pointcloud. The surfaces of a 
+	synthetic pointcloud are computed once with surfPolyBatch and for a sample of the points with
+	surfPoly, the heights of both surfaces at the reference points are compared.
+
+	Usage: surfaces [--points N] [--neighbors N] [--degree N] [--samples N]
+*/
+
+/**
+	Returns the seconds since a point in time
+
+	@param[in] begin Point in time
+	@return Seconds
+*/
+double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+	Evaluates a polynomial surface at a position
+
+	@param[in] coefficients Coefficients of the surface
+	@param[in] x First coordinate
+	@param[in] y Second coordinate
+	@param[in] degree Degree of the polynomial
+	@return Height of the surface
+*/
+double evaluate(const double* coefficients, double x, double y, size_t degree)
+{
+	utils::Matrix<double> row(1, ((degree + 2) * (degree + 1)) / 2);
+	math::buildDesignRowPolynomial3D(x, y, row.getPtr(), degree);
+
+	double height = 0;
+	for (size_t i = 0; i < row.getCols(); i++) {
+		height += row[0][i] * coefficients[i];
+	}
+	return height;
+}
+
+int main(int argc, char* argv[]) {
+
+	std::cout << "----------------------- Main -----------------------" << std::endl;
+
+	/**
+		Parameter
+	*/
+	size_t number_of_points = 1000000;
+	size_t neighbors = 30;
+	size_t degree = 4;
+	size_t samples = 10000;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option(argv[i]);
+		if (option == "--points") {
+			number_of_points = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--neighbors") {
+			neighbors = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--degree") {
+			degree = std::stoull(argv[i + 1]);
+		}
+		else if (option == "--samples") {
+			samples = std::stoull(argv[i + 1]);
+		}
+	}
+	samples = std::min(samples, number_of_points);
+
+	const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+	utils::setExecutorSize(cores - 1);
+
+	/**
+		Synthetic pointcloud on a smooth height field
+	*/
+	utils::randSeed();
+	utils::Matrix<double> points(number_of_points, 3);
+	for (size_t i = 0; i < number_of_points; i++) {
+		points[i][0] = utils::randDouble();
+		points[i][1] = utils::randDouble();
+		points[i][2] = 0.1 * std::sin(4 * points[i][0]) * std::cos(4 * points[i][1]);
+	}
+
+	/**
+		Neighbors of all points
+	*/
+	auto begin = std::chrono::steady_clock::now();
+	trees::Index<double> kdtree_index(points, trees::KDTreeIndexParams(neighbors));
+	kdtree_index.buildIndex();
+
+	trees::TreeParams tree_params;
+	tree_params.setCores(cores);
+	utils::Matrix<uint32_t> indices(number_of_points, neighbors);
+	utils::Matrix<double> dists(number_of_points, neighbors);
+	kdtree_index.knnSearch(points, indices, dists, neighbors, tree_params);
+	std::cout << "Search of " << neighbors << " neighbors in " << secondsSince(begin) << " s" << std::endl;
+
+	pointcloud::SurfaceParams surface_params;
+	surface_params.setSurfaceComputation(SurfaceComputation::SURFPOLY);
+	surface_params.setPolynomialDegree(degree);
+	surface_params.setCores(cores);
+
+	/**
+		----------------------- Batched surfaces of all points -----------------------
+	*/
+	begin = std::chrono::steady_clock::now();
+	utils::Matrix<double> parameters;
+	pointcloud::surfPolyBatch(points, indices, surface_params, parameters);
+	double seconds = secondsSince(begin);
+	std::cout << "surfPolyBatch: " << number_of_points << " surfaces in " << seconds << " s, "
+		<< (double)number_of_points / seconds / 1.0e3 << " K surfaces/s" << std::endl;
+
+	/**
+		----------------------- Single surfaces of a sample -----------------------
+	*/
+	const utils::FixedMatrix<double, 3, 1> normal({ 0, 0, 1 });
+	const size_t stride = std::max<size_t>(1, number_of_points / std::max<size_t>(1, samples));
+	utils::Matrix<double> neighborhood(neighbors, 3);
+	double deviation = 0;
+	size_t mismatches = 0;
+	size_t compared = 0;
+
+	begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < number_of_points && compared < samples; i += stride, compared++) {
+		for (size_t j = 0; j < neighbors; j++) {
+			std::memcpy(neighborhood[j], points[indices[i][j]], sizeof(double) * 3);
+		}
+		utils::FixedMatrix<double, 3, 1> point(points[i]);
+		utils::Matrix<double> parameter = pointcloud::surfPoly(point, neighborhood, normal, surface_params);
+
+		double single = evaluate(parameter.getPtr(), points[i][0], points[i][1], degree);
+		double batch = evaluate(parameters[i], points[i][0], points[i][1], degree);
+		if (std::isnan(single) != std::isnan(batch)) {
+			mismatches++;
+		}
+		else if (!std::isnan(single)) {
+			deviation = std::max(deviation, std::abs(single - batch));
+		}
+	}
+	seconds = secondsSince(begin);
+	std::cout << "surfPoly: " << compared << " surfaces in " << seconds << " s, "
+		<< (double)compared / seconds / 1.0e3 << " K surfaces/s" << std::endl;
+	std::cout << "Maximal deviation of the heights " << deviation << ", " << mismatches 
+		<< " surfaces singular in only one computation" << std::endl;
+
+	return 0;
+}
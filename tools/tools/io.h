@@ -30,6 +30,7 @@
 #ifndef INCLUDE_IO_H_
 #define INCLUDE_IO_H_
 
+#include "io/ionpy.h"
 #include "io/ioply.h"
 
 #endif /* INCLUDE_IO_H_ */
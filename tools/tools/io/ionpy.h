@@ -0,0 +1,343 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef IO_IONPY_H_
+#define IO_IONPY_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#include "tools/utils/matrix.h"
+
+#include "pointcloud/pointcloud.h"
+
+namespace io
+{
+	/**
+		Returns true if an element type can be stored in a npy file: float, double and integral 
+		types of up to eight bytes except bool
+
+		@return True if the type is supported
+	*/
+	template<typename ElementType> constexpr bool isNpyType()
+	{
+		return std::is_same<ElementType, float>::value || std::is_same<ElementType, double>::value ||
+			(std::is_integral<ElementType>::value && !std::is_same<ElementType, bool>::value && sizeof(ElementType) <= 8);
+	}
+
+	/**
+		Get the numpy type descriptor of an element type, the data is written in the byte order 
+		of the machine, which is assumed to be little-endian. Integral types are described by 
+		their size and signedness, so e.g. long long and char are supported as well.
+
+		@return Type descriptor
+	*/
+	template<typename ElementType> const char* getNpyDescriptor()
+	{
+		static_assert(isNpyType<ElementType>(), "The element type cannot be stored in a npy file");
+
+		if (std::is_same<ElementType, float>::value) { return "<f4"; }
+		if (std::is_same<ElementType, double>::value) { return "<f8"; }
+
+		const bool sign = std::is_signed<ElementType>::value;
+		switch (sizeof(ElementType)) {
+		case 1: return sign ? "|i1" : "|u1";
+		case 2: return sign ? "<i2" : "<u2";
+		case 4: return sign ? "<i4" : "<u4";
+		default: return sign ? "<i8" : "<u8";
+		}
+	}
+
+	/**
+		Builds the header of a npy file of version 1.0 for a two dimensional C-ordered array, the 
+		header is padded so that the data starts at a multiple of 64 bytes
+
+		@param[in] rows Rows of the array
+		@param[in] cols Columns of the array
+		@return Header
+	*/
+	template<typename ElementType> std::string getNpyHeader(size_t rows, size_t cols)
+	{
+		std::string dictionary = std::string("{'descr': '") + getNpyDescriptor<ElementType>() + 
+			"', 'fortran_order': False, 'shape': (" + std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+
+		const size_t preamble = 10;
+		size_t length = preamble + dictionary.size() + 1;
+		dictionary.append((64 - length % 64) % 64, ' ');
+		dictionary.push_back('\n');
+
+		const size_t header_length = dictionary.size();
+		std::string header("\x93NUMPY\x01\x00", 8);
+		header.push_back((char)(header_length & 0xff));
+		header.push_back((char)(header_length >> 8));
+
+		return header + dictionary;
+	}
+
+	/**
+		Reads the header of a npy file and checks whether the array can be stored in a matrix 
+		with a certain element type. Arrays with one dimension are read as column vector.
+
+		@param[in] file Name of file
+		@param[out] rows Rows of the array
+		@param[out] cols Columns of the array
+		@param[out] offset Position of the first element in the file
+		@return Returns true if the header is valid, the element type matches and the file 
+			contains all elements
+	*/
+	template<typename ElementType> bool readNpyHeader(const std::string& file, size_t& rows, size_t& cols, size_t& offset)
+	{
+		std::ifstream stream(file, std::ios::binary);
+		char preamble[12];
+		if (!stream.read(preamble, 10) || std::string(preamble, 6) != "\x93NUMPY") {
+			return false;
+		}
+
+		size_t header_length;
+		if (preamble[6] == 1) {
+			header_length = (uint8_t)preamble[8] | ((size_t)(uint8_t)preamble[9] << 8);
+			offset = 10 + header_length;
+		}
+		else {
+			if (!stream.read(preamble + 10, 2)) {
+				return false;
+			}
+			header_length = (uint8_t)preamble[8] | ((size_t)(uint8_t)preamble[9] << 8) |
+				((size_t)(uint8_t)preamble[10] << 16) | ((size_t)(uint8_t)preamble[11] << 24);
+			offset = 12 + header_length;
+		}
+
+		std::string dictionary(header_length, ' ');
+		if (!stream.read(&dictionary[0], header_length)) {
+			return false;
+		}
+
+		/**
+			Check the type and the order of the array
+		*/
+		const char* descriptor = getNpyDescriptor<ElementType>();
+		if (dictionary.find(std::string("'descr': '") + descriptor + "'") == std::string::npos ||
+			dictionary.find("'fortran_order': False") == std::string::npos) {
+			return false;
+		}
+
+		/**
+			Read the shape
+		*/
+		size_t position = dictionary.find("'shape': (");
+		if (position == std::string::npos) {
+			return false;
+		}
+		const char* shape = dictionary.c_str() + position + 10;
+		char* shape_end;
+
+		rows = std::strtoull(shape, &shape_end, 10);
+		if (shape_end == shape) {
+			return false;
+		}
+		while (*shape_end == ',' || *shape_end == ' ') {
+			shape_end++;
+		}
+		if (*shape_end == ')') {
+			cols = 1;
+		}
+		else {
+			shape = shape_end;
+			cols = std::strtoull(shape, &shape_end, 10);
+			while (*shape_end == ',' || *shape_end == ' ') {
+				shape_end++;
+			}
+		}
+
+		if (shape_end == shape || *shape_end != ')') {
+			return false;
+		}
+
+		/**
+			Check whether the file contains all elements
+		*/
+		stream.seekg(0, std::ios::end);
+
+		return (size_t)stream.tellg() >= offset + sizeof(ElementType) * rows * cols;
+	}
+
+	/**
+		Write a matrix to a npy file, the data-array is written at once without conversion
+
+		@param[in] file Name of file
+		@param[in] matrix Matrix
+		@return Returns true if writing was successful
+	*/
+	template<typename ElementType> bool writeNpy(const std::string& file, const utils::Matrix<ElementType>& matrix)
+	{
+		std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+		std::string header = getNpyHeader<ElementType>(matrix.getRows(), matrix.getCols());
+
+		stream.write(header.data(), header.size());
+		stream.write((const char*)matrix.getPtr(), sizeof(ElementType) * matrix.getRows() * matrix.getCols());
+
+		return (bool)stream;
+	}
+
+	/**
+		Read a matrix from a npy file
+
+		The file can be mapped instead of being read into memory. A mapped matrix is READ-ONLY: 
+		the pages are mapped without write access, so writing an element through operator[], 
+		operator() or getPtr() terminates the process with a segmentation fault. Assigning to 
+		the matrix replaces the mapping by a copy.
+
+		@param[in] file Name of file
+		@param[in,out] matrix Matrix
+		@param[in] map Flag whether the file is mapped read-only instead of being read into memory
+		@return Returns true if reading was successful
+	*/
+	template<typename ElementType> bool readNpy(const std::string& file, utils::Matrix<ElementType>& matrix, bool map = false)
+	{
+		size_t rows, cols, offset;
+		if (!readNpyHeader<ElementType>(file, rows, cols, offset)) {
+			return false;
+		}
+
+		if (map) {
+			return matrix.map(file, rows, cols, utils::MappingMode::READ, offset);
+		}
+
+		std::ifstream stream(file, std::ios::binary);
+		stream.seekg(offset);
+		matrix = utils::Matrix<ElementType>::uninitialized(rows, cols);
+
+		return (bool)stream.read((char*)matrix.getPtr(), sizeof(ElementType) * rows * cols);
+	}
+
+	/**
+		Create a npy file and map its array writable, so that a result can be computed directly 
+		into the file
+
+		@param[in] file Name of file
+		@param[in] rows Rows of the array
+		@param[in] cols Columns of the array
+		@param[in,out] matrix Matrix which maps the array of the file
+		@return Returns true if the file has been created
+	*/
+	template<typename ElementType> bool createNpy(const std::string& file, size_t rows, size_t cols, utils::Matrix<ElementType>& matrix)
+	{
+		std::string header = getNpyHeader<ElementType>(rows, cols);
+		{
+			std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+			if (!stream.write(header.data(), header.size())) {
+				return false;
+			}
+		}
+
+		return matrix.map(file, rows, cols, utils::MappingMode::READ_WRITE, header.size());
+	}
+
+	/**
+		Write the data-array of a matrix to a raw binary file in row-major order, the file can be 
+		read with utils::Matrix::mapFile
+
+		@param[in] file Name of file
+		@param[in] matrix Matrix
+		@return Returns true if writing was successful
+	*/
+	template<typename ElementType> bool writeRaw(const std::string& file, const utils::Matrix<ElementType>& matrix)
+	{
+		std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+		stream.write((const char*)matrix.getPtr(), sizeof(ElementType) * matrix.getRows() * matrix.getCols());
+
+		return (bool)stream;
+	}
+
+	/**
+		Write every channel of a pointcloud to its own npy file: prefix_points.npy, 
+		prefix_normals.npy, prefix_colors.npy and prefix_triangles.npy with three columns each.
+		Normals, colors and triangles are written if the pointcloud has them.
+
+		@param[in] prefix Path and prefix of the files
+		@param[in] pointcloud Pointcloud
+		@return Returns true if writing was successful
+	*/
+	template<typename ElementType> bool writeNpy(const std::string& prefix, const pointcloud::Pointcloud<ElementType>& pointcloud)
+	{
+		const size_t vertices = pointcloud.getNumberOfVertices();
+
+		utils::Matrix<ElementType> points;
+		if (!createNpy(prefix + "_points.npy", vertices, 3, points)) {
+			return false;
+		}
+		ElementType* points_ptr = points.getPtr();
+		for (typename pointcloud::Pointcloud<ElementType>::template Iterator<ElementType> it = pointcloud.beginPoint(); it != pointcloud.endPoint(); it++) {
+			*points_ptr++ = *it;
+		}
+
+		if (pointcloud.isNormal()) {
+			utils::Matrix<ElementType> normals;
+			if (!createNpy(prefix + "_normals.npy", vertices, 3, normals)) {
+				return false;
+			}
+			ElementType* normals_ptr = normals.getPtr();
+			for (typename pointcloud::Pointcloud<ElementType>::template Iterator<ElementType> it = pointcloud.beginNormal(); it != pointcloud.endNormal(); it++) {
+				*normals_ptr++ = *it;
+			}
+		}
+
+		if (pointcloud.isColor()) {
+			utils::Matrix<uint8_t> colors;
+			if (!createNpy(prefix + "_colors.npy", vertices, 3, colors)) {
+				return false;
+			}
+			uint8_t* colors_ptr = colors.getPtr();
+			for (typename pointcloud::Pointcloud<ElementType>::template Iterator<uint8_t> it = pointcloud.beginColor(); it != pointcloud.endColor(); it++) {
+				*colors_ptr++ = *it;
+			}
+		}
+
+		if (pointcloud.isTriangle()) {
+			utils::Matrix<size_t> triangles;
+			if (!createNpy(prefix + "_triangles.npy", pointcloud.getNumberOfTriangles(), 3, triangles)) {
+				return false;
+			}
+			size_t* triangles_ptr = triangles.getPtr();
+			for (typename pointcloud::Pointcloud<ElementType>::template Iterator<size_t> it = pointcloud.beginTriangle(); it != pointcloud.endTriangle(); it++) {
+				*triangles_ptr++ = *it;
+			}
+		}
+
+		return true;
+	}
+}
+
+#endif /* IO_IONPY_H_ */
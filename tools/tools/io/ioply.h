@@ -32,10 +32,14 @@
 #ifndef IO_IOPLY_H_
 #define IO_IOPLY_H_
 
+#include <functional>
+#include <memory>
+
 #include <rply.h>
 
 #include "tools/parameters.h"
 
+#include "pointcloud/chunk.h"
 #include "pointcloud/pointcloud.h"
 
 namespace io
@@ -537,6 +541,395 @@ namespace io
 	
 		return true;
 	}
+
+	/**
+		Reads the vertices of a ply file in chunks of consecutive vertices, so that the file can be
+		processed while it is read and the entire pointcloud does not have to fit into memory. The
+		header is read by the constructor. Faces are not read.
+	*/
+	template<typename ElementType>
+	class PlyChunkReader
+	{
+	public:
+
+		typedef std::shared_ptr<pointcloud::PointcloudChunk<ElementType>> ChunkPtr;
+
+		/**
+			Constructor, opens the file and reads the header
+
+			@param[in] file Name of the file
+		*/
+		PlyChunkReader(char* file) : ply(nullptr), number_of_vertices(0), color_spec(0), normal_flag(false),
+			chunk_size(0), sequence(0), first(0), values(0), point_index(0), color_index(0), normal_index(0)
+		{
+			ply = ply_open(file, NULL, 0, NULL);
+			if (!ply) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			if (!ply_read_header(ply)) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			/**
+				Iterate over all elements and properties in the header
+			*/
+			p_ply_element elem = ply_get_next_element(ply, NULL);
+			while (elem) {
+				const char *elem_name;
+				long elem_instances;
+				ply_get_element_info(elem, &elem_name, &elem_instances);
+
+				if (std::strcmp("vertex", elem_name) == 0) {
+					number_of_vertices = (size_t) elem_instances;
+
+					p_ply_property prop = ply_get_next_property(elem, NULL);
+					while (prop) {
+						const char *prop_name;
+						e_ply_type type, length_type, value_type;
+						ply_get_property_info(prop, &prop_name, &type, &length_type, &value_type);
+
+						if (!strcmp(prop_name, "nx")) { normal_flag = true; }
+						if (!strcmp(prop_name, "diffuse_red")) { color_spec = 1; }
+						if (!strcmp(prop_name, "red")) { color_spec = 2; }
+
+						prop = ply_get_next_property(elem, prop);
+					}
+				}
+
+				elem = ply_get_next_element(ply, elem);
+			}
+		}
+
+		/**
+			Destructor, closes the file
+		*/
+		~PlyChunkReader()
+		{
+			if (ply) {
+				ply_close(ply);
+			}
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		PlyChunkReader(const PlyChunkReader<ElementType>&) = delete;
+
+		/**
+			Operator =, deleted
+		*/
+		PlyChunkReader& operator=(const PlyChunkReader<ElementType>&) = delete;
+
+		/**
+			Get the number of vertices in the file
+
+			@return Number of vertices
+		*/
+		size_t getNumberOfVertices() const
+		{
+			return number_of_vertices;
+		}
+
+		/**
+			Returns true if the file contains colors
+
+			@return True if the file contains colors
+		*/
+		bool isColor() const
+		{
+			return color_spec > 0;
+		}
+
+		/**
+			Returns true if the file contains normals
+
+			@return True if the file contains normals
+		*/
+		bool isNormal() const
+		{
+			return normal_flag;
+		}
+
+		/**
+			Reads the vertices and passes them in chunks to a function
+
+			@param[in] chunk_size_ Number of vertices per chunk
+			@param[in] function_ Function which is invoked with every chunk in the order of the 
+				file, the reading is aborted if it returns false
+			@return Returns true if the reading was successful
+		*/
+		bool read(size_t chunk_size_, const std::function<bool(ChunkPtr)>& function_)
+		{
+			chunk_size = std::max<size_t>(1, chunk_size_);
+			function = function_;
+
+			ply_set_read_cb(ply, "vertex", "x", callbackChunk, this, 1);
+			ply_set_read_cb(ply, "vertex", "y", callbackChunk, this, 1);
+			ply_set_read_cb(ply, "vertex", "z", callbackChunk, this, 1);
+
+			if (color_spec == 1) {
+				ply_set_read_cb(ply, "vertex", "diffuse_red", callbackChunk, this, 2);
+				ply_set_read_cb(ply, "vertex", "diffuse_green", callbackChunk, this, 2);
+				ply_set_read_cb(ply, "vertex", "diffuse_blue", callbackChunk, this, 2);
+			}
+
+			if (color_spec == 2) {
+				ply_set_read_cb(ply, "vertex", "red", callbackChunk, this, 2);
+				ply_set_read_cb(ply, "vertex", "green", callbackChunk, this, 2);
+				ply_set_read_cb(ply, "vertex", "blue", callbackChunk, this, 2);
+			}
+
+			if (normal_flag) {
+				ply_set_read_cb(ply, "vertex", "nx", callbackChunk, this, 3);
+				ply_set_read_cb(ply, "vertex", "ny", callbackChunk, this, 3);
+				ply_set_read_cb(ply, "vertex", "nz", callbackChunk, this, 3);
+			}
+
+			bool result = ply_read(ply) != 0;
+
+			ply_close(ply);
+			ply = nullptr;
+
+			return result;
+		}
+
+	private:
+
+		/**
+			Callback function which inserts points, color and normals in the current chunk
+
+			@param[in] argument Argument which contains the reader
+			@return Returns false if the reading shall be aborted
+		*/
+		static int callbackChunk(p_ply_argument argument)
+		{
+			long index;
+			PlyChunkReader<ElementType>* reader;
+			ply_get_argument_user_data(argument, (void**)&reader, &index);
+
+			return reader->setValue(index, ply_get_argument_value(argument)) ? 1 : 0;
+		}
+
+		/**
+			Inserts a value in the current chunk and passes the chunk on when it is complete
+
+			@param[in] index_ Type of the value
+			@param[in] value_ Value
+			@return Returns false if the reading shall be aborted
+		*/
+		bool setValue(long index_, double value_)
+		{
+			if (!chunk) {
+				size_t rows = std::min(chunk_size, number_of_vertices - first);
+				chunk = std::make_shared<pointcloud::PointcloudChunk<ElementType>>(sequence, first, rows, 
+					isColor(), isNormal());
+			}
+
+			switch (index_) {
+			case 1:
+				chunk->points.getPtr()[point_index++] = (ElementType)value_;
+				break;
+			case 2:
+				chunk->colors.getPtr()[color_index++] = (uint8_t)value_;
+				break;
+			case 3:
+				chunk->normals.getPtr()[normal_index++] = (ElementType)value_;
+				break;
+			default:
+				break;
+			}
+			values++;
+
+			size_t values_per_vertex = 3 + (isColor() ? 3 : 0) + (isNormal() ? 3 : 0);
+			if (values < values_per_vertex * chunk->getRows()) {
+				return true;
+			}
+
+			/**
+				The chunk is complete
+			*/
+			ChunkPtr complete = chunk;
+			chunk.reset();
+			first += complete->getRows();
+			sequence++;
+			values = point_index = color_index = normal_index = 0;
+
+			return function(complete);
+		}
+
+		/**
+			Ply file
+		*/
+		p_ply ply;
+
+		/**
+			Number of vertices in the file
+		*/
+		size_t number_of_vertices;
+
+		/**
+			Specification of the colors, 0 if there are no colors
+		*/
+		uint8_t color_spec;
+
+		/**
+			Flag whether the file contains normals
+		*/
+		bool normal_flag;
+
+		/**
+			Number of vertices per chunk
+		*/
+		size_t chunk_size;
+
+		/**
+			Function which is invoked with every chunk
+		*/
+		std::function<bool(ChunkPtr)> function;
+
+		/**
+			Chunk which is read
+		*/
+		ChunkPtr chunk;
+
+		/**
+			Number of the current chunk
+		*/
+		size_t sequence;
+
+		/**
+			Index of the first vertex of the current chunk
+		*/
+		size_t first;
+
+		/**
+			Number of values which have been read into the current chunk
+		*/
+		size_t values;
+
+		/**
+			Positions in the channels of the current chunk
+		*/
+		size_t point_index, color_index, normal_index;
+	};
+
+	/**
+		Writes a ply file chunk by chunk, the number of vertices has to be known in advance
+	*/
+	template<typename ElementType>
+	class PlyChunkWriter
+	{
+	public:
+
+		/**
+			Constructor, creates the file and writes the header
+
+			@param[in] file Name of the file
+			@param[in] number_of_vertices Number of vertices which will be written
+			@param[in] color_flag Flag whether colors will be written
+			@param[in] normal_flag Flag whether normals will be written
+		*/
+		PlyChunkWriter(char* file, size_t number_of_vertices, bool color_flag, bool normal_flag) :
+			ply(nullptr), color_flag_(color_flag), normal_flag_(normal_flag)
+		{
+			ply = ply_create(file, PLY_ASCII, NULL, 0, NULL);
+			if (!ply) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			e_ply_type ply_type = std::is_same<ElementType, float>::value ? PLY_FLOAT32 : PLY_FLOAT64;
+
+			ply_add_element(ply, "vertex", (long)number_of_vertices);
+			ply_add_property(ply, "x", ply_type, ply_type, ply_type);
+			ply_add_property(ply, "y", ply_type, ply_type, ply_type);
+			ply_add_property(ply, "z", ply_type, ply_type, ply_type);
+
+			if (color_flag_) {
+				ply_add_property(ply, "red", PLY_UCHAR, PLY_UCHAR, PLY_UCHAR);
+				ply_add_property(ply, "green", PLY_UCHAR, PLY_UCHAR, PLY_UCHAR);
+				ply_add_property(ply, "blue", PLY_UCHAR, PLY_UCHAR, PLY_UCHAR);
+			}
+
+			if (normal_flag_) {
+				ply_add_property(ply, "nx", ply_type, ply_type, ply_type);
+				ply_add_property(ply, "ny", ply_type, ply_type, ply_type);
+				ply_add_property(ply, "nz", ply_type, ply_type, ply_type);
+			}
+
+			ply_write_header(ply);
+		}
+
+		/**
+			Destructor, closes the file
+		*/
+		~PlyChunkWriter()
+		{
+			close();
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		PlyChunkWriter(const PlyChunkWriter<ElementType>&) = delete;
+
+		/**
+			Operator =, deleted
+		*/
+		PlyChunkWriter& operator=(const PlyChunkWriter<ElementType>&) = delete;
+
+		/**
+			Writes the own vertices of a chunk, the chunks have to be written in order
+
+			@param[in] chunk Chunk
+		*/
+		void write(const pointcloud::PointcloudChunk<ElementType>& chunk)
+		{
+			for (size_t i = chunk.getBegin(); i < chunk.getEnd(); i++) {
+				for (size_t j = 0; j < 3; j++) {
+					ply_write(ply, chunk.points[i][j]);
+				}
+				if (color_flag_) {
+					for (size_t j = 0; j < 3; j++) {
+						ply_write(ply, chunk.color_flag ? chunk.colors[i][j] : 0);
+					}
+				}
+				if (normal_flag_) {
+					for (size_t j = 0; j < 3; j++) {
+						ply_write(ply, chunk.normal_flag ? chunk.normals[i][j] : 0);
+					}
+				}
+			}
+		}
+
+		/**
+			Closes the file
+		*/
+		void close()
+		{
+			if (ply) {
+				ply_close(ply);
+				ply = nullptr;
+			}
+		}
+
+	private:
+
+		/**
+			Ply file
+		*/
+		p_ply ply;
+
+		/**
+			Flag whether colors are written
+		*/
+		bool color_flag_;
+
+		/**
+			Flag whether normals are written
+		*/
+		bool normal_flag_;
+	};
 }
 
 #endif /* IO_IOPLY_H_ */
\ No newline at end of file
@@ -31,9 +31,11 @@
 #define INCLUDE_MATH_H_
 
 #include "math/adjustment.h"
+#include "math/batchsolver.h"
 #include "math/standard.h"
 #include "math/function.h"
 #include "math/pca.h"
+#include "math/solver.h"
 #include "math/zero.h"
 
 #endif /* INCLUDE_MATH_H_ */
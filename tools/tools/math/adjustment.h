@@ -57,6 +57,31 @@ namespace math
 		}
 	}
 
+	/**
+		Build one row of the design matrix for a three dimensional polynom, see 
+		buildDesignMatrixPolynomial3D
+
+		@param[in] x First coordinate
+		@param[in] y Second coordinate
+		@param[in,out] row Row of ((degree + 2) * (degree + 1)) / 2 elements
+		@param[in] degree The polynomial degree
+	*/
+	template<typename ElementType> void buildDesignRowPolynomial3D(
+		ElementType x,
+		ElementType y,
+		ElementType* row,
+		size_t degree)
+	{
+		size_t index = ((degree + 2) * (degree + 1)) / 2 - 1;
+		for (size_t j = 0; j <= degree; j++) {
+			for (size_t k = 0; k <= j; k++) {
+				size_t l = j - k;
+				row[index] = std::pow(x, k) * std::pow(y, l);
+				index--;
+			}
+		}
+	}
+
 	/**
 		Build the desgin matrix for a three dimensional polynom
 		 x^n +x^n-1y + ... + xy^n-1+ y^n + ... + x^2 + xy + y^2 + x + y + 1
@@ -73,14 +98,7 @@ namespace math
 		size_t number_of_parameter = ((degree + 2) * (degree + 1)) / 2;
 		design_matrix.setMatrix(data.getRows(), number_of_parameter);
 		for (size_t i = 0; i < data.getRows(); i++) {
-			size_t index = number_of_parameter - 1;
-			for (size_t j = 0; j <= degree; j++) {
-				for (size_t k = 0; k <= j; k++) {
-					size_t l = j - k;
-					design_matrix[i][index] = std::pow(data[i][0], k) * std::pow(data[i][1], l);
-					index--;
-				}
-			}
+			buildDesignRowPolynomial3D(data[i][0], data[i][1], design_matrix[i], degree);
 		}
 	}
 }
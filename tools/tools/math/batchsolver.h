@@ -0,0 +1,409 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef MATH_BATCHSOLVER_H_
+#define MATH_BATCHSOLVER_H_
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "tools/utils/alignedmemory.h"
+#include "tools/utils/matrix.h"
+#include "tools/utils/parallel.h"
+
+#include "tools/math/solver.h"
+
+namespace math
+{
+	/**
+		Solves many small weighted least squares problems min |P^(1/2)(Ax - l)| with the same 
+		number of unknowns at once. The design matrices are stored interleaved, the problems of 
+		a block lie next to each other in memory like the lanes of a vector register, so that 
+		the normal equations and their Cholesky decompositions are computed for all problems of a
+		block with vectorized loops. Problems with less observations than the maximum keep zero 
+		weights in the remaining rows. Problems whose normal equations are not numerically 
+		positive definite are solved again with solveNormalEquations and, if the normal equations
+		are singular, with the QR decomposition of the weighted design matrix.
+	*/
+	template<typename ElementType> class BatchedLeastSquares
+	{
+	public:
+
+		/**
+			Number of problems of a block, one vector register of UTILS_ALIGNMENT bytes
+		*/
+		static const size_t lanes = UTILS_ALIGNMENT / sizeof(ElementType);
+
+		/**
+			Constructor
+
+			@param[in] number_of_problems Number of problems
+			@param[in] number_of_observations Maximal number of observations of a problem
+			@param[in] number_of_unknowns Number of unknowns of every problem
+		*/
+		BatchedLeastSquares(size_t number_of_problems, size_t number_of_observations, size_t number_of_unknowns) :
+			number_of_problems_(number_of_problems),
+			number_of_observations_(number_of_observations),
+			number_of_unknowns_(number_of_unknowns),
+			number_of_blocks_((number_of_problems + lanes - 1) / lanes),
+			design_(number_of_blocks_ * number_of_observations, (number_of_unknowns + 2) * lanes)
+		{
+		}
+
+		/**
+			Sets the weights of all observations to zero
+		*/
+		void reset()
+		{
+			design_.reset();
+		}
+
+		/**
+			Sets one observation of a problem
+
+			@param[in] problem Index of the problem
+			@param[in] observation Index of the observation
+			@param[in] design_row Row of the design matrix with number_of_unknowns elements
+			@param[in] weight Weight of the observation
+			@param[in] value Observed value
+		*/
+		void setObservation(size_t problem, size_t observation, const ElementType* design_row, ElementType weight, ElementType value)
+		{
+			if (problem >= number_of_problems_ || observation >= number_of_observations_) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			ElementType* row = design_[(problem / lanes) * number_of_observations_ + observation] + problem % lanes;
+			for (size_t i = 0; i < number_of_unknowns_; i++) {
+				row[i * lanes] = design_row[i];
+			}
+			row[number_of_unknowns_ * lanes] = weight;
+			row[(number_of_unknowns_ + 1) * lanes] = value;
+		}
+
+		/**
+			Sets all observations of a problem, the remaining observations get zero weights
+
+			@param[in] problem Index of the problem
+			@param[in] design_matrix Design matrix A
+			@param[in] weights Weights as column vector
+			@param[in] observation Observations l as column vector
+		*/
+		template<typename Derived> void setProblem(
+			size_t problem,
+			const utils::Matrix<ElementType>& design_matrix,
+			const utils::Matrix<ElementType>& weights,
+			const utils::MatrixExpression<Derived, ElementType>& observation)
+		{
+			const Derived& l = observation.derived();
+
+			const size_t rows = design_matrix.getRows();
+			if (rows > number_of_observations_ || design_matrix.getCols() != number_of_unknowns_ || 
+				weights.getRows() != rows || l.getRows() != rows || l.getCols() != 1) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			for (size_t i = 0; i < rows; i++) {
+				setObservation(problem, i, design_matrix[i], weights[i][0], l(i, 0));
+			}
+			for (size_t i = rows; i < number_of_observations_; i++) {
+				design_[(problem / lanes) * number_of_observations_ + i][number_of_unknowns_ * lanes + problem % lanes] = 0;
+			}
+		}
+
+		/**
+			Solves all problems, the coefficients of a problem are stored in one row of the result
+
+			@param[in,out] coefficients Matrix with number_of_problems rows and number_of_unknowns columns
+			@param[in] cores Maximal number of threads, no limit if zero
+		*/
+		void solve(utils::Matrix<ElementType>& coefficients, size_t cores = 0) const
+		{
+			if (coefficients.getRows() != number_of_problems_ || coefficients.getCols() != number_of_unknowns_) {
+				coefficients = utils::Matrix<ElementType>::uninitialized(number_of_problems_, number_of_unknowns_);
+			}
+
+			const size_t entries = number_of_unknowns_ * (number_of_unknowns_ + 1);
+			utils::parallel_for(0, number_of_blocks_, 1, [&](size_t begin_, size_t end_) {
+				utils::Matrix<ElementType> system = utils::Matrix<ElementType>::uninitialized(entries, lanes);
+				utils::Matrix<ElementType> original = utils::Matrix<ElementType>::uninitialized(entries, lanes);
+				for (size_t block = begin_; block < end_; block++) {
+					solveBlock(block, system, original, coefficients);
+				}
+			}, cores);
+		}
+
+		/**
+			Get the number of problems
+
+			@return Number of problems
+		*/
+		size_t getNumberOfProblems() const
+		{
+			return number_of_problems_;
+		}
+
+		/**
+			Get the maximal number of observations of a problem
+
+			@return Number of observations
+		*/
+		size_t getNumberOfObservations() const
+		{
+			return number_of_observations_;
+		}
+
+		/**
+			Get the number of unknowns of a problem
+
+			@return Number of unknowns
+		*/
+		size_t getNumberOfUnknowns() const
+		{
+			return number_of_unknowns_;
+		}
+
+	private:
+
+		/**
+			Builds and solves the normal equations of all problems of a block, the augmented 
+			systems [A'PA | A'Pl] are stored interleaved with one row of lanes elements per entry
+
+			@param[in] block Index of the block
+			@param[in,out] system Workspace of the augmented systems
+			@param[in,out] original Workspace of the undecomposed augmented systems
+			@param[in,out] coefficients Result
+		*/
+		void solveBlock(
+			size_t block,
+			utils::Matrix<ElementType>& system,
+			utils::Matrix<ElementType>& original,
+			utils::Matrix<ElementType>& coefficients) const
+		{
+			const size_t n = number_of_unknowns_;
+			ElementType* c = utils::assumeAligned(system.getPtr());
+			auto entry = [c, n](size_t i, size_t j) { return c + (i * (n + 1) + j) * lanes; };
+
+			/**
+				Accumulate the upper triangle of A'PA and A'Pl
+			*/
+			system.reset();
+			for (size_t r = 0; r < number_of_observations_; r++) {
+				const ElementType* row = utils::assumeAligned(design_[block * number_of_observations_ + r]);
+				const ElementType* weight = row + n * lanes;
+				const ElementType* value = row + (n + 1) * lanes;
+
+				for (size_t i = 0; i < n; i++) {
+					ElementType weighted[lanes];
+					const ElementType* a_i = row + i * lanes;
+					for (size_t q = 0; q < lanes; q++) {
+						weighted[q] = weight[q] * a_i[q];
+					}
+					for (size_t j = i; j < n; j++) {
+						ElementType* c_ij = entry(i, j);
+						const ElementType* a_j = row + j * lanes;
+						for (size_t q = 0; q < lanes; q++) {
+							c_ij[q] += weighted[q] * a_j[q];
+						}
+					}
+					ElementType* c_il = entry(i, n);
+					for (size_t q = 0; q < lanes; q++) {
+						c_il[q] += weighted[q] * value[q];
+					}
+				}
+			}
+			std::memcpy(original.getPtr(), c, sizeof(ElementType) * n * (n + 1) * lanes);
+
+			/**
+				Cholesky decomposition A'PA = R'R in the upper triangle, the last column is 
+				transformed with R' at the same time, failed lanes continue with a unit pivot
+			*/
+			const ElementType epsilon = std::numeric_limits<ElementType>::epsilon() * n;
+			ElementType valid[lanes];
+			for (size_t q = 0; q < lanes; q++) {
+				valid[q] = 1;
+			}
+
+			for (size_t j = 0; j < n; j++) {
+				ElementType* c_jj = entry(j, j);
+				const ElementType* o_jj = original.getPtr() + (j * (n + 1) + j) * lanes;
+				for (size_t k = 0; k < j; k++) {
+					const ElementType* c_kj = entry(k, j);
+					for (size_t q = 0; q < lanes; q++) {
+						c_jj[q] -= c_kj[q] * c_kj[q];
+					}
+				}
+
+				ElementType inverse[lanes];
+				for (size_t q = 0; q < lanes; q++) {
+					const bool positive = c_jj[q] > epsilon * std::abs(o_jj[q]);
+					valid[q] = positive ? valid[q] : 0;
+					c_jj[q] = positive ? std::sqrt(c_jj[q]) : 1;
+					inverse[q] = 1 / c_jj[q];
+				}
+
+				for (size_t i = j + 1; i <= n; i++) {
+					ElementType* c_ji = entry(j, i);
+					for (size_t k = 0; k < j; k++) {
+						const ElementType* c_kj = entry(k, j);
+						const ElementType* c_ki = entry(k, i);
+						for (size_t q = 0; q < lanes; q++) {
+							c_ji[q] -= c_kj[q] * c_ki[q];
+						}
+					}
+					for (size_t q = 0; q < lanes; q++) {
+						c_ji[q] *= inverse[q];
+					}
+				}
+			}
+
+			/**
+				Solve Rx = y by back substitution, the solution replaces the last column
+			*/
+			for (size_t i = n; i-- > 0;) {
+				ElementType* c_il = entry(i, n);
+				for (size_t k = i + 1; k < n; k++) {
+					const ElementType* c_ik = entry(i, k);
+					const ElementType* c_kl = entry(k, n);
+					for (size_t q = 0; q < lanes; q++) {
+						c_il[q] -= c_ik[q] * c_kl[q];
+					}
+				}
+				const ElementType* c_ii = entry(i, i);
+				for (size_t q = 0; q < lanes; q++) {
+					c_il[q] /= c_ii[q];
+				}
+			}
+
+			/**
+				Store the coefficients, problems of failed lanes are solved separately
+			*/
+			for (size_t q = 0; q < lanes && block * lanes + q < number_of_problems_; q++) {
+				ElementType* result = coefficients[block * lanes + q];
+				if (valid[q]) {
+					for (size_t i = 0; i < n; i++) {
+						result[i] = entry(i, n)[q];
+					}
+				}
+				else {
+					solveLane(block, original, q, result);
+				}
+			}
+		}
+
+		/**
+			Solves the problem of one lane of a block with solveNormalEquations, if the normal 
+			equations are singular with solveWeightedLeastSquares
+
+			@param[in] block Index of the block
+			@param[in] original Undecomposed augmented systems of the block
+			@param[in] lane Lane of the problem
+			@param[in,out] result Coefficients, NaN if the design matrix has not full column rank
+		*/
+		void solveLane(size_t block, const utils::Matrix<ElementType>& original, size_t lane, ElementType* result) const
+		{
+			const size_t n = number_of_unknowns_;
+			utils::Matrix<ElementType> system = utils::Matrix<ElementType>::uninitialized(n, n + 1);
+			for (size_t i = 0; i < n; i++) {
+				for (size_t j = i; j <= n; j++) {
+					system[i][j] = original.getPtr()[(i * (n + 1) + j) * lanes + lane];
+				}
+				for (size_t j = 0; j < i; j++) {
+					system[i][j] = system[j][i];
+				}
+			}
+
+			utils::Matrix<ElementType> solution;
+			if (solveNormalEquations(system, solution)) {
+				std::memcpy(result, solution.getPtr(), sizeof(ElementType) * n);
+				return;
+			}
+
+			/**
+				Gather the design matrix, weights and observations of the lane
+			*/
+			const size_t m = number_of_observations_;
+			utils::Matrix<ElementType> design_matrix = utils::Matrix<ElementType>::uninitialized(m, n);
+			utils::Matrix<ElementType> weights = utils::Matrix<ElementType>::uninitialized(m, 1);
+			utils::Matrix<ElementType> observation = utils::Matrix<ElementType>::uninitialized(m, 1);
+			for (size_t r = 0; r < m; r++) {
+				const ElementType* row = design_[block * m + r] + lane;
+				for (size_t i = 0; i < n; i++) {
+					design_matrix[r][i] = row[i * lanes];
+				}
+				weights[r][0] = row[n * lanes];
+				observation[r][0] = row[(n + 1) * lanes];
+			}
+
+			static thread_local SolverWorkspace<ElementType> workspace;
+			if (m >= n && solveWeightedLeastSquares(design_matrix, weights, observation, solution, workspace)) {
+				std::memcpy(result, solution.getPtr(), sizeof(ElementType) * n);
+			}
+			else {
+				for (size_t i = 0; i < n; i++) {
+					result[i] = std::numeric_limits<ElementType>::quiet_NaN();
+				}
+			}
+		}
+
+		/**
+			Number of problems
+		*/
+		size_t number_of_problems_;
+
+		/**
+			Maximal number of observations of a problem
+		*/
+		size_t number_of_observations_;
+
+		/**
+			Number of unknowns of a problem
+		*/
+		size_t number_of_unknowns_;
+
+		/**
+			Number of blocks of lanes problems
+		*/
+		size_t number_of_blocks_;
+
+		/**
+			Interleaved design matrices, weights and observations. Row block * number_of_observations 
+			+ r holds the r-th observation of all problems of the block, entry e of problem p is 
+			stored at column e * lanes + p % lanes, the entries number_of_unknowns and 
+			number_of_unknowns + 1 are the weight and the observed value.
+		*/
+		utils::Matrix<ElementType> design_;
+	};
+}
+
+#endif /* MATH_BATCHSOLVER_H_ */
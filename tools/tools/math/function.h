@@ -91,6 +91,30 @@ namespace math
 		return utils::Matrix<ElementType>(euclideanDistance<ElementType>(matrix.getPtr(), matrix.getRows(), matrix.getCols()), matrix.getRows(),1);
 	}
 
+	/**
+		Computes the length of several vectors with dimension dim, the expression is evaluated
+		while computing the lengths
+
+		@param[in] expression Matrix expression with the vectors
+		@return Container with the length of the vectors
+	*/
+	template<typename ElementType, typename Derived> utils::Matrix<ElementType> euclideanDistance(const utils::MatrixExpression<Derived, ElementType>& expression)
+	{
+		const Derived& matrix = expression.derived();
+
+		utils::Matrix<ElementType> result(matrix.getRows(), 1);
+		for (size_t row = 0; row < matrix.getRows(); row++) {
+			ElementType length = ElementType();
+			for (size_t col = 0; col < matrix.getCols(); col++) {
+				ElementType value = matrix(row, col);
+				length += value * value;
+			}
+			result[row][0] = length;
+		}
+
+		return result;
+	}
+
 	/**
 		Computes the distance between vector a and vector b
 
@@ -0,0 +1,457 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef MATH_SOLVER_H_
+#define MATH_SOLVER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tools/utils/matrix.h"
+
+namespace math
+{
+	/**
+		Computes the Cholesky decomposition A = LL' of a symmetric positive definite matrix in 
+		place, only the lower triangle is read and overwritten with L
+
+		@param[in,out] a Row-array of the matrix
+		@param[in] n Number of rows and columns
+		@param[in] lda Number of elements between two rows
+		@return False if the matrix is not numerically positive definite
+	*/
+	template<typename ElementType> bool choleskyDecomposition(ElementType* a, size_t n, size_t lda)
+	{
+		const ElementType epsilon = std::numeric_limits<ElementType>::epsilon() * n;
+
+		for (size_t j = 0; j < n; j++) {
+			ElementType* a_j = a + j * lda;
+
+			ElementType sum = a_j[j];
+			for (size_t k = 0; k < j; k++) {
+				sum -= a_j[k] * a_j[k];
+			}
+			if (!(sum > epsilon * std::abs(a_j[j]))) {
+				return false;
+			}
+			a_j[j] = std::sqrt(sum);
+
+			for (size_t i = j + 1; i < n; i++) {
+				ElementType* a_i = a + i * lda;
+				ElementType value = a_i[j];
+				for (size_t k = 0; k < j; k++) {
+					value -= a_i[k] * a_j[k];
+				}
+				a_i[j] = value / a_j[j];
+			}
+		}
+
+		return true;
+	}
+
+	/**
+		Solves LL'x = b with the factor of choleskyDecomposition in place
+
+		@param[in] l Row-array of the factor
+		@param[in] n Number of rows and columns
+		@param[in] lda Number of elements between two rows of the factor
+		@param[in,out] b Right hand side, overwritten with the solution
+		@param[in] incb Number of elements between two entries of the right hand side
+	*/
+	template<typename ElementType> void choleskySolve(const ElementType* l, size_t n, size_t lda, ElementType* b, size_t incb = 1)
+	{
+		for (size_t i = 0; i < n; i++) {
+			const ElementType* l_i = l + i * lda;
+			ElementType value = b[i * incb];
+			for (size_t k = 0; k < i; k++) {
+				value -= l_i[k] * b[k * incb];
+			}
+			b[i * incb] = value / l_i[i];
+		}
+
+		for (size_t i = n; i-- > 0;) {
+			const ElementType* l_i = l + i * lda;
+			b[i * incb] /= l_i[i];
+			for (size_t k = 0; k < i; k++) {
+				b[k * incb] -= l_i[k] * b[i * incb];
+			}
+		}
+	}
+
+	/**
+		Computes the decomposition A = LDL' of a symmetric matrix in place without square roots, 
+		the strict lower triangle is overwritten with the unit triangular L and the diagonal with D
+
+		@param[in,out] a Row-array of the matrix
+		@param[in] n Number of rows and columns
+		@param[in] lda Number of elements between two rows
+		@return False if a pivot vanishes
+	*/
+	template<typename ElementType> bool ldltDecomposition(ElementType* a, size_t n, size_t lda)
+	{
+		const ElementType epsilon = std::numeric_limits<ElementType>::epsilon() * n;
+
+		for (size_t j = 0; j < n; j++) {
+			ElementType* a_j = a + j * lda;
+
+			ElementType d = a_j[j];
+			for (size_t k = 0; k < j; k++) {
+				d -= a_j[k] * a_j[k] * a[k * lda + k];
+			}
+			if (!(std::abs(d) > epsilon * std::abs(a_j[j]))) {
+				return false;
+			}
+			a_j[j] = d;
+
+			for (size_t i = j + 1; i < n; i++) {
+				ElementType* a_i = a + i * lda;
+				ElementType value = a_i[j];
+				for (size_t k = 0; k < j; k++) {
+					value -= a_i[k] * a_j[k] * a[k * lda + k];
+				}
+				a_i[j] = value / d;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+		Solves LDL'x = b with the factors of ldltDecomposition in place
+
+		@param[in] ld Row-array of the factors
+		@param[in] n Number of rows and columns
+		@param[in] lda Number of elements between two rows of the factors
+		@param[in,out] b Right hand side, overwritten with the solution
+		@param[in] incb Number of elements between two entries of the right hand side
+	*/
+	template<typename ElementType> void ldltSolve(const ElementType* ld, size_t n, size_t lda, ElementType* b, size_t incb = 1)
+	{
+		for (size_t i = 0; i < n; i++) {
+			const ElementType* ld_i = ld + i * lda;
+			ElementType value = b[i * incb];
+			for (size_t k = 0; k < i; k++) {
+				value -= ld_i[k] * b[k * incb];
+			}
+			b[i * incb] = value;
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			b[i * incb] /= ld[i * lda + i];
+		}
+
+		for (size_t i = n; i-- > 0;) {
+			const ElementType* ld_i = ld + i * lda;
+			for (size_t k = 0; k < i; k++) {
+				b[k * incb] -= ld_i[k] * b[i * incb];
+			}
+		}
+	}
+
+	/**
+		Computes the Householder QR decomposition of a matrix with at least as many rows as columns
+		in place. R is stored in the upper triangle, the Householder vectors below the diagonal 
+		with an implicit one on the diagonal.
+
+		@param[in,out] a Row-array of the matrix
+		@param[in] rows Number of rows
+		@param[in] cols Number of columns
+		@param[in] lda Number of elements between two rows
+		@param[out] tau Scaling factors of the Householder reflections, cols elements
+		@param[in] work Workspace of cols elements
+	*/
+	template<typename ElementType> void qrDecomposition(ElementType* a, size_t rows, size_t cols, size_t lda, ElementType* tau, ElementType* work)
+	{
+		if (rows < cols) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		for (size_t j = 0; j < cols; j++) {
+			ElementType* a_j = a + j * lda;
+
+			/**
+				Compute the reflection which annihilates the column below the diagonal
+			*/
+			ElementType norm = 0;
+			for (size_t i = j + 1; i < rows; i++) {
+				norm += a[i * lda + j] * a[i * lda + j];
+			}
+			if (norm == 0) {
+				tau[j] = 0;
+				continue;
+			}
+			norm = std::sqrt(norm + a_j[j] * a_j[j]);
+
+			ElementType beta = a_j[j] >= 0 ? -norm : norm;
+			ElementType scale = 1 / (a_j[j] - beta);
+			for (size_t i = j + 1; i < rows; i++) {
+				a[i * lda + j] *= scale;
+			}
+			tau[j] = (beta - a_j[j]) / beta;
+			a_j[j] = beta;
+
+			/**
+				Apply the reflection to the remaining columns row by row, w = v'A and A -= tau v w'
+			*/
+			for (size_t k = j + 1; k < cols; k++) {
+				work[k] = a_j[k];
+			}
+			for (size_t i = j + 1; i < rows; i++) {
+				ElementType* a_i = a + i * lda;
+				ElementType v = a_i[j];
+				for (size_t k = j + 1; k < cols; k++) {
+					work[k] += v * a_i[k];
+				}
+			}
+			for (size_t k = j + 1; k < cols; k++) {
+				work[k] *= tau[j];
+				a_j[k] -= work[k];
+			}
+			for (size_t i = j + 1; i < rows; i++) {
+				ElementType* a_i = a + i * lda;
+				ElementType v = a_i[j];
+				for (size_t k = j + 1; k < cols; k++) {
+					a_i[k] -= v * work[k];
+				}
+			}
+		}
+	}
+
+	/**
+		Solves the least squares problem min |Ax - b| with the factors of qrDecomposition in place
+
+		@param[in] qr Row-array of the factors
+		@param[in] rows Number of rows
+		@param[in] cols Number of columns
+		@param[in] lda Number of elements between two rows of the factors
+		@param[in] tau Scaling factors of the Householder reflections
+		@param[in,out] b Right hand side of rows elements, the first cols elements are overwritten 
+			with the solution
+		@return False if R is numerically singular, i.e. a diagonal element is not greater than 
+			epsilon * max(rows, cols) * max |R_jj|
+	*/
+	template<typename ElementType> bool qrSolve(const ElementType* qr, size_t rows, size_t cols, size_t lda, const ElementType* tau, ElementType* b)
+	{
+		/**
+			The matrix has not full column rank if a diagonal element of R vanishes relative to 
+			the largest one, rounding errors prevent exact zeros
+		*/
+		ElementType diagonal = 0;
+		for (size_t j = 0; j < cols; j++) {
+			diagonal = std::max(diagonal, std::abs(qr[j * lda + j]));
+		}
+		const ElementType tolerance = std::numeric_limits<ElementType>::epsilon() * std::max(rows, cols) * diagonal;
+		for (size_t j = 0; j < cols; j++) {
+			if (!(std::abs(qr[j * lda + j]) > tolerance)) {
+				return false;
+			}
+		}
+
+		/**
+			Apply Q' to the right hand side
+		*/
+		for (size_t j = 0; j < cols; j++) {
+			ElementType value = b[j];
+			for (size_t i = j + 1; i < rows; i++) {
+				value += qr[i * lda + j] * b[i];
+			}
+			value *= tau[j];
+			b[j] -= value;
+			for (size_t i = j + 1; i < rows; i++) {
+				b[i] -= qr[i * lda + j] * value;
+			}
+		}
+
+		/**
+			Solve Rx = Q'b by back substitution
+		*/
+		for (size_t i = cols; i-- > 0;) {
+			const ElementType* qr_i = qr + i * lda;
+			ElementType value = b[i];
+			for (size_t k = i + 1; k < cols; k++) {
+				value -= qr_i[k] * b[k];
+			}
+			b[i] = value / qr_i[i];
+		}
+
+		return true;
+	}
+
+	/**
+		Buffers of the solvers which are reused as long as the size of the problem does not change
+	*/
+	template<typename ElementType> class SolverWorkspace
+	{
+	public:
+
+		/**
+			Resizes the buffers for a problem with a certain number of rows and columns
+
+			@param[in] rows Number of rows
+			@param[in] cols Number of columns
+		*/
+		void reserve(size_t rows, size_t cols)
+		{
+			if (matrix.getRows() != rows || matrix.getCols() != cols) {
+				matrix = utils::Matrix<ElementType>::uninitialized(rows, cols);
+				vector = utils::Matrix<ElementType>::uninitialized(rows, 1);
+			}
+			if (tau.getRows() != cols) {
+				tau = utils::Matrix<ElementType>::uninitialized(cols, 1);
+				work = utils::Matrix<ElementType>::uninitialized(cols, 1);
+			}
+		}
+
+		/**
+			Matrix which is decomposed
+		*/
+		utils::Matrix<ElementType> matrix;
+
+		/**
+			Right hand side
+		*/
+		utils::Matrix<ElementType> vector;
+
+		/**
+			Scaling factors of the Householder reflections
+		*/
+		utils::Matrix<ElementType> tau;
+
+		/**
+			Workspace of the decomposition
+		*/
+		utils::Matrix<ElementType> work;
+	};
+
+	/**
+		Solves the normal equations (A'PA)x = A'Pl in place, the system is given as augmented 
+		matrix [A'PA | A'Pl] like it is returned by utils::normalEquations. The Cholesky 
+		decomposition is used and the LDL' decomposition if the matrix is not numerically positive
+		definite.
+
+		@param[in,out] system Augmented matrix, the lower triangle and the last column are 
+			overwritten with the decomposition and the solution
+		@param[out] solution Solution
+		@return False if the system is singular
+	*/
+	template<typename ElementType> bool solveNormalEquations(utils::Matrix<ElementType>& system, utils::Matrix<ElementType>& solution)
+	{
+		const size_t n = system.getRows();
+		if (system.getCols() != n + 1) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		/**
+			The decompositions overwrite only the lower triangle, so the matrix can be restored from
+			the upper triangle and the saved diagonal
+		*/
+		solution = utils::Matrix<ElementType>::uninitialized(n, 1);
+		ElementType* a = system.getPtr();
+		for (size_t i = 0; i < n; i++) {
+			solution[i][0] = a[i * (n + 1) + i];
+		}
+
+		ElementType* rhs = a + n;
+		if (choleskyDecomposition(a, n, n + 1)) {
+			choleskySolve(a, n, n + 1, rhs, n + 1);
+		}
+		else {
+			for (size_t i = 0; i < n; i++) {
+				for (size_t j = 0; j < i; j++) {
+					a[i * (n + 1) + j] = a[j * (n + 1) + i];
+				}
+				a[i * (n + 1) + i] = solution[i][0];
+			}
+			if (!ldltDecomposition(a, n, n + 1)) {
+				return false;
+			}
+			ldltSolve(a, n, n + 1, rhs, n + 1);
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			solution[i][0] = rhs[i * (n + 1)];
+		}
+
+		return true;
+	}
+
+	/**
+		Solves the weighted least squares problem min |P^(1/2)(Ax - l)| with the Householder QR 
+		decomposition of the weighted design matrix, without forming the normal equations
+
+		@param[in] design_matrix Design matrix A
+		@param[in] weights Weights as column vector
+		@param[in] observation Observations l as column vector
+		@param[out] solution Solution
+		@param[in,out] workspace Buffers of the solver
+		@return False if the weighted design matrix has not full column rank
+	*/
+	template<typename ElementType, typename Derived> bool solveWeightedLeastSquares(
+		const utils::Matrix<ElementType>& design_matrix,
+		const utils::Matrix<ElementType>& weights,
+		const utils::MatrixExpression<Derived, ElementType>& observation,
+		utils::Matrix<ElementType>& solution,
+		SolverWorkspace<ElementType>& workspace)
+	{
+		const Derived& l = observation.derived();
+
+		const size_t rows = design_matrix.getRows();
+		const size_t cols = design_matrix.getCols();
+		if (weights.getRows() != rows || l.getRows() != rows || l.getCols() != 1 || rows < cols) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		workspace.reserve(rows, cols);
+		for (size_t i = 0; i < rows; i++) {
+			const ElementType weight = std::sqrt(weights[i][0]);
+			const ElementType* a_i = design_matrix[i];
+			ElementType* m_i = workspace.matrix[i];
+			for (size_t j = 0; j < cols; j++) {
+				m_i[j] = weight * a_i[j];
+			}
+			workspace.vector[i][0] = weight * l(i, 0);
+		}
+
+		qrDecomposition(workspace.matrix.getPtr(), rows, cols, cols, workspace.tau.getPtr(), workspace.work.getPtr());
+		if (!qrSolve(workspace.matrix.getPtr(), rows, cols, cols, workspace.tau.getPtr(), workspace.vector.getPtr())) {
+			return false;
+		}
+
+		solution = utils::Matrix<ElementType>::uninitialized(cols, 1);
+		std::memcpy(solution.getPtr(), workspace.vector.getPtr(), sizeof(ElementType) * cols);
+
+		return true;
+	}
+}
+
+#endif /* MATH_SOLVER_H_ */
@@ -200,6 +200,90 @@ namespace math
 		return matrix;
 	}
 
+	/**
+		Type of an eigen map of a matrix view
+	*/
+	template<typename ElementType> struct EigenMatrixView
+	{
+		typedef Eigen::Map<Eigen::Matrix<ElementType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>, 
+			Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>> type;
+	};
+
+	/**
+		Maps a matrix view to an eigen matrix without copying the elements
+
+		@param[in] view Matrix view
+		@return Eigen map with the strides of the view
+	*/
+	template<typename ElementType> 
+	typename EigenMatrixView<ElementType>::type matrixViewToEigen(
+		const utils::MatrixView<ElementType>& view)
+	{
+		return typename EigenMatrixView<ElementType>::type(view.getPtr(), view.getRows(), view.getCols(),
+			Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(view.getRowStride(), view.getColStride()));
+	}
+
+	/**
+		Type of an eigen matrix with the size and the storage order of a fixed matrix
+	*/
+	template<typename ElementType, size_t Rows, size_t Cols> struct EigenFixedMatrix
+	{
+		typedef Eigen::Matrix<ElementType, (int)Rows, (int)Cols, 
+			(Cols == 1 && Rows != 1) ? Eigen::ColMajor : Eigen::RowMajor> type;
+	};
+
+	/**
+		Maps a fixed matrix to an eigen matrix without copying the elements
+
+		@param[in] matrix Fixed matrix
+		@return Eigen map
+	*/
+	template<typename ElementType, size_t Rows, size_t Cols>
+	Eigen::Map<typename EigenFixedMatrix<ElementType, Rows, Cols>::type> fixedMatrixToEigen(
+		utils::FixedMatrix<ElementType, Rows, Cols>& matrix)
+	{
+		return Eigen::Map<typename EigenFixedMatrix<ElementType, Rows, Cols>::type>(matrix.getPtr());
+	}
+
+	/**
+		Maps a fixed matrix to an eigen matrix without copying the elements
+
+		@param[in] matrix Fixed matrix
+		@return Eigen map
+	*/
+	template<typename ElementType, size_t Rows, size_t Cols>
+	Eigen::Map<const typename EigenFixedMatrix<ElementType, Rows, Cols>::type> fixedMatrixToEigen(
+		const utils::FixedMatrix<ElementType, Rows, Cols>& matrix)
+	{
+		return Eigen::Map<const typename EigenFixedMatrix<ElementType, Rows, Cols>::type>(matrix.getPtr());
+	}
+
+	/**
+		Converts an eigen matrix to a fixed matrix
+
+		@param[in] eigen Eigen matrix
+		@return Fixed matrix
+	*/
+	template<typename ElementType, size_t Rows, size_t Cols, typename Derived>
+	utils::FixedMatrix<ElementType, Rows, Cols> eigenToFixedMatrix(
+		const Eigen::MatrixBase<Derived>& eigen)
+	{
+		if (eigen.rows() != Rows || eigen.cols() != Cols) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		utils::FixedMatrix<ElementType, Rows, Cols> matrix;
+		for (size_t row = 0; row < Rows; row++)
+		{
+			for (size_t col = 0; col < Cols; col++)
+			{
+				matrix[row][col] = (ElementType) eigen(row, col);
+			}
+		}
+
+		return matrix;
+	}
+
 	/**
 		Computation of the mean of an array of data points
 
@@ -277,7 +361,7 @@ namespace math
 		/**
 			Computation of the variances and covariances
 		*/
-		return (data - mean.transpose()).transpose()*(data - mean.transpose()) / (data.getRows()-1);
+		return utils::transposeProduct<ElementType>(data - mean.transpose()) / (data.getRows()-1);
 	}
 
 	/**	
@@ -150,7 +150,13 @@ namespace math
 		*/
 		utils::Matrix<ElementType> operator()(const utils::Matrix<ElementType>& matrix) const
 		{
-			return utils::Matrix<ElementType>((*this)(matrix.getPtr(), matrix.getRows()), matrix.getRows(), 1);
+			utils::Matrix<ElementType> weights = utils::Matrix<ElementType>::uninitialized(matrix.getRows(), 1);
+			ElementType* weights_ptr = utils::assumeAligned(weights.getPtr());
+			for (size_t i = 0; i < matrix.getRows(); i++) {
+				weights_ptr[i] = (ElementType)1.0;
+			}
+
+			return weights;
 		}
 	};
 
@@ -271,7 +277,16 @@ namespace math
 		*/
 		utils::Matrix<ElementType> operator()(const utils::Matrix<ElementType>& matrix) const
 		{
-			 return utils::Matrix<ElementType>((*this)(matrix.getPtr(), matrix.getRows()), matrix.getRows(), 1);
+			utils::Matrix<ElementType> weights = utils::Matrix<ElementType>::uninitialized(matrix.getRows(), 1);
+			ElementType* weights_ptr = utils::assumeAligned(weights.getPtr());
+			const ElementType range = b_ - a_;
+
+			const ElementType* data = matrix.getPtr();
+			for (size_t i = 0; i < matrix.getRows(); i++) {
+				weights_ptr[i] = (b_ - data[i]) / range;
+			}
+
+			return weights;
 		}
 
 		/**
@@ -504,7 +519,19 @@ namespace math
 		*/
 		utils::Matrix<ElementType> operator()(const utils::Matrix<ElementType>& matrix) const
 		{
-			utils::Matrix<ElementType> weight(matrix.getRows(),1);
+			utils::Matrix<ElementType> weight = utils::Matrix<ElementType>::uninitialized(matrix.getRows(), 1);
+
+			if (dim_ == 1 && matrix.getCols() == 1) {
+				const ElementType* data = matrix.getPtr();
+				ElementType* weight_ptr = utils::assumeAligned(weight.getPtr());
+				const ElementType mean = mean_[0];
+				const ElementType denominator = 2 * var_[0];
+				for (size_t i = 0; i < matrix.getRows(); i++) {
+					weight_ptr[i] = std::exp(-(data[i] - mean) * (data[i] - mean) / denominator);
+				}
+
+				return weight;
+			}
 
 			for (size_t i = 0; i < matrix.getRows(); i++) {
 				weight[i][0] = (*this)(matrix[i]);
@@ -30,6 +30,7 @@
 #ifndef INCLUDE_POINTCLOUD_H_
 #define INCLUDE_POINTCLOUD_H_
 
+#include "pointcloud/chunk.h"
 #include "pointcloud/features.h"
 #include "pointcloud/normals.h"
 #include "pointcloud/surface.h"
@@ -38,5 +39,6 @@
 #include "pointcloud/pointcloudsoa.h"
 #include "pointcloud/pointcloudnodes.h"
 #include "pointcloud/quaterion.h"
+#include "pointcloud/reorder.h"
 
 #endif /* INCLUDE_POINTCLOUD_H_ */
\ No newline at end of file
@@ -0,0 +1,298 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef POINTCLOUD_CHUNK_H_
+#define POINTCLOUD_CHUNK_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "tools/utils/matrix.h"
+
+namespace pointcloud
+{
+	/**
+		Consecutive vertices of a pointcloud which are processed as one element of a pipeline. For
+		neighborhood computations the chunk is extended by halo vertices of the preceding and the
+		following chunk, which are used as neighbors but belong to the other chunks.
+	*/
+	template<typename ElementType>
+	struct PointcloudChunk
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] sequence_ Number of the chunk
+			@param[in] first_ Index of the first own vertex in the entire pointcloud
+			@param[in] rows_ Number of vertices including the halo
+			@param[in] color_flag_ Flag whether the chunk contains colors
+			@param[in] normal_flag_ Flag whether the chunk contains normals
+		*/
+		PointcloudChunk(size_t sequence_, size_t first_, size_t rows_, bool color_flag_, bool normal_flag_) :
+			sequence(sequence_), first(first_), halo_before(0), halo_after(0),
+			points(rows_, 3), 
+			colors(color_flag_ ? rows_ : 0, 3), 
+			normals(normal_flag_ ? rows_ : 0, 3),
+			color_flag(color_flag_), normal_flag(normal_flag_)
+		{
+		}
+
+		/**
+			Get the number of own vertices
+
+			@return Number of own vertices
+		*/
+		size_t getNumberOfVertices() const
+		{
+			return points.getRows() - halo_before - halo_after;
+		}
+
+		/**
+			Get the number of vertices including the halo
+
+			@return Number of vertices
+		*/
+		size_t getRows() const
+		{
+			return points.getRows();
+		}
+
+		/**
+			Get the row of the first own vertex
+
+			@return Row of the first own vertex
+		*/
+		size_t getBegin() const
+		{
+			return halo_before;
+		}
+
+		/**
+			Get the row behind the last own vertex
+
+			@return Row behind the last own vertex
+		*/
+		size_t getEnd() const
+		{
+			return points.getRows() - halo_after;
+		}
+
+		/**
+			Ensure assigning normals to the chunk
+		*/
+		void setNormals()
+		{
+			if (!normal_flag) {
+				normals.setMatrix(points.getRows(), 3);
+				normal_flag = true;
+			}
+		}
+
+		/**
+			Copies rows of another chunk into this chunk
+
+			@param[in] chunk_ Chunk
+			@param[in] row_ First row in chunk_
+			@param[in] rows_ Number of rows
+			@param[in] target_row_ First row in this chunk
+		*/
+		void copyRows(const PointcloudChunk<ElementType>& chunk_, size_t row_, size_t rows_, size_t target_row_)
+		{
+			std::memcpy(points[target_row_], chunk_.points[row_], sizeof(ElementType) * rows_ * 3);
+			if (color_flag && chunk_.color_flag) {
+				std::memcpy(colors[target_row_], chunk_.colors[row_], sizeof(uint8_t) * rows_ * 3);
+			}
+			if (normal_flag && chunk_.normal_flag) {
+				std::memcpy(normals[target_row_], chunk_.normals[row_], sizeof(ElementType) * rows_ * 3);
+			}
+		}
+
+		/**
+			Number of the chunk
+		*/
+		size_t sequence;
+
+		/**
+			Index of the first own vertex in the entire pointcloud
+		*/
+		size_t first;
+
+		/**
+			Number of halo vertices in front of the own vertices
+		*/
+		size_t halo_before;
+
+		/**
+			Number of halo vertices behind the own vertices
+		*/
+		size_t halo_after;
+
+		/**
+			Points
+		*/
+		utils::Matrix<ElementType> points;
+
+		/**
+			Colors
+		*/
+		utils::Matrix<uint8_t> colors;
+
+		/**
+			Normals
+		*/
+		utils::Matrix<ElementType> normals;
+
+		/**
+			Flag whether the chunk contains colors
+		*/
+		bool color_flag;
+
+		/**
+			Flag whether the chunk contains normals
+		*/
+		bool normal_flag;
+	};
+
+	/**
+		Extends a stream of consecutive chunks by halo vertices. A chunk is emitted as soon as its
+		successor has arrived, extended by the last vertices of its predecessor and the first 
+		vertices of its successor. The chunks have to arrive in order. The halo consists of the 
+		neighbors in the order of the stream, which are the spatial neighbors only if the 
+		vertices are ordered spatially.
+	*/
+	template<typename ElementType>
+	class HaloWindow
+	{
+	public:
+
+		typedef std::shared_ptr<PointcloudChunk<ElementType>> ChunkPtr;
+
+		/**
+			Constructor
+
+			@param[in] halo_ Maximal number of halo vertices on every side of a chunk
+		*/
+		HaloWindow(size_t halo_) : halo(halo_)
+		{
+		}
+
+		/**
+			Adds the next chunk and emits the previous one
+
+			@param[in] chunk_ Chunk without halo
+			@param[in] emit_ Function which is invoked with the extended chunk
+			@return False if emit_ returned false
+		*/
+		template<typename Function> bool push(ChunkPtr chunk_, const Function& emit_)
+		{
+			bool result = true;
+			if (current) {
+				result = emit_(extend(chunk_));
+			}
+
+			previous = current;
+			current = chunk_;
+
+			return result;
+		}
+
+		/**
+			Emits the last chunk
+
+			@param[in] emit_ Function which is invoked with the extended chunk
+			@return False if emit_ returned false
+		*/
+		template<typename Function> bool flush(const Function& emit_)
+		{
+			bool result = true;
+			if (current) {
+				result = emit_(extend(ChunkPtr()));
+			}
+
+			previous.reset();
+			current.reset();
+
+			return result;
+		}
+
+	private:
+
+		/**
+			Builds the current chunk extended by the halo of its neighbors
+
+			@param[in] next_ Successor of the current chunk, may be empty
+			@return Extended chunk
+		*/
+		ChunkPtr extend(const ChunkPtr& next_) const
+		{
+			size_t before = previous ? std::min(halo, previous->getRows()) : 0;
+			size_t after = next_ ? std::min(halo, next_->getRows()) : 0;
+			size_t rows = current->getRows();
+
+			ChunkPtr chunk = std::make_shared<PointcloudChunk<ElementType>>(current->sequence, current->first, 
+				before + rows + after, current->color_flag, current->normal_flag);
+			chunk->halo_before = before;
+			chunk->halo_after = after;
+
+			if (before) {
+				chunk->copyRows(*previous, previous->getRows() - before, before, 0);
+			}
+			chunk->copyRows(*current, 0, rows, before);
+			if (after) {
+				chunk->copyRows(*next_, 0, after, before + rows);
+			}
+
+			return chunk;
+		}
+
+		/**
+			Maximal number of halo vertices on every side
+		*/
+		size_t halo;
+
+		/**
+			Predecessor of the current chunk
+		*/
+		ChunkPtr previous;
+
+		/**
+			Chunk which waits for its successor
+		*/
+		ChunkPtr current;
+	};
+}
+
+#endif /* POINTCLOUD_CHUNK_H_ */
@@ -32,11 +32,15 @@
 #ifndef POINTCLOUD_NORMALS_H_
 #define POINTCLOUD_NORMALS_H_
 
+#include <cstdint>
+#include <limits>
+
 #include "tools/parameters.h"
 
 #include "tools/utils/matrix.h"
-#include "tools/utils/threadpool.h"
+#include "tools/utils/parallel.h"
 
+#include "tools/pointcloud/chunk.h"
 #include "tools/pointcloud/pointcloud.h"
 
 #include "tools/math/function.h"
@@ -153,16 +157,16 @@ namespace pointcloud
 	};
 
 	/**
-		Computes the normals of a pointcloud and sets the normals
-		
+		Computes the normals of a pointcloud with a certain type of the indices of the neighbors
+
 		@param[in,out] pointcloud Pointcloud
 		@param[in] neighbors Number of neighbors which will be considered for computation normals
 		@param[in] normal_params Parameter for computing normals
 	*/
-	template<typename ElementType> void computeNormals(
+	template<typename ElementType, typename IndexType> void computeNormalsImpl(
 		pointcloud::Pointcloud<ElementType>& pointcloud, 
 		size_t  neighbors,
-		NormalParams normal_params = NormalParams())
+		const NormalParams& normal_params)
 	{
 		/**
 			Ensure assigning normals to pointcloud
@@ -172,9 +176,8 @@ namespace pointcloud
 		/**
 			Build a kd-tree with the entire pointcloud
 		*/
-		utils::Matrix<ElementType> pointcloud_matrix;
-		pointcloud.getMatrix(pointcloud_matrix);
-		trees::Index<ElementType> kdtree_index(pointcloud_matrix,trees::KDTreeIndexParams(std::round(neighbors / 2)));
+		utils::Matrix<ElementType> pointcloud_matrix = pointcloud.getPointsMatrix();
+		trees::Index<ElementType, IndexType> kdtree_index(pointcloud_matrix,trees::KDTreeIndexParams(std::round(neighbors / 2)));
 		kdtree_index.buildIndex();
 
 		/**
@@ -183,42 +186,132 @@ namespace pointcloud
 		trees::TreeParams tree_params;
 		tree_params.setCores(normal_params.getCores());
 
-		utils::Matrix<size_t> indices(pointcloud.getNumberOfVertices(), neighbors);
+		utils::Matrix<IndexType> indices(pointcloud.getNumberOfVertices(), neighbors);
 		utils::Matrix<ElementType> dists(pointcloud.getNumberOfVertices(), neighbors);
-		
-		utils::Matrix<ElementType> points;
-		pointcloud.getMatrix(points);
+		indices.advise(utils::AccessPattern::SEQUENTIAL);
+		dists.advise(utils::AccessPattern::SEQUENTIAL);
 		
 		/**
 			Search for the neighbors 
 		*/
-		kdtree_index.knnSearch(points, indices, dists, neighbors, tree_params);
+		kdtree_index.knnSearch(pointcloud_matrix, indices, dists, neighbors, tree_params);
 
 		/**
 			Compute the normals
 		*/
-		if (normal_params.getCores() != 1) {
-			utils::Threadpool pool(normal_params.getCores());
-			for (size_t i = 0; i < pointcloud.getNumberOfVertices(); i++) {
-				while (!pool.runTask(boost::bind(&computeNormal<ElementType>,
+		utils::parallel_for(0, pointcloud.getNumberOfVertices(), tree_params.getGrain(), [&](size_t begin_, size_t end_) {
+			for (size_t i = begin_; i < end_; i++) {
+				computeNormal<ElementType>(
 					i,
-					std::ref(pointcloud),
+					pointcloud,
 					indices[i],
 					neighbors,
-					normal_params)));
+					normal_params);
 			}
+		}, normal_params.getCores());
+	}
 
-			pool.shutdown();
+	/**
+		Computes the normals of a pointcloud and sets the normals
+		
+		@param[in,out] pointcloud Pointcloud
+		@param[in] neighbors Number of neighbors which will be considered for computation normals
+		@param[in] normal_params Parameter for computing normals
+	*/
+	template<typename ElementType> void computeNormals(
+		pointcloud::Pointcloud<ElementType>& pointcloud, 
+		size_t  neighbors,
+		NormalParams normal_params = NormalParams())
+	{
+		/**
+			The indices of the neighbors are stored with 32 bits if the pointcloud allows it, 
+			which halves the container of the indices
+		*/
+		if (pointcloud.getNumberOfVertices() <= (size_t)std::numeric_limits<uint32_t>::max()) {
+			computeNormalsImpl<ElementType, uint32_t>(pointcloud, neighbors, normal_params);
 		}
 		else {
-			for (size_t i = 0; i < pointcloud.getNumberOfVertices(); i++) {
-				computeNormal<ElementType>(
-					i,
-					pointcloud,
-					indices[i],
-					neighbors,
-					normal_params);
+			computeNormalsImpl<ElementType, uint64_t>(pointcloud, neighbors, normal_params);
+		}
+	}
+
+	/**
+		Computes the normals of the own vertices of a chunk with a certain type of the indices of
+		the neighbors
+
+		@param[in,out] chunk Chunk
+		@param[in] neighbors Number of neighbors, at most the number of rows of the chunk
+		@param[in] normal_params Parameter for computing normals
+	*/
+	template<typename ElementType, typename IndexType> void computeNormalsImpl(
+		PointcloudChunk<ElementType>& chunk,
+		size_t neighbors,
+		const NormalParams& normal_params)
+	{
+
+		/**
+			Build a kd-tree with the chunk and its halo
+		*/
+		trees::Index<ElementType, IndexType> kdtree_index(chunk.points, trees::KDTreeIndexParams(std::round(neighbors / 2)));
+		kdtree_index.buildIndex();
+
+		/**
+			Search for the neighbors of the own vertices
+		*/
+		trees::TreeParams tree_params;
+		tree_params.setCores(normal_params.getCores());
+
+		utils::Matrix<ElementType> points = utils::Matrix<ElementType>::borrow(
+			chunk.points[chunk.getBegin()], chunk.getNumberOfVertices(), 3);
+
+		utils::Matrix<IndexType> indices(chunk.getNumberOfVertices(), neighbors);
+		utils::Matrix<ElementType> dists(chunk.getNumberOfVertices(), neighbors);
+		kdtree_index.knnSearch(points, indices, dists, neighbors, tree_params);
+
+		/**
+			Compute the normals
+		*/
+		utils::parallel_for(0, chunk.getNumberOfVertices(), tree_params.getGrain(), [&](size_t begin_, size_t end_) {
+			utils::Matrix<ElementType> neighborhood(neighbors, 3);
+			for (size_t i = begin_; i < end_; i++) {
+				for (size_t j = 0; j < neighbors; j++) {
+					std::memcpy(neighborhood[j], chunk.points[indices[i][j]], sizeof(ElementType) * 3);
+				}
+				utils::FixedMatrix<ElementType, 3, 1> point(neighborhood[0]);
+
+				ElementType* normal = chunk.normals[chunk.getBegin() + i];
+				std::memset(normal, (ElementType)0, sizeof(ElementType) * 3);
+				computeNormal<ElementType>(normal, point, neighborhood, normal_params);
 			}
+		}, normal_params.getCores());
+	}
+
+	/**
+		Computes the normals of the own vertices of a chunk, the halo vertices are considered as 
+		neighbors. The result equals computeNormals on the entire pointcloud for every vertex 
+		whose neighbors lie within the chunk and its halo.
+
+		@param[in,out] chunk Chunk
+		@param[in] neighbors Number of neighbors which will be considered for computation normals
+		@param[in] normal_params Parameter for computing normals
+	*/
+	template<typename ElementType> void computeNormals(
+		PointcloudChunk<ElementType>& chunk,
+		size_t neighbors,
+		NormalParams normal_params = NormalParams())
+	{
+		chunk.setNormals();
+
+		neighbors = std::min(neighbors, chunk.getRows());
+		if (!chunk.getNumberOfVertices() || !neighbors) {
+			return;
+		}
+
+		if (chunk.getRows() <= (size_t)std::numeric_limits<uint32_t>::max()) {
+			computeNormalsImpl<ElementType, uint32_t>(chunk, neighbors, normal_params);
+		}
+		else {
+			computeNormalsImpl<ElementType, uint64_t>(chunk, neighbors, normal_params);
 		}
 	}
 
@@ -231,10 +324,10 @@ namespace pointcloud
 		@param[in] neighbors Number of neighbors
 		@param[in] normal_params Parameter for computing normals
 	*/
-	template<typename ElementType> void computeNormal(
+	template<typename ElementType, typename IndexType> void computeNormal(
 		size_t index,
 		pointcloud::Pointcloud<ElementType>& pointcloud,
-		size_t* indices,
+		const IndexType* indices,
 		size_t neighbors,
 		NormalParams normal_params)
 	{
@@ -244,7 +337,7 @@ namespace pointcloud
 		utils::Matrix<ElementType> points;
 		pointcloud.getSubset(indices, neighbors, points);
 		
-		utils::Matrix<ElementType> point = points.getRowMatrix(0);
+		utils::FixedMatrix<ElementType, 3, 1> point(points[0]);
 
 		/**
 			Compute the normal
@@ -267,22 +360,15 @@ namespace pointcloud
 		@param[in] normal_params Parameter for computing normals
 		@return Normal
 	*/
-	template<typename ElementType> utils::Matrix<ElementType> computeNormal(
-		const utils::Matrix<ElementType>& point,
+	template<typename ElementType> utils::FixedMatrix<ElementType, 3, 1> computeNormal(
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
 		NormalParams normal_params = NormalParams())
 	{
-		ElementType* normal = new ElementType[3];
-		std::memset(normal, (ElementType)0, sizeof(ElementType) * 3);
-
-		switch (normal_params.getNormalComputation()) {
-		case NormalComputation::PLANESVD: normalPlaneSVD(normal, point, points, normal_params.getWeightFunction()); break;
-		case NormalComputation::PLANEPCA: normalPlanePCA(normal, point, points, normal_params.getWeightFunction()); break;
-		case NormalComputation::VECTORSVD: normalVectorSVD(normal, point, points, normal_params.getWeightFunction()); break;
-		case NormalComputation::QUADSVD: normalQuadSVD(normal, point, points, normal_params.getWeightFunction()); break;
-		}
+		utils::FixedMatrix<ElementType, 3, 1> normal;
+		computeNormal<ElementType>(normal.getPtr(), point, points, normal_params);
 
-		return utils::Matrix<ElementType>(normal, 3, 1);
+		return normal;
 	}
 
 	/**
@@ -295,7 +381,7 @@ namespace pointcloud
 	*/
 	template<typename ElementType> void computeNormal(
 		ElementType* normal,
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
 		NormalParams normal_params = NormalParams())
 	{
@@ -318,7 +404,7 @@ namespace pointcloud
 	*/
 	template<typename ElementType> void normalPlaneSVD(
 		ElementType* normal,
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
 		const NormalParams&  normal_params)
 	{
@@ -376,7 +462,7 @@ namespace pointcloud
 
 	template<typename ElementType> void normalPlanePCA(
 		ElementType* normal,
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points, 
 		const NormalParams&  normal_params)
 	{
@@ -394,7 +480,7 @@ namespace pointcloud
 	*/
 	template<typename ElementType> void normalVectorSVD(
 		ElementType* normal,
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points, 
 		const NormalParams&  normal_params)
 	{
@@ -411,7 +497,7 @@ namespace pointcloud
 	*/
 	template<typename ElementType> void normalQuadSVD(
 		ElementType* normal,
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points, 
 		const NormalParams&  normal_params)
 	{
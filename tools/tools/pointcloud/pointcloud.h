@@ -39,6 +39,7 @@
 #include "tools/parameters.h"
 
 #include "tools/utils/matrix.h"
+#include "tools/utils/memorytracker.h"
 
 #include "tools/pointcloud/pointcloudnodes.h"
 
@@ -186,6 +187,19 @@ namespace pointcloud
 		}
 
 	protected:
+		/**
+			Copy the triangles of another pointcloud into own tracked memory
+
+			@param[in] pointcloud_ Pointcloud
+		*/
+		void copyTriangles(const Pointcloud<ElementType>& pointcloud_)
+		{
+			allocateMemoryTriangles();
+			if (triangles) {
+				std::memcpy(triangles, pointcloud_.triangles, sizeof(size_t) * number_of_triangles * 3);
+			}
+		}
+
 		/**
 			Allocte the meory for the triangles
 		*/
@@ -193,6 +207,7 @@ namespace pointcloud
 		{
 			if (isTriangle()) {
 				triangles = new size_t[number_of_triangles * 3];
+				UTILS_MEMORY_ALLOCATE(utils::MemoryTag::POINTCLOUD, sizeof(size_t) * number_of_triangles * 3);
 				memset(triangles, (size_t) 0, sizeof(size_t) * number_of_triangles * 3);
 			}
 		}
@@ -254,6 +269,7 @@ namespace pointcloud
 		void clearMemoryTriangles()
 		{
 			if (triangles) {
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(size_t) * number_of_triangles * 3);
 				delete[] triangles;
 				triangles = nullptr;
 			}
@@ -278,7 +294,7 @@ namespace pointcloud
 			@param[in] number_of_elements_in_list_ Number of elements in list
 			@param[in,out] subset_ Reference to the pointcloud with the subset
 		*/
-		void getSubset(size_t* list,size_t number_of_elements, Pointcloud<ElementType>& subset) const
+		template<typename IndexType> void getSubset(const IndexType* list, size_t number_of_elements, Pointcloud<ElementType>& subset) const
 		{
 			uint8_t flags = 0;
 			if (isColor()) {
@@ -323,7 +339,7 @@ namespace pointcloud
 			@param[in] number_of_elements_in_list_ Number of elements in list
 			@param[in,out] subset_ Reference to the pointcloud with the subset
 		*/
-		void getSubset(size_t* list,size_t number_of_elements, utils::Matrix<ElementType>& subset) const
+		template<typename IndexType> void getSubset(const IndexType* list, size_t number_of_elements, utils::Matrix<ElementType>& subset) const
 		{
 			subset.setMatrix(number_of_elements, 3);
 
@@ -827,15 +843,63 @@ namespace pointcloud
 		*/
 		void getMatrix(utils::Matrix<ElementType>& matrix_) const
 		{
-			ElementType* data = new ElementType[number_of_vertices*3];
-			ElementType* data_ptr = data;
+			matrix_ = utils::Matrix<ElementType>::uninitialized(number_of_vertices, 3);
+			ElementType* data_ptr = matrix_.getPtr();
 
 			for (Iterator<ElementType> it = beginPoint(); it != endPoint(); it++) {
 				*data_ptr= *it;
 				data_ptr++;
 			}
+		}
+
+		/**
+			Get a matrix of the points, which borrows the point-array if the points are stored 
+			contiguously and contains a copy otherwise. A borrowed matrix is only valid as long as 
+			the pointcloud is neither resized nor destroyed.
+
+			@return Matrix with number of vertices x 3 elements
+		*/
+		utils::Matrix<ElementType> getPointsMatrix() const
+		{
+			utils::MatrixView<ElementType> view = pointsView();
+			if (view.isContiguous() && view.getRowStride() == 3) {
+				return utils::Matrix<ElementType>::borrow(view.getPtr(), number_of_vertices, 3);
+			}
+
+			return utils::Matrix<ElementType>(view);
+		}
+
+		/**
+			Returns a view of the points without copying them
+
+			@return View with number of vertices x 3 elements
+		*/
+		virtual utils::MatrixView<ElementType> pointsView() const = 0;
+
+		/**
+			Returns a view of the normals without copying them, the view is empty if the 
+			pointcloud has no normals
+
+			@return View with number of vertices x 3 elements
+		*/
+		virtual utils::MatrixView<ElementType> normalsView() const = 0;
 
-			matrix_.setMatrix(data, number_of_vertices, 3);
+		/**
+			Returns a view of the colors without copying them, the view is empty if the 
+			pointcloud has no colors
+
+			@return View with number of vertices x 3 elements
+		*/
+		virtual utils::MatrixView<uint8_t> colorsView() const = 0;
+
+		/**
+			Get the number of bytes allocated by the pointcloud
+
+			@return Number of bytes
+		*/
+		virtual size_t usedMemory() const
+		{
+			return triangles ? sizeof(size_t) * number_of_triangles * 3 : 0;
 		}
 
 		/**
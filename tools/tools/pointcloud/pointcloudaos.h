@@ -183,8 +183,9 @@ namespace pointcloud
 			if (pointcloud_.isNormal()) { setNormalFlag(); }
 			if (pointcloud_.isTriangle()) { setTriangleFlag(); }
 
-			pointcloud = pointcloud_.getPointcloud();
-			if (isTriangle()) { triangles = pointcloud_.getTrianglesPtr(); }
+			allocateMemoryPointcloud();
+			std::memcpy(pointcloud, pointcloud_.pointcloud, sizeof(PointcloudNode<ElementType>) * number_of_vertices);
+			copyTriangles(pointcloud_);
 		}
 
 		/**
@@ -229,7 +230,7 @@ namespace pointcloud
 				}
 			}
 
-			if (isTriangle()) { triangles = pointcloud_.getTrianglesPtr(); }
+			copyTriangles(pointcloud_);
 		}
 
 	
@@ -239,6 +240,7 @@ namespace pointcloud
 		void allocateMemoryPointcloud()
 		{
 			pointcloud = new PointcloudNode<ElementType>[number_of_vertices];
+			UTILS_MEMORY_ALLOCATE(utils::MemoryTag::POINTCLOUD, sizeof(PointcloudNode<ElementType>) * number_of_vertices);
 		}
 
 	public:
@@ -269,6 +271,18 @@ namespace pointcloud
 			normal_flag = true;
 		}
 
+		/**
+			Get the number of bytes allocated by the pointcloud
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			size_t bytes = Pointcloud<ElementType>::usedMemory();
+			if (pointcloud) { bytes += sizeof(PointcloudNode<ElementType>) * number_of_vertices; }
+			return bytes;
+		}
+
 	private:
 		/**
 			Clear memory of the pointcloud and triangles
@@ -285,6 +299,7 @@ namespace pointcloud
 		void clearMemoryPointcloud()
 		{
 			if (pointcloud) {
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(PointcloudNode<ElementType>) * number_of_vertices);
 				delete[] pointcloud;
 				pointcloud = nullptr;
 			}
@@ -393,18 +408,6 @@ namespace pointcloud
 			pointcloud[row_].setColor(color_, col_);
 		}
 
-	private:
-		/** 
-			Get pointcloud
-
-			@return Pointer to the pointcloud
-		*/
-		PointcloudNode<ElementType>* getPointcloud()
-		{
-			PointcloudNode<ElementType>* new_pointcloud = new PointcloudNode<ElementType>[number_of_vertices];
-			std::memcpy(new_pointcloud, pointcloud, sizeof(PointcloudNode<ElementType>) * number_of_vertices);
-		}
-
 	public:
 
 		/**
@@ -583,6 +586,66 @@ namespace pointcloud
 			return reinterpret_cast<ElementType*>((char*)(pointcloud + number_of_vertices) + sizeof(ElementType) * 3 + sizeof(uint8_t) * 4 + type_padding);
 		}
 
+		/**
+			Returns a strided view of the points without copying them, the row stride is the size 
+			of a node
+
+			@return View with number of vertices x 3 elements
+		*/
+		utils::MatrixView<ElementType> pointsView() const
+		{
+			if (!number_of_vertices) {
+				return utils::MatrixView<ElementType>();
+			}
+
+			return utils::MatrixView<ElementType>(pointcloud[0].point, number_of_vertices, 3, getNodeStride<ElementType>(), 1);
+		}
+
+		/**
+			Returns a strided view of the normals without copying them, the view is empty if the 
+			pointcloud has no normals
+
+			@return View with number of vertices x 3 elements
+		*/
+		utils::MatrixView<ElementType> normalsView() const
+		{
+			if (!number_of_vertices || !isNormal()) {
+				return utils::MatrixView<ElementType>();
+			}
+
+			return utils::MatrixView<ElementType>(pointcloud[0].normal, number_of_vertices, 3, getNodeStride<ElementType>(), 1);
+		}
+
+		/**
+			Returns a strided view of the colors without copying them, the view is empty if the 
+			pointcloud has no colors
+
+			@return View with number of vertices x 3 elements
+		*/
+		utils::MatrixView<uint8_t> colorsView() const
+		{
+			if (!number_of_vertices || !isColor()) {
+				return utils::MatrixView<uint8_t>();
+			}
+
+			return utils::MatrixView<uint8_t>(pointcloud[0].color, number_of_vertices, 3, getNodeStride<uint8_t>(), 1);
+		}
+
+		private:
+
+		/**
+			Returns the distance between the same member of two consecutive nodes
+
+			@return Size of a node in elements of a specific type
+		*/
+		template<typename StrideType> static size_t getNodeStride()
+		{
+			static_assert(sizeof(PointcloudNode<ElementType>) % sizeof(StrideType) == 0, 
+				"The size of a node has to be a multiple of the element type");
+
+			return sizeof(PointcloudNode<ElementType>) / sizeof(StrideType);
+		}
+
 		private:
 
 		/**
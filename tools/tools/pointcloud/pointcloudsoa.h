@@ -36,6 +36,8 @@
 #include <initializer_list>
 
 #include "tools/pointcloud/pointcloud.h"
+#include "tools/utils/alignedmemory.h"
+#include "tools/utils/parallel.h"
 
 namespace pointcloud
 {
@@ -183,10 +185,11 @@ namespace pointcloud
 			if (pointcloud_.isNormal()) { setNormalFlag(); }
 			if (pointcloud_.isTriangle()) { setTriangleFlag(); }
 
-			points = pointcloud_.getPointsPtr();
-			if (isColor()) { colors = pointcloud_.getColorsPtrsPtr(); }
-			if (isNormal()) { normals = pointcloud_.getNormalsPtr(); }
-			if (isTriangle()) { triangle = pointcloud_.getTrianglesPtr(); }
+			allocateMemoryPointcloud();
+			copyArray(points, pointcloud_.getPointsPtr(), number_of_vertices * 3);
+			if (isColor()) { copyArray(colors, pointcloud_.getColorsPtrsPtr(), number_of_vertices * 3); }
+			if (isNormal()) { copyArray(normals, pointcloud_.getNormalsPtr(), number_of_vertices * 3); }
+			copyTriangles(pointcloud_);
 		}
 
 		/**
@@ -203,27 +206,58 @@ namespace pointcloud
 			if (pointcloud_.isNormal()) { setNormalFlag(); }
 			if (pointcloud_.isTriangle()) { setTriangleFlag(); }
 
-			points = pointcloud_.getPointsPtr();
-			if (isColor()) { colors = pointcloud_.getColorsPtrsPtr(); }
-			if (isNormal()) { normals = pointcloud_.getNormalsPtr(); }
-			if (isTriangle()) { triangle = pointcloud_.getTrianglesPtr(); }
+			allocateMemoryPointcloud();
+			copyArray(points, pointcloud_.getPointsPtr(), number_of_vertices * 3);
+			if (isColor()) { copyArray(colors, pointcloud_.getColorsPtrsPtr(), number_of_vertices * 3); }
+			if (isNormal()) { copyArray(normals, pointcloud_.getNormalsPtr(), number_of_vertices * 3); }
+			copyTriangles(pointcloud_);
 		}
 
 
 		/**
-			Allocate the memory for the pointcloud
+			Copy an array which has been allocated with new[] into an array of the pointcloud and 
+			delete it
+
+			@param[in,out] target Array of the pointcloud
+			@param[in] source Array which has been allocated with new[]
+			@param[in] size Number of elements
+		*/
+		template<typename Type> static void copyArray(Type* target, Type* source, size_t size)
+		{
+			if (source) {
+				std::memcpy(target, source, sizeof(Type) * size);
+				delete[] source;
+			}
+		}
+
+		/**
+			Allocate an aligned and initialized array of the pointcloud
+
+			@param[in] size Number of elements
+			@return Array which has to be released with utils::alignedFree
+		*/
+		template<typename Type> static Type* allocateArray(size_t size)
+		{
+			Type* array = utils::alignedAllocate<Type>(size);
+			if (array) {
+				UTILS_MEMORY_ALLOCATE(utils::MemoryTag::POINTCLOUD, sizeof(Type) * size);
+				utils::initializeMemory(array, sizeof(Type) * size);
+			}
+
+			return array;
+		}
+
+		/**
+			Allocate the memory for the pointcloud, all arrays are aligned to UTILS_ALIGNMENT
 		*/
 		void allocateMemoryPointcloud()
 		{
-			points = new ElementType[number_of_vertices * 3];
-			memset(points, (ElementType) 0.0, sizeof(ElementType) * number_of_vertices * 3);
+			points = allocateArray<ElementType>(number_of_vertices * 3);
 			if (isColor()) {
-				colors = new uint8_t[number_of_vertices * 3];
-				memset(colors, (uint8_t) 0, sizeof(uint8_t) * number_of_vertices * 3);
+				colors = allocateArray<uint8_t>(number_of_vertices * 3);
 			}
 			if (isNormal()) {
-				normals = new ElementType[number_of_vertices * 3];
-				memset(normals, (ElementType) 0.0, sizeof(ElementType) * number_of_vertices * 3);
+				normals = allocateArray<ElementType>(number_of_vertices * 3);
 			}
 		}
 
@@ -247,12 +281,12 @@ namespace pointcloud
 			color_flag = true;
 
 			if (colors) {
-				delete[] colors;
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(uint8_t) * number_of_vertices * 3);
+				utils::alignedFree(colors);
 				colors = nullptr;
 			}
 
-			colors = new uint8_t[number_of_vertices * 3];
-			memset(colors, (uint8_t)0, sizeof(uint8_t) * number_of_vertices * 3);
+			colors = allocateArray<uint8_t>(number_of_vertices * 3);
 		}
 
 		/**
@@ -263,12 +297,26 @@ namespace pointcloud
 			normal_flag = true;
 
 			if (normals) {
-				delete[] normals;
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(ElementType) * number_of_vertices * 3);
+				utils::alignedFree(normals);
 				normals = nullptr;
 			}
 
-			normals = new ElementType[number_of_vertices * 3];
-			memset(normals, (ElementType) 0.0, sizeof(ElementType) * number_of_vertices * 3);
+			normals = allocateArray<ElementType>(number_of_vertices * 3);
+		}
+
+		/**
+			Get the number of bytes allocated by the pointcloud
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			size_t bytes = Pointcloud<ElementType>::usedMemory();
+			if (points) { bytes += sizeof(ElementType) * number_of_vertices * 3; }
+			if (normals) { bytes += sizeof(ElementType) * number_of_vertices * 3; }
+			if (colors) { bytes += sizeof(uint8_t) * number_of_vertices * 3; }
+			return bytes;
 		}
 
 	private:
@@ -287,15 +335,18 @@ namespace pointcloud
 		void clearMemoryPointcloud()
 		{
 			if (points) { 
-				delete[] points;
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(ElementType) * number_of_vertices * 3);
+				utils::alignedFree(points);
 				points = nullptr;
 			}
 			if (normals) { 
-				delete[] normals; 
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(ElementType) * number_of_vertices * 3);
+				utils::alignedFree(normals);
 				normals = nullptr;
 			}
 			if (colors) { 
-				delete[] colors;
+				UTILS_MEMORY_FREE(utils::MemoryTag::POINTCLOUD, sizeof(uint8_t) * number_of_vertices * 3);
+				utils::alignedFree(colors);
 				colors = nullptr;
 			}
 		}
@@ -572,6 +623,46 @@ namespace pointcloud
 			return normals + number_of_vertices * 3;
 		}
 
+		/**
+			Returns a view of the points without copying them
+
+			@return View with number of vertices x 3 elements
+		*/
+		utils::MatrixView<ElementType> pointsView() const
+		{
+			return utils::MatrixView<ElementType>(points, number_of_vertices, 3, 3, 1);
+		}
+
+		/**
+			Returns a view of the normals without copying them, the view is empty if the 
+			pointcloud has no normals
+
+			@return View with number of vertices x 3 elements
+		*/
+		utils::MatrixView<ElementType> normalsView() const
+		{
+			if (!normals) {
+				return utils::MatrixView<ElementType>();
+			}
+
+			return utils::MatrixView<ElementType>(normals, number_of_vertices, 3, 3, 1);
+		}
+
+		/**
+			Returns a view of the colors without copying them, the view is empty if the 
+			pointcloud has no colors
+
+			@return View with number of vertices x 3 elements
+		*/
+		utils::MatrixView<uint8_t> colorsView() const
+		{
+			if (!colors) {
+				return utils::MatrixView<uint8_t>();
+			}
+
+			return utils::MatrixView<uint8_t>(colors, number_of_vertices, 3, 3, 1);
+		}
+
 	private:
 		/**
 			Pointcloud
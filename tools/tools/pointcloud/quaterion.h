@@ -33,6 +33,7 @@
 #define POINTCLOUD_QUATERION_H_
 
 #include "tools/math/standard.h"
+#include "tools/utils/fixedmatrix.h"
 
 namespace pointcloud
 {
@@ -42,12 +43,8 @@ namespace pointcloud
 		/**
 			Constructor
 		*/
-		Quaterion() : v(nullptr)
+		Quaterion() : v({ 1, 0, 0, 0 })
 		{
-			v = new ElementType[4];
-			std::memset(v, 0, sizeof(ElementType) * 4);
-
-			v[0] = 1;
 		}
 
 		/**
@@ -58,10 +55,8 @@ namespace pointcloud
 			@param[in] axis_y_ Part of the axis
 			@param[in] axis_z_ Part of the axis
 		*/
-		Quaterion(ElementType angle_, ElementType axis_x_, ElementType axis_y_, ElementType axis_z_) : v(nullptr)
+		Quaterion(ElementType angle_, ElementType axis_x_, ElementType axis_y_, ElementType axis_z_)
 		{
-			v = new ElementType[4];
-
 			setRotationAxisPrivate(angle_, axis_x_, axis_y_, axis_z_);
 		}
 
@@ -72,83 +67,11 @@ namespace pointcloud
 			@param[in] y_ Euler angle around the y-axis in rad
 			@param[in] z_ Euler angle around the z-axis in rad
 		*/
-		Quaterion(ElementType x_, ElementType y_, ElementType z_) : v(nullptr)
+		Quaterion(ElementType x_, ElementType y_, ElementType z_)
 		{
-			v = new ElementType[4];
-
 			setEulerAnglePrivate(x_, y_, z_);
 		}
 
-		/**
-			Destructor
-		*/
-		~Quaterion()
-		{
-			clear();
-		}
-
-		/**
-			Clear
-		*/
-		void clear() 
-		{
-			if (v) {
-				delete[] v;
-				v = nullptr;
-			}
-		}
-
-		/**
-			Copy constructor
-
-			@param[in] Quaterion_ An instance of class Quaterion
-		*/
-		Quaterion(const Quaterion<ElementType>& quaterion_) : v(nullptr)
-		{
-			v = new ElementType[4];
-			std::memcpy(v, quaterion_.getQuaterion(), sizeof(ElementType) * 4);
-		};
-
-		/**
-			Copy constructor
-
-			@param[in] Quaterion_ An instance of class Quaterion
-		*/
-		Quaterion(const Quaterion<ElementType>&& quaterion_) : v(nullptr)
-		{
-			v = new ElementType[4];
-			std::memcpy(v, quaterion_.getQuaterion(), sizeof(ElementType) * 4);
-		};
-
-		/**
-			Operator =
-	
-			@param[in] class_ An instance of class Quaterion
-		*/
-		Quaterion& operator=(const Quaterion<ElementType>& quaterion_)
-		{
-			clear();
-			v = new ElementType[4];
-			std::memcpy(v, quaterion_.getQuaterion(), sizeof(ElementType) * 4);
-
-			return *this;
-		};
-			
-		/**
-			Operator =
-	
-			@param[in] class_ An instance of class Quaterion
-		*/
-		Quaterion& operator=(const Quaterion<ElementType>&& quaterion_)
-		{
-			clear();
-
-			v = new ElementType[4];
-			std::memcpy(v, quaterion_.getQuaterion(), sizeof(ElementType) * 4);
-
-			return *this;
-		};
-		
 		/**
 			Set Quaterion
 
@@ -159,10 +82,10 @@ namespace pointcloud
 		*/
 		void setQuaterion(ElementType w_, ElementType x_, ElementType y_, ElementType z_)
 		{
-			v[0] = w_;
-			v[1] = x_;
-			v[2] = y_;
-			v[3] = z_;
+			v[0][0] = w_;
+			v[1][0] = x_;
+			v[2][0] = y_;
+			v[3][0] = z_;
 		}
 
 		/**
@@ -198,7 +121,7 @@ namespace pointcloud
 		*/
 		ElementType operator[](size_t index_) const
 		{
-			return v[index_];
+			return v(index_, 0);
 		}
 
 		/**
@@ -208,14 +131,7 @@ namespace pointcloud
 		*/
 		Quaterion& operator*=(const Quaterion<ElementType>& r_)
 		{
-			ElementType* new_v = new ElementType[4];
-			new_v[0] = r_[0] * v[0] - r_[1] * v[1] - r_[2] * v[2] - r_[3] * v[3];
-			new_v[1] = r_[0] * v[1] + r_[1] * v[0] - r_[2] * v[3] + r_[3] * v[2];
-			new_v[2] = r_[0] * v[2] + r_[1] * v[3] + r_[2] * v[0] - r_[3] * v[1];
-			new_v[3] = r_[0] * v[3] - r_[1] * v[2] + r_[2] * v[1] + r_[3] * v[0];
-
-			delete[] v;
-			v = new_v;
+			(*this) = (*this) * r_;
 
 			return *this;
 		}
@@ -225,13 +141,13 @@ namespace pointcloud
 			
 			@param[in] quaterion_ An instance of class Quaterion
 		*/
-		Quaterion operator*(const Quaterion<ElementType>& r_)
+		Quaterion operator*(const Quaterion<ElementType>& r_) const
 		{
 			Quaterion<ElementType> quaterion;
-			quaterion.setQuaterion(r_[0] * v[0] - r_[1] * v[1] - r_[2] * v[2] - r_[3] * v[3],
-				r_[0] * v[1] + r_[1] * v[0] - r_[2] * v[3] + r_[3] * v[2],
-				r_[0] * v[2] + r_[1] * v[3] + r_[2] * v[0] - r_[3] * v[1],
-				r_[0] * v[3] - r_[1] * v[2] + r_[2] * v[1] + r_[3] * v[0]);
+			quaterion.setQuaterion(r_[0] * v[0][0] - r_[1] * v[1][0] - r_[2] * v[2][0] - r_[3] * v[3][0],
+				r_[0] * v[1][0] + r_[1] * v[0][0] - r_[2] * v[3][0] + r_[3] * v[2][0],
+				r_[0] * v[2][0] + r_[1] * v[3][0] + r_[2] * v[0][0] - r_[3] * v[1][0],
+				r_[0] * v[3][0] - r_[1] * v[2][0] + r_[2] * v[1][0] + r_[3] * v[0][0]);
 
 			return quaterion;
 		}
@@ -243,7 +159,7 @@ namespace pointcloud
 		*/
 		ElementType lengthsqr() 
 		{
-			return (v[0]*v[0] + v[1]*v[1] + v[2]*v[2] + v[3]*v[3]);		
+			return (v[0][0]*v[0][0] + v[1][0]*v[1][0] + v[2][0]*v[2][0] + v[3][0]*v[3][0]);		
 		}
 
 		/**
@@ -251,9 +167,9 @@ namespace pointcloud
 		*/
 		void conjugate()
 		{
-			v[1] = -v[1];
-			v[2] = -v[2];
-			v[3] = -v[3];
+			v[1][0] = -v[1][0];
+			v[2][0] = -v[2][0];
+			v[3][0] = -v[3][0];
 		}
 		
 		/**
@@ -265,7 +181,7 @@ namespace pointcloud
 
 			conjugate();
 			for (size_t i = 0; i < 4; i++) {
-				v[i] /= lengthsqr();
+				v[i][0] /= lengthsqr();
 			}
 		}
 
@@ -274,9 +190,9 @@ namespace pointcloud
 
 			@return Quaterion
 		*/
-		ElementType* getQuaterion() const
+		const ElementType* getQuaterion() const
 		{
-			return v;
+			return v.getPtr();
 		}
 
 		/**
@@ -288,14 +204,14 @@ namespace pointcloud
 		*/
 		void getEulerAngles(ElementType& x_, ElementType& y_, ElementType& z_) const
 		{
-			ElementType sqw = v[0]*v[0];
-			ElementType sqx = v[1]*v[1];
-			ElementType sqy = v[2]*v[2];
-			ElementType sqz = v[3]*v[3];
-
-			x_ = std::atan2((ElementType)2.0 * (v[0]*v[1] + v[2]*v[3]), (ElementType)1.0 - (ElementType)2.0 * (sqx + sqy));
-			y_ = std::asin( (ElementType)2.0 * (v[0]*v[2] - v[1]*v[3]));
-			z_ = std::atan2((ElementType)2.0 * (v[0]*v[3] + v[1]*v[2]), (ElementType)1.0 - (ElementType)2.0 * (sqy + sqz));
+			ElementType sqw = v[0][0]*v[0][0];
+			ElementType sqx = v[1][0]*v[1][0];
+			ElementType sqy = v[2][0]*v[2][0];
+			ElementType sqz = v[3][0]*v[3][0];
+
+			x_ = std::atan2((ElementType)2.0 * (v[0][0]*v[1][0] + v[2][0]*v[3][0]), (ElementType)1.0 - (ElementType)2.0 * (sqx + sqy));
+			y_ = std::asin( (ElementType)2.0 * (v[0][0]*v[2][0] - v[1][0]*v[3][0]));
+			z_ = std::atan2((ElementType)2.0 * (v[0][0]*v[3][0] + v[1][0]*v[2][0]), (ElementType)1.0 - (ElementType)2.0 * (sqy + sqz));
 		} 
 		
 		/**
@@ -305,22 +221,35 @@ namespace pointcloud
 		*/
 		void getRotationMatrix(ElementType* matrix_)
 		{
-			ElementType sqw = v[0] * v[0];
-			ElementType sqx = v[1] * v[1];
-			ElementType sqy = v[2] * v[2];
-			ElementType sqz = v[3] * v[3];
+			ElementType sqw = v[0][0] * v[0][0];
+			ElementType sqx = v[1][0] * v[1][0];
+			ElementType sqy = v[2][0] * v[2][0];
+			ElementType sqz = v[3][0] * v[3][0];
 
 			matrix_[0] = (ElementType)1.0 - (ElementType)2.0*(sqy + sqz); 
-			matrix_[1] = (ElementType)2.0*(v[1] * v[2] - v[0] * v[3]); 
-			matrix_[2] = (ElementType)2.0*(v[0] * v[2] + v[1] * v[3]);
-			matrix_[3] = (ElementType)2.0*(v[1] * v[2] + v[0] * v[3]); 
+			matrix_[1] = (ElementType)2.0*(v[1][0] * v[2][0] - v[0][0] * v[3][0]); 
+			matrix_[2] = (ElementType)2.0*(v[0][0] * v[2][0] + v[1][0] * v[3][0]);
+			matrix_[3] = (ElementType)2.0*(v[1][0] * v[2][0] + v[0][0] * v[3][0]); 
 			matrix_[4] = (ElementType)1.0 - (ElementType)2.0*(sqx + sqz); 
-			matrix_[5] = (ElementType)2.0*(v[2] * v[3] - v[0] * v[1]);
-			matrix_[6] = (ElementType)2.0*(v[1] * v[3] - v[0] * v[2]); 
-			matrix_[7] = (ElementType)2.0*(v[0] * v[1] + v[2] * v[3]); 
+			matrix_[5] = (ElementType)2.0*(v[2][0] * v[3][0] - v[0][0] * v[1][0]);
+			matrix_[6] = (ElementType)2.0*(v[1][0] * v[3][0] - v[0][0] * v[2][0]); 
+			matrix_[7] = (ElementType)2.0*(v[0][0] * v[1][0] + v[2][0] * v[3][0]); 
 			matrix_[8] = (ElementType)1.0 - (ElementType)2.0*(sqx + sqy);
 		}
 
+		/**
+			Get the orthogonal matrix corresponding to a rotation by the unit quaterion
+
+			@return Rotation matrix
+		*/
+		utils::FixedMatrix<ElementType, 3, 3> getRotationMatrix()
+		{
+			utils::FixedMatrix<ElementType, 3, 3> matrix;
+			getRotationMatrix(matrix.getPtr());
+
+			return matrix;
+		}
+
 	private:
 		
 		/**
@@ -333,10 +262,10 @@ namespace pointcloud
 		*/
 		void setRotationAxisPrivate(ElementType angle_, ElementType axis_x_, ElementType axis_y_, ElementType axis_z_)
 		{
-			v[0] = std::cos(angle_ * (ElementType)0.5);
-			v[1] = axis_x_*std::sin(angle_ * (ElementType)0.5);
-			v[2] = axis_y_*std::sin(angle_ * (ElementType)0.5);
-			v[3] = axis_z_*std::sin(angle_ * (ElementType)0.5);
+			v[0][0] = std::cos(angle_ * (ElementType)0.5);
+			v[1][0] = axis_x_*std::sin(angle_ * (ElementType)0.5);
+			v[2][0] = axis_y_*std::sin(angle_ * (ElementType)0.5);
+			v[3][0] = axis_z_*std::sin(angle_ * (ElementType)0.5);
 		}
 
 		/**
@@ -359,15 +288,18 @@ namespace pointcloud
 			ElementType cz = std::cos(z_ * (ElementType)0.5);
 			ElementType sz = std::sin(z_ * (ElementType)0.5);
 
-			v[0] = cx * cy * cz + sx * sy * sz;
-			v[1] = sx * cy * cz - cx * sy * sz;
-			v[2] = cx * sy * cz + sx * cy * sz;
-			v[3] = cx * cy * sz - sx * sy * cz;
+			v[0][0] = cx * cy * cz + sx * sy * sz;
+			v[1][0] = sx * cy * cz - cx * sy * sz;
+			v[2][0] = cx * sy * cz + sx * cy * sz;
+			v[3][0] = cx * cy * sz - sx * sy * cz;
 		}
 
 	private:
 
-		ElementType* v;
+		/**
+			Quaterion w, x, y, z
+		*/
+		utils::FixedMatrix<ElementType, 4, 1> v;
 	};
 
 	/**
@@ -0,0 +1,114 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef POINTCLOUD_REORDER_H_
+#define POINTCLOUD_REORDER_H_
+
+#include <vector>
+
+#include "tools/utils/morton.h"
+
+#include "tools/pointcloud/pointcloud.h"
+
+namespace pointcloud
+{
+	/**
+		Reorders the points of a pointcloud along a morton curve, so that points which are close in 
+		space are close in memory as well. Points, normals and colors are permuted consistently and 
+		the triangles are remapped to the new positions of their vertices.
+
+		@param[in,out] pointcloud_ Pointcloud
+		@param[in,out] permutation_ Index of every reordered point in the original pointcloud
+		@param[in] cores_ Number of cores
+	*/
+	template<typename ElementType>
+	void reorderSpatially(Pointcloud<ElementType>& pointcloud_, std::vector<size_t>& permutation_, size_t cores_ = 1)
+	{
+		size_t number_of_vertices = pointcloud_.getNumberOfVertices();
+
+		/**
+			Compute and sort the morton codes
+		*/
+		std::vector<ElementType> points(number_of_vertices * 3);
+		for (size_t i = 0; i < number_of_vertices; i++) {
+			std::memcpy(&points[i * 3], pointcloud_.getPointPtr(i), sizeof(ElementType) * 3);
+		}
+
+		std::vector<uint64_t> codes;
+		utils::computeMortonCodes<ElementType>(points.data(), number_of_vertices, 3, codes);
+		utils::radixSort(codes, permutation_, cores_);
+
+		/**
+			Permute every channel
+		*/
+		for (size_t i = 0; i < number_of_vertices; i++) {
+			pointcloud_.setPointPtr(&points[permutation_[i] * 3], i);
+		}
+
+		if (pointcloud_.isNormal()) {
+			std::vector<ElementType> normals(number_of_vertices * 3);
+			for (size_t i = 0; i < number_of_vertices; i++) {
+				std::memcpy(&normals[i * 3], pointcloud_.getNormalPtr(i), sizeof(ElementType) * 3);
+			}
+			for (size_t i = 0; i < number_of_vertices; i++) {
+				pointcloud_.setNormalPtr(&normals[permutation_[i] * 3], i);
+			}
+		}
+
+		if (pointcloud_.isColor()) {
+			std::vector<uint8_t> colors(number_of_vertices * 3);
+			for (size_t i = 0; i < number_of_vertices; i++) {
+				std::memcpy(&colors[i * 3], pointcloud_.getColorPtr(i), sizeof(uint8_t) * 3);
+			}
+			for (size_t i = 0; i < number_of_vertices; i++) {
+				pointcloud_.setColorPtr(&colors[permutation_[i] * 3], i);
+			}
+		}
+
+		/**
+			The triangles refer to the original positions of the vertices
+		*/
+		if (pointcloud_.isTriangle()) {
+			std::vector<size_t> inverse(number_of_vertices);
+			for (size_t i = 0; i < number_of_vertices; i++) {
+				inverse[permutation_[i]] = i;
+			}
+			for (size_t i = 0; i < pointcloud_.getNumberOfTriangles(); i++) {
+				for (size_t j = 0; j < 3; j++) {
+					pointcloud_.setTriangle(inverse[pointcloud_.getTriangle(i, j)], i, j);
+				}
+			}
+		}
+	}
+}
+
+#endif /* POINTCLOUD_REORDER_H_ */
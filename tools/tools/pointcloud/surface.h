@@ -32,9 +32,14 @@
 #ifndef POINTCLOUD_SURFACE_H_
 #define POINTCLOUD_SURFACE_H_
 
+#include <algorithm>
+#include <memory>
+
 #include "tools/utils/matrix.h"
 
 #include "tools/math/adjustment.h"
+#include "tools/math/batchsolver.h"
+#include "tools/math/solver.h"
 #include "tools/math/standard.h"
 #include "tools/math/zero.h"
 
@@ -232,9 +237,9 @@ namespace pointcloud
 		@return Normal
 	*/
 	template<typename ElementType> utils::Matrix<ElementType> computeSurface(
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
-		const utils::Matrix<ElementType>& normal,
+		const utils::FixedMatrix<ElementType, 3, 1>& normal,
 		SurfaceParams surface_params = SurfaceParams())
 	{
 		utils::Matrix<ElementType> parameter;
@@ -259,10 +264,10 @@ namespace pointcloud
 		@param[in] surface_params Parameter for computing the surface
 		@return Reference point of the moving plane
 	*/
-	template<typename ElementType> utils::Matrix<ElementType> pointMLS(
-		const utils::Matrix<ElementType>& point,
+	template<typename ElementType> utils::FixedMatrix<ElementType, 3, 1> pointMLS(
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
-		const utils::Matrix<ElementType>& normal,
+		const utils::FixedMatrix<ElementType, 3, 1>& normal,
 		SurfaceParams surface_params)
 	{
 		/**
@@ -315,9 +320,9 @@ namespace pointcloud
 		@return Parameters of the plane
 	*/
 	template<typename ElementType> utils::Matrix<ElementType> plane(
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
-		const utils::Matrix<ElementType>& normal,
+		const utils::FixedMatrix<ElementType, 3, 1>& normal,
 		SurfaceParams surface_params)
 	{
 		return utils::Matrix<ElementType>({	normal[0][0] / normal[2][0] * (-1),
@@ -336,12 +341,12 @@ namespace pointcloud
 		@return Parameters of the plane
 	*/
 	template<typename ElementType> utils::Matrix<ElementType> planeMLS(
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
-		const utils::Matrix<ElementType>& normal,
+		const utils::FixedMatrix<ElementType, 3, 1>& normal,
 		SurfaceParams surface_params)
 	{
-		utils::Matrix<ElementType> reference_point = pointMLS(
+		utils::FixedMatrix<ElementType, 3, 1> reference_point = pointMLS(
 			point,
 			points,
 			normal,
@@ -353,6 +358,39 @@ namespace pointcloud
 											3, 1);
 	}
 
+	/**
+		Solves the weighted least squares problem of a polynomial surface. The normal equations 
+		(A'PA)x = A'Pl are solved with the Cholesky decomposition, if they are too ill-conditioned
+		the problem is solved with the QR decomposition of the weighted design matrix. 
+
+		@param[in] design_matrix Design matrix A
+		@param[in] weights Weights as column vector
+		@param[in] observation Observations l as column vector
+		@return Parameters of the surface, NaN if the design matrix has not full column rank
+	*/
+	template<typename ElementType, typename Derived> utils::Matrix<ElementType> solveSurface(
+		const utils::Matrix<ElementType>& design_matrix,
+		const utils::Matrix<ElementType>& weights,
+		const utils::MatrixExpression<Derived, ElementType>& observation)
+	{
+		utils::Matrix<ElementType> linear_system = utils::normalEquations(design_matrix, weights, observation);
+
+		utils::Matrix<ElementType> parameter;
+		if (math::solveNormalEquations(linear_system, parameter)) {
+			return parameter;
+		}
+
+		static thread_local math::SolverWorkspace<ElementType> workspace;
+		if (!math::solveWeightedLeastSquares(design_matrix, weights, observation, parameter, workspace)) {
+			parameter = utils::Matrix<ElementType>::uninitialized(design_matrix.getCols(), 1);
+			for (size_t i = 0; i < parameter.getRows(); i++) {
+				parameter[i][0] = std::numeric_limits<ElementType>::quiet_NaN();
+			}
+		}
+
+		return parameter;
+	}
+
 	/**
 		Computes the supporting plane of a neighborhood of points
 
@@ -363,9 +401,9 @@ namespace pointcloud
 		@return Parameters of the plane
 	*/
 	template<typename ElementType> utils::Matrix<ElementType> surfPoly(
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
-		const utils::Matrix<ElementType>& normal,
+		const utils::FixedMatrix<ElementType, 3, 1>& normal,
 		SurfaceParams surface_params)
 	{
 		/**
@@ -380,7 +418,7 @@ namespace pointcloud
 		/**
 			Build the observation vector
 		*/
-		utils::Matrix<ElementType> observation = points.getColMatrix(2);
+		utils::MatrixView<ElementType> observation = points.getColView(2);
 
 		/**
 			Build the weight matrix
@@ -391,11 +429,81 @@ namespace pointcloud
 		math::getWeightsDistances(distances, weights, surface_params.getWeightFunction());
 
 		/**
-			Solve the linear equationsystem (A'PA)x = A'Pl and return the parameter
+			Solve the least squares problem and return the parameter
 		*/
-		utils::Matrix<ElementType> linear_system = (design_matrix.transpose()*(weights*design_matrix)).concatenateCol(design_matrix.transpose()*(weights*observation));
+		return solveSurface(design_matrix, weights, observation);
+	}
 
-		return linear_system.gaussJordanElimination();
+	/**
+		Computes the polynomial surfaces of many neighborhoods at once like surfPoly, the least
+		squares problems are solved together with BatchedLeastSquares. The first neighbor of a 
+		neighborhood is its reference point, like in the result of a knn search for the points 
+		of the pointcloud itself. The neighborhoods are processed in chunks, so that the 
+		interleaved design matrices of at most chunk_size problems are held at once.
+
+		@param[in] points Points of the pointcloud
+		@param[in] indices Indices of the neighbors, one neighborhood per row
+		@param[in] surface_params Parameter for computing the surface
+		@param[in,out] parameters Parameters of the surfaces, one row per neighborhood
+		@param[in] chunk_size Number of neighborhoods which are solved at once
+	*/
+	template<typename ElementType, typename IndexType> void surfPolyBatch(
+		const utils::Matrix<ElementType>& points,
+		const utils::Matrix<IndexType>& indices,
+		SurfaceParams surface_params,
+		utils::Matrix<ElementType>& parameters,
+		size_t chunk_size = 16384)
+	{
+		typedef math::BatchedLeastSquares<ElementType> Batch;
+
+		const size_t degree = surface_params.getPolynomialDegree();
+		const size_t number_of_problems = indices.getRows();
+		const size_t neighbors = indices.getCols();
+		const size_t unknowns = ((degree + 2) * (degree + 1)) / 2;
+		if (parameters.getRows() != number_of_problems || parameters.getCols() != unknowns) {
+			parameters = utils::Matrix<ElementType>::uninitialized(number_of_problems, unknowns);
+		}
+
+		/**
+			Chunks consist of whole blocks, only the last block of the last chunk is partial
+		*/
+		chunk_size = std::max(Batch::lanes, chunk_size - chunk_size % Batch::lanes);
+		const size_t grain = Batch::lanes * 16;
+
+		std::unique_ptr<Batch> batch;
+		for (size_t chunk = 0; chunk < number_of_problems; chunk += chunk_size) {
+			const size_t problems = std::min(chunk_size, number_of_problems - chunk);
+			if (!batch || batch->getNumberOfProblems() != problems) {
+				batch.reset(new Batch(problems, neighbors, unknowns));
+			}
+
+			/**
+				Set the design matrices, weights and observations, blocks of problems are filled by one thread
+			*/
+			utils::parallel_for(0, problems, grain, [&](size_t begin_, size_t end_) {
+				utils::Matrix<ElementType> neighborhood(neighbors, 3);
+				utils::Matrix<ElementType> design_row(1, unknowns);
+				for (size_t i = begin_; i < end_; i++) {
+					const IndexType* index = indices[chunk + i];
+					for (size_t j = 0; j < neighbors; j++) {
+						std::memcpy(neighborhood[j], points[index[j]], sizeof(ElementType) * 3);
+					}
+					utils::FixedMatrix<ElementType, 3, 1> point(neighborhood[0]);
+
+					utils::Matrix<ElementType> distances = std::sqrt(math::euclideanDistance<ElementType>(neighborhood - point.transpose()));
+					utils::Matrix<ElementType> weights;
+					math::getWeightsDistances(distances, weights, surface_params.getWeightFunction());
+
+					for (size_t j = 0; j < neighbors; j++) {
+						math::buildDesignRowPolynomial3D(neighborhood[j][0], neighborhood[j][1], design_row.getPtr(), degree);
+						batch->setObservation(i, j, design_row.getPtr(), weights[j][0], neighborhood[j][2]);
+					}
+				}
+			}, surface_params.getCores());
+
+			utils::Matrix<ElementType> coefficients = utils::Matrix<ElementType>::borrow(parameters[chunk], problems, unknowns);
+			batch->solve(coefficients, surface_params.getCores());
+		}
 	}
 
 	/**
@@ -408,12 +516,12 @@ namespace pointcloud
 		@return Parameters of the plane
 	*/
 	template<typename ElementType> utils::Matrix<ElementType> surfPolyMLS(
-		const utils::Matrix<ElementType>& point,
+		const utils::FixedMatrix<ElementType, 3, 1>& point,
 		const utils::Matrix<ElementType>& points,
-		const utils::Matrix<ElementType>& normal,
+		const utils::FixedMatrix<ElementType, 3, 1>& normal,
 		SurfaceParams surface_params)
 	{
-		utils::Matrix<ElementType> reference_point = pointMLS(
+		utils::FixedMatrix<ElementType, 3, 1> reference_point = pointMLS(
 			point,
 			points,
 			normal,
@@ -431,7 +539,7 @@ namespace pointcloud
 		/**
 			Build the observation vector
 		*/
-		utils::Matrix<ElementType> observation = points.getColMatrix(2);
+		utils::MatrixView<ElementType> observation = points.getColView(2);
 
 		/**
 			Build the weight matrix
@@ -442,11 +550,9 @@ namespace pointcloud
 		math::getWeightsDistances(distances, weights, surface_params.getWeightFunction());
 
 		/**
-			Solve the linear equationsystem (A'PA)x = A'Pl and return the parameter
+			Solve the least squares problem and return the parameter
 		*/
-		utils::Matrix<ElementType> linear_system = (design_matrix.transpose()*(weights*design_matrix)).concatenateCol(design_matrix.transpose()*(weights*observation));
-		
-		return linear_system.gaussJordanElimination();
+		return solveSurface(design_matrix, weights, observation);
 	}
 
 	template<typename ElementType> struct NonLinearPlaneMLSMinimization
@@ -460,13 +566,12 @@ namespace pointcloud
 			@param[in] var Variance of the distances from the points of the neighborhood to the reference point
 		*/
 		NonLinearPlaneMLSMinimization(
-			utils::Matrix<ElementType> point,
-			utils::Matrix<ElementType> points,
-			utils::Matrix<ElementType> normal,
-			ElementType var)
+			const utils::FixedMatrix<ElementType, 3, 1>& point,
+			const utils::Matrix<ElementType>& points,
+			const utils::FixedMatrix<ElementType, 3, 1>& normal,
+			ElementType var) : points_(points.getView())
 		{
 			point_ = point;
-			points_ = points;
 			normal_ = normal;
 			var_ = var;
 		}
@@ -480,7 +585,7 @@ namespace pointcloud
 				/**
 					Vector between searched point and data point
 				*/
-				utils::Matrix<ElementType> q = (points_.getRowMatrix(i) - point_) - normal_ * t;
+				utils::FixedMatrix<ElementType, 3, 1> q = (points_.getRowView(i) - point_) - normal_ * t;
 
 				/**
 					Distance of vector between searched point and data point
@@ -501,17 +606,17 @@ namespace pointcloud
 		/**
 			Reference point
 		*/
-		utils::Matrix<ElementType> point_;
+		utils::FixedMatrix<ElementType, 3, 1> point_;
 
 		/**
-			Neighborhood of the point
+			Neighborhood of the point, a view of the matrix which has been passed to the constructor
 		*/
-		utils::Matrix<ElementType> points_;
+		utils::MatrixView<ElementType> points_;
 
 		/**
 			Normal of the reference point
 		*/
-		utils::Matrix<ElementType> normal_;
+		utils::FixedMatrix<ElementType, 3, 1> normal_;
 
 		/**
 			Variance of the distances from the points of the neighborhood to the reference point
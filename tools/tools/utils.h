@@ -32,15 +32,26 @@
 #ifndef INCLUDE_UTILS_H_
 #define INCLUDE_UTILS_H_
 
+#include "utils/alignedmemory.h"
 #include "utils/allocator.h"
 #include "utils/any.h"
 #include "utils/balancedtree.h"
 #include "utils/boundingbox.h"
 #include "utils/color.h"
 #include "utils/dist.h"
+#include "utils/fixedmatrix.h"
 #include "utils/heap.h"
+#include "utils/mappedfile.h"
 #include "utils/matrix.h"
+#include "utils/matrixexpression.h"
+#include "utils/matrixproduct.h"
+#include "utils/matrixview.h"
+#include "utils/memorytracker.h"
+#include "utils/morton.h"
 #include "utils/mouseposition.h"
+#include "utils/numa.h"
+#include "utils/parallel.h"
+#include "utils/pipeline.h"
 #include "utils/queue.h"
 #include "utils/randomize.h"
 #include "utils/threadpool.h"
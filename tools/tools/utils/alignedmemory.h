@@ -0,0 +1,137 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_ALIGNEDMEMORY_H_
+#define UTILS_ALIGNEDMEMORY_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(_MSC_VER)
+	#include <malloc.h>
+#endif
+
+/**
+	Alignment in bytes of the buffers of matrices and pointclouds, one cache line which covers
+	the widest vector registers (AVX-512)
+*/
+#define UTILS_ALIGNMENT 64
+
+namespace utils
+{
+	/**
+		Returns a pointer to an uninitialized array of the given number of elements whose first
+		element is aligned to UTILS_ALIGNMENT, the array has to be released with alignedFree
+
+		@param[in] size Number of elements
+		@return Pointer to the aligned array or nullptr if size is zero
+	*/
+	template<typename ElementType> inline ElementType* alignedAllocate(size_t size)
+	{
+		if (!size) {
+			return nullptr;
+		}
+
+		void* pointer = nullptr;
+#if defined(_MSC_VER)
+		pointer = _aligned_malloc(sizeof(ElementType) * size, UTILS_ALIGNMENT);
+#else
+		if (posix_memalign(&pointer, UTILS_ALIGNMENT, sizeof(ElementType) * size)) {
+			pointer = nullptr;
+		}
+#endif
+		if (!pointer) {
+			std::cout << "Exit in " << __FILE__ << " in line " << __LINE__ << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+
+		return static_cast<ElementType*>(pointer);
+	}
+
+	/**
+		Releases an array which has been allocated with alignedAllocate
+
+		@param[in] pointer Pointer to the aligned array
+	*/
+	template<typename ElementType> inline void alignedFree(ElementType* pointer)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+
+	/**
+		Returns true if the pointer is aligned to UTILS_ALIGNMENT
+
+		@param[in] pointer Pointer
+		@return True if the pointer is aligned
+	*/
+	inline bool isAligned(const void* pointer)
+	{
+		return !(reinterpret_cast<std::uintptr_t>(pointer) % UTILS_ALIGNMENT);
+	}
+
+	/**
+		Returns the pointer with the hint that it is aligned to UTILS_ALIGNMENT, so that loops over 
+		the array can be vectorized with aligned loads, the caller has to check the alignment
+
+		@param[in] pointer Pointer which is aligned
+		@return Pointer
+	*/
+	template<typename ElementType> inline ElementType* assumeAligned(ElementType* pointer)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<ElementType*>(__builtin_assume_aligned(pointer, UTILS_ALIGNMENT));
+#else
+		return pointer;
+#endif
+	}
+
+	/**
+		Returns the number of elements of a row which has been padded to a multiple of 
+		UTILS_ALIGNMENT bytes, so that every row of a padded array starts aligned
+
+		@param[in] cols Number of elements of the row
+		@return Number of elements of the padded row
+	*/
+	template<typename ElementType> inline size_t getPaddedStride(size_t cols)
+	{
+		const size_t bytes = ((sizeof(ElementType) * cols + UTILS_ALIGNMENT - 1) / UTILS_ALIGNMENT) * UTILS_ALIGNMENT;
+
+		return bytes % sizeof(ElementType) ? cols : bytes / sizeof(ElementType);
+	}
+}
+
+#endif /* UTILS_ALIGNEDMEMORY_H_ */
@@ -34,6 +34,8 @@
 #ifndef UTILS_ALLOCATOR_H_
 #define UTILS_ALLOCATOR_H_
 
+#include "tools/utils/memorytracker.h"
+
 namespace utils
 {
 
@@ -55,7 +57,7 @@ namespace utils
 
 			blocks = 0;
 			remaining = 0;
-			usedMemory = 0;
+			used_memory = 0;
 		}
 
 		/**
@@ -76,6 +78,26 @@ namespace utils
 		*/
 		virtual void* allocate(size_t size_) = 0;
 
+		/**
+			Get the number of bytes of the allocated blocks
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			return blocks * (blocksize + sizeof(void*));
+		}
+
+		/**
+			Get the number of bytes which has been handed out
+
+			@return Number of bytes
+		*/
+		size_t getRequestedMemory() const
+		{
+			return used_memory;
+		}
+
 	protected:
 
 		/**
@@ -101,7 +123,7 @@ namespace utils
 		/**
 			Number of bytes which has been already used
 		*/
-		size_t usedMemory;
+		size_t used_memory;
 	};
 
 	class PooledAllocator : public Allocator
@@ -134,10 +156,13 @@ namespace utils
 				delete[] current_base;
 				current_base = prev;
 			}
+			UTILS_MEMORY_FREE(MemoryTag::ALLOCATOR, usedMemory());
+
 			base = nullptr;
 			loc = nullptr;
+			blocks = 0;
 			remaining = 0;
-			usedMemory = 0;
+			used_memory = 0;
 		}
 
 		/**
@@ -164,6 +189,8 @@ namespace utils
 
 				blocks++;
 				remaining = blocksize - sizeof(void*);
+
+				UTILS_MEMORY_ALLOCATE(MemoryTag::ALLOCATOR, blocksize + sizeof(void*));
 			}
 
 			/**
@@ -173,7 +200,7 @@ namespace utils
 			loc = (char*)loc + size_;
 
 			remaining -= size_;
-			usedMemory += size_;
+			used_memory += size_;
 
 			return return_loc;
 		}
@@ -32,9 +32,10 @@
 #ifndef UTILS_DIST_H_
 #define UTILS_DIST_H_
 
+#include <cmath>
+
 namespace utils
 {
-
 	/**
 		Structure which computes L1-Distances
 	*/
@@ -50,6 +51,13 @@ namespace utils
 		*/
 		ElementType operator()(ElementType* a_, ElementType* b_, size_t dim_) const
 		{
+			/**
+				Points of pointclouds, which the unrolled loop below would handle in its tail
+			*/
+			if (dim_ == 3) {
+				return std::abs(a_[0] - b_[0]) + std::abs(a_[1] - b_[1]) + std::abs(a_[2] - b_[2]);
+			}
+
 			ElementType result = ElementType();
 			ElementType diff0, diff1, diff2;
 
@@ -139,7 +147,7 @@ namespace utils
 			ElementType result = ElementType();
 			ElementType diff;
 			for (size_t i = 0; i < dim_; i++) {
-				diff = *a_++ - *b_++:
+				diff = *a_++ - *b_++;
 				result += diff*diff;
 			}
 
@@ -194,6 +202,13 @@ namespace utils
 		*/
 		ElementType operator()(ElementType* a_, ElementType* b_, size_t dim_) const
 		{
+			if (dim_ == 3) {
+				ElementType diff0 = a_[0] - b_[0];
+				ElementType diff1 = a_[1] - b_[1];
+				ElementType diff2 = a_[2] - b_[2];
+				return diff0*diff0 + diff1*diff1 + diff2*diff2;
+			}
+
 			ElementType result = ElementType();
 			ElementType diff0, diff1, diff2;
 
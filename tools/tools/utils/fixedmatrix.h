@@ -0,0 +1,399 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_FIXEDMATRIX_H_
+#define UTILS_FIXEDMATRIX_H_
+
+#include <initializer_list>
+
+#include "tools/utils/matrixexpression.h"
+
+namespace utils
+{
+	/**
+		Matrix with a size known at compile time whose elements are stored inline. Points, normals 
+		and small matrices of the geometry code do not allocate memory, all loops have a constant 
+		length and are unrolled by the compiler. A fixed matrix is a matrix expression and can be 
+		combined with and converted to instances of class Matrix.
+	*/
+	template<typename ElementType, size_t Rows, size_t Cols>
+	class FixedMatrix : public MatrixExpression<FixedMatrix<ElementType, Rows, Cols>, ElementType>
+	{
+	public:
+
+		/**
+			Constructor
+		*/
+		FixedMatrix()
+		{
+			reset();
+		}
+
+		/**
+			Constructor
+
+			@param[in] data Row-array with rows x cols elements which will be copied
+		*/
+		explicit FixedMatrix(const ElementType* data)
+		{
+			for (size_t i = 0; i < Rows * Cols; i++) {
+				data_[i] = data[i];
+			}
+		}
+
+		/**
+			Constructor
+
+			@param[in] data Initializer list
+		*/
+		FixedMatrix(std::initializer_list<ElementType> data)
+		{
+			if (data.size() != Rows * Cols) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			ElementType* it = data_;
+			for (auto it_data = data.begin(); it_data != data.end(); it_data++) {
+				*it = *it_data;
+				it++;
+			}
+		}
+
+		/**
+			Constructor, evaluates a matrix expression with the same size, e.g. an instance of class 
+			Matrix
+
+			@param[in] expression Matrix expression
+		*/
+		template<typename Derived> FixedMatrix(const MatrixExpression<Derived, ElementType>& expression)
+		{
+			const Derived& expr = expression.derived();
+			if (expr.getRows() != Rows || expr.getCols() != Cols) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			assign(expr);
+		}
+
+		/**
+			Operator = Evaluates a matrix expression with the same size
+
+			@param[in] expression Matrix expression
+			@return Returns reference to the current instance
+		*/
+		template<typename Derived> FixedMatrix<ElementType, Rows, Cols>& operator=(const MatrixExpression<Derived, ElementType>& expression)
+		{
+			const Derived& expr = expression.derived();
+			if (expr.getRows() != Rows || expr.getCols() != Cols) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			if (expr.references(data_)) {
+				*this = FixedMatrix<ElementType, Rows, Cols>(expr);
+			}
+			else {
+				assign(expr);
+			}
+
+			return *this;
+		}
+
+		/**
+			Reset the data-array
+		*/
+		void reset()
+		{
+			for (size_t i = 0; i < Rows * Cols; i++) {
+				data_[i] = ElementType();
+			}
+		}
+
+		/**
+			Returns the number of rows
+
+			@return Number of rows
+		*/
+		size_t getRows() const
+		{
+			return Rows;
+		}
+
+		/**
+			Returns the number of columns
+
+			@return Number of columns
+		*/
+		size_t getCols() const
+		{
+			return Cols;
+		}
+
+		/**
+			Returns the first value
+		*/
+		ElementType getValue() const
+		{
+			return data_[0];
+		}
+
+		/**
+			Returns a specific value
+
+			@param[in] row Row
+			@param[in] col Column
+			@return Value
+		*/
+		inline ElementType operator()(size_t row, size_t col) const
+		{
+			return data_[row * Cols + col];
+		}
+
+		/**
+			Return the pointer of the indexth row
+
+			@param[in] index Index of the row
+			@return Returns the pointer of the indexth row
+		*/
+		inline ElementType* operator[](size_t index)
+		{
+			return data_ + index * Cols;
+		}
+
+		/**
+			Return the pointer of the indexth row
+
+			@param[in] index Index of the row
+			@return Returns the pointer of the indexth row
+		*/
+		inline const ElementType* operator[](size_t index) const
+		{
+			return data_ + index * Cols;
+		}
+
+		/**
+			Returns the pointer of data_
+
+			@return Pointer of data_
+		*/
+		ElementType* getPtr()
+		{
+			return data_;
+		}
+
+		/**
+			Returns the pointer of data_
+
+			@return Pointer of data_
+		*/
+		const ElementType* getPtr() const
+		{
+			return data_;
+		}
+
+		/**
+			Returns a pointer to the first entry of data_
+
+			@return Pointer to the first entry of data_
+		*/
+		ElementType* begin()
+		{
+			return data_;
+		}
+
+		/**
+			Returns a pointer to the last entry + 1 of data_
+
+			@return Pointer to the last entry + 1 of data_
+		*/
+		ElementType* end()
+		{
+			return data_ + Rows * Cols;
+		}
+
+		/**
+			Returns true if the matrix is stored in a certain array
+
+			@param[in] data Array
+			@return True if the array is the data-array of the matrix
+		*/
+		bool references(const ElementType* data) const
+		{
+			return data_ == data;
+		}
+
+		/**
+			Transpose the matrix
+
+			@return Transpose of the matrix
+		*/
+		FixedMatrix<ElementType, Cols, Rows> transpose() const
+		{
+			FixedMatrix<ElementType, Cols, Rows> matrix_new;
+			for (size_t row = 0; row < Rows; row++) {
+				for (size_t col = 0; col < Cols; col++) {
+					matrix_new[col][row] = data_[row * Cols + col];
+				}
+			}
+
+			return matrix_new;
+		}
+
+		/**
+			Operator+= Add a matrix to the matrix
+
+			@param[in] expression Matrix expression, a mxn- or 1xn-matrix
+			@return Solution
+		*/
+		template<typename Derived> FixedMatrix<ElementType, Rows, Cols>& operator+=(const MatrixExpression<Derived, ElementType>& expression)
+		{
+			return (*this) = (*this) + expression;
+		}
+
+		/**
+			Operator-= Subtract a matrix from the matrix
+
+			@param[in] expression Matrix expression, a mxn- or 1xn-matrix
+			@return Solution
+		*/
+		template<typename Derived> FixedMatrix<ElementType, Rows, Cols>& operator-=(const MatrixExpression<Derived, ElementType>& expression)
+		{
+			return (*this) = (*this) - expression;
+		}
+
+		/**
+			Operator+= Add a scalar to the matrix
+
+			@param[in] a Scalar
+			@return Solution
+		*/
+		FixedMatrix<ElementType, Rows, Cols>& operator+=(ElementType a)
+		{
+			for (size_t i = 0; i < Rows * Cols; i++) {
+				data_[i] += a;
+			}
+
+			return (*this);
+		}
+
+		/**
+			Operator-= Subtract a scalar from the matrix
+
+			@param[in] a Scalar
+			@return Solution
+		*/
+		FixedMatrix<ElementType, Rows, Cols>& operator-=(ElementType a)
+		{
+			return (*this) += (-1) * a;
+		}
+
+		/**
+			Operator*= Multiply the matrix with a scalar
+
+			@param[in] a Scalar
+			@return Solution
+		*/
+		FixedMatrix<ElementType, Rows, Cols>& operator*=(ElementType a)
+		{
+			for (size_t i = 0; i < Rows * Cols; i++) {
+				data_[i] *= a;
+			}
+
+			return (*this);
+		}
+
+		/**
+			Operator/= Divide the matrix with a scalar
+
+			@param[in] a Scalar
+			@return Solution
+		*/
+		FixedMatrix<ElementType, Rows, Cols>& operator/=(ElementType a)
+		{
+			return (*this) *= ((ElementType)1 / a);
+		}
+
+	private:
+
+		/**
+			Evaluates a matrix expression with the size of the matrix into the data-array
+
+			@param[in] expression Matrix expression
+		*/
+		template<typename Derived> void assign(const Derived& expression)
+		{
+			for (size_t row = 0; row < Rows; row++) {
+				for (size_t col = 0; col < Cols; col++) {
+					data_[row * Cols + col] = expression(row, col);
+				}
+			}
+		}
+
+		/**
+			Data-array
+		*/
+		ElementType data_[Rows * Cols];
+	};
+
+	/**
+		Fixed matrices are stored by reference in matrix expressions
+	*/
+	template<typename ElementType, size_t Rows, size_t Cols> struct MatrixOperand<FixedMatrix<ElementType, Rows, Cols>>
+	{
+		typedef const FixedMatrix<ElementType, Rows, Cols>& type;
+	};
+
+	/**
+		Operator* Multiply a rxk-matrix with a kxc-matrix, the loops are unrolled by the compiler
+
+		@param[in] left Left operand
+		@param[in] right Right operand
+		@return Product
+	*/
+	template<typename ElementType, size_t Rows, size_t Inner, size_t Cols>
+	inline FixedMatrix<ElementType, Rows, Cols> operator*(
+		const FixedMatrix<ElementType, Rows, Inner>& left, const FixedMatrix<ElementType, Inner, Cols>& right)
+	{
+		FixedMatrix<ElementType, Rows, Cols> matrix_new;
+		for (size_t i = 0; i < Rows; i++) {
+			for (size_t k = 0; k < Inner; k++) {
+				ElementType value = left(i, k);
+				for (size_t j = 0; j < Cols; j++) {
+					matrix_new[i][j] += value * right(k, j);
+				}
+			}
+		}
+
+		return matrix_new;
+	}
+}
+
+#endif /* UTILS_FIXEDMATRIX_H_ */
@@ -0,0 +1,369 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_MAPPEDFILE_H_
+#define UTILS_MAPPEDFILE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <stdlib.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace utils
+{
+	/**
+		Access rights of a file mapping
+	*/
+	enum struct MappingMode
+	{
+		/**
+			The file has to exist and is mapped read-only
+		*/
+		READ = 0,
+
+		/**
+			The file is created or extended if necessary, changes are written back to the file
+		*/
+		READ_WRITE = 1
+	};
+
+	/**
+		Expected access pattern of a memory range, which is passed to the kernel as hint
+	*/
+	enum struct AccessPattern
+	{
+		/**
+			No special treatment
+		*/
+		NORMAL = 0,
+
+		/**
+			Pages are read ahead aggressively and dropped soon after they have been accessed
+		*/
+		SEQUENTIAL = 1,
+
+		/**
+			Read ahead is disabled
+		*/
+		RANDOM = 2,
+
+		/**
+			Pages will be accessed soon and are read in the background
+		*/
+		WILLNEED = 3,
+
+		/**
+			Pages will not be accessed soon and may be released
+		*/
+		DONTNEED = 4
+	};
+
+	/**
+		Get the granularity of the offsets of file mappings, the page size or the allocation 
+		granularity on Windows
+
+		@return Granularity in bytes
+	*/
+	inline size_t getMappingGranularity()
+	{
+#if defined(_WIN32)
+		SYSTEM_INFO system_info;
+		GetSystemInfo(&system_info);
+		return system_info.dwAllocationGranularity;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	/**
+		Maps a part of a file into memory, the mapping starts at the largest multiple of the 
+		mapping granularity which does not exceed the offset
+
+		@param[in] filename Name of the file
+		@param[in] bytes Number of bytes which are mapped
+		@param[in] mode Access rights of the mapping
+		@param[in] offset Position of the first mapped byte in the file
+		@return Pointer to the byte at the offset or nullptr if the file cannot be mapped
+	*/
+	inline void* mapFile(const std::string& filename, size_t bytes, MappingMode mode, size_t offset = 0)
+	{
+		if (!bytes) {
+			return nullptr;
+		}
+
+		const bool read_only = mode == MappingMode::READ;
+		const size_t begin = offset - offset % getMappingGranularity();
+		const size_t end = offset + bytes;
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(filename.c_str(), 
+			read_only ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, 
+			FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, 
+			read_only ? OPEN_EXISTING : OPEN_ALWAYS, 
+			FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return nullptr;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || (read_only && (size_t)size.QuadPart < end)) {
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, read_only ? PAGE_READONLY : PAGE_READWRITE,
+			(DWORD)((uint64_t)end >> 32), (DWORD)((uint64_t)end & 0xffffffff), nullptr);
+		void* pointer = mapping ? MapViewOfFile(mapping, read_only ? FILE_MAP_READ : FILE_MAP_WRITE, 
+			(DWORD)((uint64_t)begin >> 32), (DWORD)((uint64_t)begin & 0xffffffff), end - begin) : nullptr;
+
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+
+		return pointer ? (char*)pointer + (offset - begin) : nullptr;
+#else
+		int file = open(filename.c_str(), read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+		if (file < 0) {
+			return nullptr;
+		}
+
+		struct stat status;
+		if (fstat(file, &status) || 
+			(read_only && (size_t)status.st_size < end) ||
+			(!read_only && (size_t)status.st_size < end && ftruncate(file, end))) {
+			close(file);
+			return nullptr;
+		}
+
+		void* pointer = mmap(nullptr, end - begin, read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, file, begin);
+		close(file);
+
+		return pointer == MAP_FAILED ? nullptr : (char*)pointer + (offset - begin);
+#endif
+	}
+
+	/**
+		Get the directory of temporary files of the system, TMPDIR or /tmp on POSIX systems
+
+		@return Directory
+	*/
+	inline std::string getTemporaryDirectory()
+	{
+#if defined(_WIN32)
+		char path[MAX_PATH + 1];
+		DWORD length = GetTempPathA(MAX_PATH + 1, path);
+		return length && length <= MAX_PATH ? std::string(path, length) : std::string(".");
+#else
+		const char* path = getenv("TMPDIR");
+		return path && *path ? std::string(path) : std::string("/tmp");
+#endif
+	}
+
+	/**
+		Maps a new zero-filled temporary file into memory, the file is deleted when the memory is 
+		unmapped
+
+		@param[in] directory Directory of the file, the temporary directory of the system if empty
+		@param[in] bytes Number of bytes
+		@return Pointer to the mapped memory or nullptr if the file cannot be created
+	*/
+	inline void* mapTemporaryFile(const std::string& directory, size_t bytes)
+	{
+		if (!bytes) {
+			return nullptr;
+		}
+
+		const std::string path = directory.empty() ? getTemporaryDirectory() : directory;
+
+#if defined(_WIN32)
+		char filename[MAX_PATH];
+		if (!GetTempFileNameA(path.c_str(), "mat", 0, filename)) {
+			return nullptr;
+		}
+
+		HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			DeleteFileA(filename);
+			return nullptr;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+			(DWORD)((uint64_t)bytes >> 32), (DWORD)((uint64_t)bytes & 0xffffffff), nullptr);
+		void* pointer = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, bytes) : nullptr;
+
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+
+		return pointer;
+#else
+		std::string filename = path + "/matrix_XXXXXX";
+		int file = mkstemp(&filename[0]);
+		if (file < 0) {
+			return nullptr;
+		}
+		unlink(filename.c_str());
+
+		if (ftruncate(file, bytes)) {
+			close(file);
+			return nullptr;
+		}
+
+		void* pointer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		close(file);
+
+		return pointer == MAP_FAILED ? nullptr : pointer;
+#endif
+	}
+
+	/**
+		Unmaps memory which has been mapped with mapFile or mapTemporaryFile
+
+		@param[in] pointer Pointer which has been returned by the mapping
+		@param[in] bytes Number of bytes which have been requested
+	*/
+	inline void unmapFile(void* pointer, size_t bytes)
+	{
+		if (!pointer) {
+			return;
+		}
+
+		const uintptr_t offset = (uintptr_t)pointer % getMappingGranularity();
+#if defined(_WIN32)
+		UnmapViewOfFile((char*)pointer - offset);
+#else
+		munmap((char*)pointer - offset, bytes + offset);
+#endif
+	}
+
+	/**
+		Passes the expected access pattern of a memory range to the kernel, the range is extended 
+		to whole pages. The hints are ignored on Windows.
+
+		@param[in] pointer Pointer to the memory
+		@param[in] bytes Number of bytes
+		@param[in] pattern Expected access pattern
+	*/
+	inline void adviseMemory(void* pointer, size_t bytes, AccessPattern pattern)
+	{
+#if !defined(_WIN32)
+		if (!pointer || !bytes) {
+			return;
+		}
+
+		const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+		const uintptr_t begin = (uintptr_t)pointer & ~(page - 1);
+		const uintptr_t end = (uintptr_t)pointer + bytes;
+
+		int advice = MADV_NORMAL;
+		switch (pattern) {
+		case AccessPattern::NORMAL: advice = MADV_NORMAL; break;
+		case AccessPattern::SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+		case AccessPattern::RANDOM: advice = MADV_RANDOM; break;
+		case AccessPattern::WILLNEED: advice = MADV_WILLNEED; break;
+		case AccessPattern::DONTNEED: advice = MADV_DONTNEED; break;
+		}
+		madvise((void*)begin, end - begin, advice);
+#endif
+	}
+
+	/**
+		Get the directory of the files to which large matrices are spilled
+
+		@return Reference to the directory
+	*/
+	inline std::string& getSpillDirectoryRef()
+	{
+		static std::string spill_directory;
+		return spill_directory;
+	}
+
+	/**
+		Get the number of bytes from which matrices are spilled to a file
+
+		@return Reference to the threshold
+	*/
+	inline std::atomic<size_t>& getSpillThresholdRef()
+	{
+		static std::atomic<size_t> spill_threshold(0);
+		return spill_threshold;
+	}
+
+	/**
+		Enables spilling: data-arrays of matrices with at least threshold_ bytes are mapped to 
+		temporary files in directory_ instead of being allocated in RAM, so that intermediates 
+		larger than the main memory are paged by the kernel. Has to be called before the matrices
+		are allocated.
+
+		@param[in] directory_ Directory of the temporary files, e.g. on a local NVMe drive, the 
+			temporary directory of the system if empty
+		@param[in] threshold_ Minimal number of bytes of a spilled data-array, zero disables spilling
+	*/
+	inline void setSpill(const std::string& directory_, size_t threshold_)
+	{
+		getSpillDirectoryRef() = directory_;
+		getSpillThresholdRef() = threshold_;
+	}
+
+	/**
+		Get the number of bytes from which matrices are spilled to a file
+
+		@return Threshold, zero if spilling is disabled
+	*/
+	inline size_t getSpillThreshold()
+	{
+		return getSpillThresholdRef();
+	}
+
+	/**
+		Get the directory of the files to which large matrices are spilled
+
+		@return Directory
+	*/
+	inline const std::string& getSpillDirectory()
+	{
+		return getSpillDirectoryRef();
+	}
+}
+
+#endif /* UTILS_MAPPEDFILE_H_ */
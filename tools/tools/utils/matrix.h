@@ -32,12 +32,48 @@
 #ifndef UTILS_MATRIX_H_
 #define UTILS_MATRIX_H_
 
+#include <algorithm>
+#include <cmath>
 #include <initializer_list>
 
+#include "tools/utils/alignedmemory.h"
+#include "tools/utils/mappedfile.h"
+#include "tools/utils/memorytracker.h"
+#include "tools/utils/parallel.h"
+#include "tools/utils/matrixexpression.h"
+#include "tools/utils/fixedmatrix.h"
+#include "tools/utils/matrixview.h"
+
 namespace utils
 {
+	/**
+		Storage of the data-array of a matrix
+	*/
+	enum struct MatrixStorage
+	{
+		/**
+			Allocated with new[]
+		*/
+		ARRAY = 0,
+
+		/**
+			Allocated with alignedAllocate
+		*/
+		ALIGNED = 1,
+
+		/**
+			Writable mapping of a file
+		*/
+		MAPPED = 2,
+
+		/**
+			Read-only mapping of a file
+		*/
+		MAPPED_READ = 3
+	};
+
 	template <typename ElementType>
-	class Matrix
+	class Matrix : public MatrixExpression<Matrix<ElementType>, ElementType>
 	{
 	public:
 	
@@ -45,7 +81,7 @@ namespace utils
 			Constructor
 		*/
 		Matrix() :
-			rows_(0), cols_(0), data_(nullptr)
+			rows_(0), cols_(0), data_(nullptr), owner_(true), storage_(MatrixStorage::ARRAY)
 		{
 		}
 		
@@ -60,12 +96,11 @@ namespace utils
 			rows_ = rows;
 			cols_ = cols;
 
-			data_ = new ElementType[rows_ * cols_];
-			std::memset(data_, (ElementType)0, sizeof(ElementType) * rows_ * cols_);
+			allocateMemory(true);
 		}
 
 		/**
-			Constructor
+			Constructor, the matrix takes ownership of the row-array which has to be allocated with new[]
 			
 			@param[in] data_ Row-array of a specific Type
 			@param[in] rows_ Rows of the matrix
@@ -77,6 +112,9 @@ namespace utils
 			cols_ = cols;
 
 			data_ = data;
+			if (data_) {
+				UTILS_MEMORY_ALLOCATE(MemoryTag::MATRIX, sizeof(ElementType) * rows_ * cols_);
+			}
 		}
 
 		/**
@@ -91,7 +129,7 @@ namespace utils
 			rows_ = rows;
 			cols_ = cols;
 
-			data_ = new ElementType[rows_ * cols_];
+			allocateMemory();
 			Matrix<ElementType>::Iterator it = begin();
 			auto it_data = data.begin();
 			while (it != end()) {
@@ -110,92 +148,312 @@ namespace utils
 		}
 
 		/**
-			Deletes the data array
+			Returns a matrix which uses a row-array without taking ownership, the array has to outlive 
+			the matrix. Copies of the matrix own their data.
+
+			@param[in] data Row-array of a specific Type
+			@param[in] rows Rows of the matrix
+			@param[in] cols Columns of the matrix
+			@return Matrix which borrows the row-array
 		*/
-		void clearMemory ()
+		static Matrix<ElementType> borrow(ElementType* data, size_t rows, size_t cols)
+		{
+			Matrix<ElementType> matrix;
+			matrix.rows_ = rows;
+			matrix.cols_ = cols;
+			matrix.data_ = data;
+			matrix.owner_ = false;
+
+			return matrix;
+		}
+
+		/**
+			Returns a matrix with an aligned data-array whose elements are not initialized, for 
+			buffers which are overwritten completely
+
+			@param[in] rows Rows of the matrix
+			@param[in] cols Columns of the matrix
+			@return Matrix with an uninitialized data-array
+		*/
+		static Matrix<ElementType> uninitialized(size_t rows, size_t cols)
+		{
+			Matrix<ElementType> matrix;
+			matrix.rows_ = rows;
+			matrix.cols_ = cols;
+			matrix.allocateMemory();
+
+			return matrix;
+		}
+
+		/**
+			Returns a matrix whose data-array is a mapping of a binary file with rows * cols elements
+			in row-major order. A writable mapping creates or extends the file and writes all 
+			changes back to it, the file is unmapped with the matrix.
+
+			@param[in] filename Name of the file
+			@param[in] rows Rows of the matrix
+			@param[in] cols Columns of the matrix
+			@param[in] mode Access rights of the mapping
+			@param[in] offset Position of the first element in the file, e.g. the size of a header
+			@return Matrix which maps the file
+		*/
+		static Matrix<ElementType> mapFile(const std::string& filename, size_t rows, size_t cols, 
+			MappingMode mode = MappingMode::READ, size_t offset = 0)
+		{
+			Matrix<ElementType> matrix;
+			if (!matrix.map(filename, rows, cols, mode, offset)) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			return matrix;
+		}
+
+		/**
+			Replaces the data-array by a mapping of a binary file with rows * cols elements in 
+			row-major order, see mapFile. The elements of a read-only mapping must not be written.
+
+			@param[in] filename Name of the file
+			@param[in] rows Rows of the matrix
+			@param[in] cols Columns of the matrix
+			@param[in] mode Access rights of the mapping
+			@param[in] offset Position of the first element in the file, e.g. the size of a header
+			@return Returns false and leaves the matrix unchanged if the file cannot be mapped
+		*/
+		bool map(const std::string& filename, size_t rows, size_t cols, 
+			MappingMode mode = MappingMode::READ, size_t offset = 0)
 		{
+			ElementType* data = nullptr;
+			if (rows && cols) {
+				data = (ElementType*)utils::mapFile(filename, sizeof(ElementType) * rows * cols, mode, offset);
+				if (!data) {
+					return false;
+				}
+			}
+
+			clearMemory();
+			rows_ = rows;
+			cols_ = cols;
+			data_ = data;
 			if (data_) {
-				delete[] data_;
-				data_ = nullptr;
+				storage_ = mode == MappingMode::READ ? MatrixStorage::MAPPED_READ : MatrixStorage::MAPPED;
+				UTILS_MEMORY_ALLOCATE(MemoryTag::MAPPED, sizeof(ElementType) * rows * cols);
 			}
+
+			return true;
 		}
 
 		/**
-			Copy constructor
+			Passes the expected access pattern of the data-array to the kernel, which controls the 
+			read ahead and the eviction of the pages of mapped matrices
 
-			@param[in] matrix An instance of class Matrix
+			@param[in] pattern Expected access pattern
 		*/
-		Matrix(const Matrix<ElementType>& matrix) : Matrix()
+		void advise(AccessPattern pattern) const
 		{
-			data_ = new ElementType[matrix.getRows()*matrix.getCols()];
+			if (isMapped()) {
+				utils::adviseMemory(data_, sizeof(ElementType) * rows_ * cols_, pattern);
+			}
+		}
+
+		/**
+			Returns true if the data-array is a mapping of a file
 
-			Matrix<ElementType>::Iterator it_cpy = begin();
-			ElementType* it_end = matrix.end();
-			for (Matrix<ElementType>::Iterator it = matrix.begin(); it != it_end; it++) {
-				*it_cpy = *it;
-				it_cpy++;
+			@return True if the data-array is mapped
+		*/
+		bool isMapped() const
+		{
+			return data_ && (storage_ == MatrixStorage::MAPPED || storage_ == MatrixStorage::MAPPED_READ);
+		}
+
+		/**
+			Deletes the data array if it is owned by the matrix
+		*/
+		void clearMemory ()
+		{
+			if (data_ && owner_) {
+				const size_t bytes = sizeof(ElementType) * rows_ * cols_;
+				switch (storage_) {
+				case MatrixStorage::ARRAY:
+					UTILS_MEMORY_FREE(MemoryTag::MATRIX, bytes);
+					delete[] data_;
+					break;
+				case MatrixStorage::ALIGNED:
+					UTILS_MEMORY_FREE(MemoryTag::MATRIX, bytes);
+					utils::alignedFree(data_);
+					break;
+				case MatrixStorage::MAPPED:
+				case MatrixStorage::MAPPED_READ:
+					UTILS_MEMORY_FREE(MemoryTag::MAPPED, bytes);
+					utils::unmapFile(data_, bytes);
+					break;
+				}
 			}
+			data_ = nullptr;
+			owner_ = true;
+			storage_ = MatrixStorage::ARRAY;
+		}
+
+		/**
+			Returns true if the data-array starts at an address aligned to UTILS_ALIGNMENT, which holds 
+			for every data-array allocated by the matrix itself
+
+			@return True if the data-array is aligned
+		*/
+		bool isAligned() const
+		{
+			return utils::isAligned(data_);
+		}
+
+		/**
+			Returns true if the matrix owns its data-array
 
+			@return True if the data-array is deleted with the matrix
+		*/
+		bool isOwner() const
+		{
+			return owner_;
+		}
+
+		/**
+			Copy constructor
+
+			@param[in] matrix An instance of class Matrix
+		*/
+		Matrix(const Matrix<ElementType>& matrix) : Matrix()
+		{
 			rows_ = matrix.getRows();
 			cols_ = matrix.getCols();
+
+			allocateMemory();
+			if (rows_ && cols_) {
+				utils::copyMemory(data_, matrix.getPtr(), sizeof(ElementType) * rows_ * cols_);
+			}
 		}
 		
 		/**
-			Copy constructor
+			Move constructor, takes over the data-array of the other matrix
 
 			@param[in] matrix An instance of class Matrix
 		*/
-		Matrix(const Matrix<ElementType>&& matrix) : Matrix()
+		Matrix(Matrix<ElementType>&& matrix) noexcept :
+			rows_(matrix.rows_), cols_(matrix.cols_), data_(matrix.data_), owner_(matrix.owner_), storage_(matrix.storage_)
 		{
-			*this = matrix;
-		}	
+			matrix.rows_ = 0;
+			matrix.cols_ = 0;
+			matrix.data_ = nullptr;
+			matrix.owner_ = true;
+			matrix.storage_ = MatrixStorage::ARRAY;
+		}
 
 		/**
-			Operator =
+			Operator = The data-array is reused if it is owned and has the size of the other matrix
 	
 			@param[in] matrix An instance of class Matrix
 			@return Returns reference to the current instance
 		*/
 		Matrix<ElementType>& operator=(const Matrix<ElementType>& matrix)
 		{
-			clearMemory();
+			if (this == &matrix) {
+				return *this;
+			}
 
-			data_ = new ElementType[matrix.getRows()*matrix.getCols()];
-			
-			Matrix<ElementType>::Iterator it_cpy = begin();
-			ElementType* it_end = matrix.end();
-			for (Matrix<ElementType>::Iterator it = matrix.begin(); it != it_end; it++) {
-				*it_cpy = *it;
-				it_cpy++;
+			if (!isWritableOwner() || rows_ * cols_ != matrix.getRows() * matrix.getCols()) {
+				clearMemory();
+				rows_ = matrix.getRows();
+				cols_ = matrix.getCols();
+				allocateMemory();
 			}
 
 			rows_ = matrix.getRows();
 			cols_ = matrix.getCols();
+			if (rows_ && cols_) {
+				utils::copyMemory(data_, matrix.getPtr(), sizeof(ElementType) * rows_ * cols_);
+			}
 
 			return *this;
 		}
 
 		/**
-			Operator =
+			Operator = Move assignment, takes over the data-array of the other matrix
 	
 			@param[in] matrix An instance of class Matrix
 			@return Returns reference to the current instance
 		*/
-		Matrix<ElementType>& operator=(const Matrix<ElementType>&& matrix)
+		Matrix<ElementType>& operator=(Matrix<ElementType>&& matrix) noexcept
 		{
-			clearMemory();
+			if (this != &matrix) {
+				clearMemory();
+
+				rows_ = matrix.rows_;
+				cols_ = matrix.cols_;
+				data_ = matrix.data_;
+				owner_ = matrix.owner_;
+				storage_ = matrix.storage_;
+
+				matrix.rows_ = 0;
+				matrix.cols_ = 0;
+				matrix.data_ = nullptr;
+				matrix.owner_ = true;
+				matrix.storage_ = MatrixStorage::ARRAY;
+			}
+
+			return *this;
+		}
+
+		/**
+			Constructor, evaluates a matrix expression
 
-			*this = matrix;
+			@param[in] expression Matrix expression
+		*/
+		template<typename Derived> Matrix(const MatrixExpression<Derived, ElementType>& expression) : Matrix()
+		{
+			const Derived& expr = expression.derived();
+
+			rows_ = expr.getRows();
+			cols_ = expr.getCols();
+
+			allocateMemory();
+			assign(expr);
+		}
+
+		/**
+			Operator = Evaluates a matrix expression, the data-array is reused if it is owned, has the 
+			size of the result and is not read by the expression
+
+			@param[in] expression Matrix expression
+			@return Returns reference to the current instance
+		*/
+		template<typename Derived> Matrix<ElementType>& operator=(const MatrixExpression<Derived, ElementType>& expression)
+		{
+			const Derived& expr = expression.derived();
+
+			if (isWritableOwner() && rows_ == expr.getRows() && cols_ == expr.getCols() && !expr.references(data_)) {
+				assign(expr);
+			}
+			else {
+				*this = Matrix<ElementType>(expr);
+			}
 
 			return *this;
 		}
 
+		/**
+			Get the number of bytes of the data-array which are allocated in RAM, mapped files are
+			not counted
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			return data_ && owner_ && !isMapped() ? sizeof(ElementType) * rows_ * cols_ : 0;
+		}
+
 		/**
 			Reset the data-array
 		*/
 		void reset()
 		{
-			std::memset(data_, (ElementType)0, sizeof(ElementType) * rows_ * cols_);
+			utils::initializeMemory(data_, sizeof(ElementType) * rows_ * cols_);
 		}
 
 		/**
@@ -211,8 +469,7 @@ namespace utils
 			rows_ = rows;
 			cols_ = cols;
 
-			data_ = new ElementType[rows_ * cols_];
-			std::memset(data_, (ElementType)0, sizeof(ElementType) * rows_ * cols_);
+			allocateMemory(true);
 		}
 
 		/**
@@ -230,6 +487,9 @@ namespace utils
 			cols_ = cols;
 
 			data_ = data;
+			if (data_) {
+				UTILS_MEMORY_ALLOCATE(MemoryTag::MATRIX, sizeof(ElementType) * rows_ * cols_);
+			}
 		}
 
 		/**
@@ -246,7 +506,7 @@ namespace utils
 			rows_ = rows;
 			cols_ = cols;
 
-			data_ = new ElementType[rows_ * cols_];
+			allocateMemory();
 			Matrix<ElementType>::Iterator it = begin();
 			auto it_data = data.begin();
 			while (it != end()) {
@@ -376,6 +636,29 @@ namespace utils
 			return cols_;
 		}
 
+		/**
+			Returns a specific value
+
+			@param[in] row Row
+			@param[in] col Column
+			@return Value
+		*/
+		inline ElementType operator()(size_t row, size_t col) const
+		{
+			return data_[row * cols_ + col];
+		}
+
+		/**
+			Returns true if the matrix is stored in a certain array
+
+			@param[in] data Array
+			@return True if the array is the data-array of the matrix
+		*/
+		bool references(const ElementType* data) const
+		{
+			return data_ && data_ == data;
+		}
+
 		/**
 			Returns the first value
 		*/
@@ -406,6 +689,62 @@ namespace utils
 			return Matrix<ElementType>(getAllocatedColPtr(col), rows_, 1);
 		}
 
+		/**
+			Get a view of the matrix
+
+			@return View of the matrix
+		*/
+		MatrixView<ElementType> getView() const
+		{
+			return MatrixView<ElementType>(data_, rows_, cols_, cols_, 1);
+		}
+
+		/**
+			Get a view of a specific row as column vector, without copying
+
+			@param[in] row Row
+			@return View with cols x 1 elements
+		*/
+		MatrixView<ElementType> getRowView(size_t row) const
+		{
+			return getView().getRowView(row);
+		}
+
+		/**
+			Get a view of a specific column, without copying
+
+			@param[in] col Column
+			@return View with rows x 1 elements
+		*/
+		MatrixView<ElementType> getColView(size_t col) const
+		{
+			return getView().getColView(col);
+		}
+
+		/**
+			Get a view of a block, without copying
+
+			@param[in] row First row of the block
+			@param[in] col First column of the block
+			@param[in] rows Rows of the block
+			@param[in] cols Columns of the block
+			@return View of the block
+		*/
+		MatrixView<ElementType> getBlockView(size_t row, size_t col, size_t rows, size_t cols) const
+		{
+			return getView().getBlockView(row, col, rows, cols);
+		}
+
+		/**
+			Get a view of the transposed matrix, without copying
+
+			@return Transposed view
+		*/
+		MatrixView<ElementType> getTransposeView() const
+		{
+			return getView().transpose();
+		}
+
 		/**
 			Get matrix of another type
 		*/
@@ -456,13 +795,18 @@ namespace utils
 				exitFailure(__FILE__, __LINE__);
 			}
 
-			ElementType* data_new = new ElementType[rows_ * cols_ + matrix.getRows() * matrix.getCols()];
-			std:memcpy(data_new, data_, sizeof(ElementType) * rows_ * cols_);
-
-			ElementType* data_new_ptr = data_new + rows_ * cols_;
-			std::memcpy(data_new_ptr, matrix.getPtr(), sizeof(ElementType) * matrix.getRows() * matrix.getCols());
+			Matrix<ElementType> concatenated;
+			concatenated.rows_ = rows_ + matrix.getRows();
+			concatenated.cols_ = cols_;
+			concatenated.allocateMemory();
+			if (rows_ && cols_) {
+				std::memcpy(concatenated.getPtr(), data_, sizeof(ElementType) * rows_ * cols_);
+			}
+			if (matrix.getRows() && matrix.getCols()) {
+				std::memcpy(concatenated.getPtr() + rows_ * cols_, matrix.getPtr(), sizeof(ElementType) * matrix.getRows() * matrix.getCols());
+			}
 
-			return Matrix<ElementType>(data_new, rows_ + matrix.getRows(), cols_);
+			return concatenated;
 		}
 
 		/**
@@ -478,7 +822,7 @@ namespace utils
 				exitFailure(__FILE__, __LINE__);
 			}
 
-			Matrix<ElementType> matrix_left = transpose();
+			Matrix<ElementType> matrix_left = this->transpose();
 			Matrix<ElementType> matrix_right = matrix.transpose();
 
 			return matrix_left.concatenateRow(matrix_right).transpose();
@@ -652,28 +996,6 @@ namespace utils
 			ElementType* iterator_;
 		};
 
-		/**
-			Operator+ Adds a scalar to the matrix
-
-			@param[in] a Scalar
-			@return Solution
-		*/
-		Matrix<ElementType> operator+(ElementType a) const
-		{
-			Matrix<ElementType> matrix_new(rows_, cols_);
-
-			Matrix<ElementType>::Iterator it = begin();
-			Matrix<ElementType>::Iterator it_matrix_new = matrix_new.begin();
-
-			while (it != end()) {
-				*it_matrix_new = *it + a;
-				it_matrix_new++;
-				it++;
-			}
-
-			return matrix_new;
-		}
-
 		/**
 			Operator+= Add a scalar to the matrix
 
@@ -692,17 +1014,6 @@ namespace utils
 			return (*this);
 		}
 
-		/**
-			Operator- Subtract a scalar from the matrix
-
-			@param[in] a Scalar
-			@return Solution
-		*/
-		Matrix<ElementType> operator-(ElementType a) const
-		{
-			return (*this) + (-1) * a;
-		}	
-				
 		/**
 			Operator- Subtract a scalar from th matrix
 
@@ -717,96 +1028,53 @@ namespace utils
 		}
 
 		/**
-			Operator+ Add a matrix to the matrix
+			Operator+= Add a matrix to the matrix
 
-			@param[in] matrix An instance of class Matrix
+			@param[in] expression Matrix expression, a mxn- or 1xn-matrix
 			@return Solution
 		*/
-		Matrix<ElementType> operator+(const Matrix<ElementType>& matrix) const
+		template<typename Derived> Matrix<ElementType>& operator+=(const MatrixExpression<Derived, ElementType>& expression)
 		{
-			Matrix<ElementType> matrix_new(rows_, cols_);
-			
-			Matrix<ElementType>::Iterator it = begin();
-			Matrix<ElementType>::Iterator it_matrix_new = matrix_new.begin();
-			/**
-				Add a mxn-matrix to the mxn matrix
-			*/
-			if (rows_ == matrix.getRows() && cols_ == matrix.getCols()) {
-				Matrix<ElementType>::Iterator it_matrix = matrix.begin();
-
-				while (it != end()) {
-					*it_matrix_new = *it + *it_matrix;
-					it_matrix_new++;
-					it_matrix++;
-					it++;
-				}
-			}
-			/**
-				Add 1xn-matrix to the mxn-matrix
-			*/
-			else if (matrix.getRows() == 1 && cols_ == matrix.getCols()) {
-				for (size_t i = 0; i < rows_*cols_; i++) {
-					*it_matrix_new = *it + matrix[0][i % matrix.getCols()];
-					it_matrix_new++;
-					it++;
-				}
-			}
-			else {
-				exitFailure(__FILE__, __LINE__);
-			}
-
-			return matrix_new;
+			return compoundAssign<MatrixAdd>(expression.derived());
 		}
 
+	private:
+
 		/**
-			Operator+= Add a matrix to the matrix
+			Evaluates a matrix expression with the size of the matrix into the data-array
 
-			@param[in] matrix An instance of class Matrix
-			@return Solution
+			@param[in] expression Matrix expression
 		*/
-		Matrix<ElementType>& operator+=(const Matrix<ElementType>& matrix)
+		template<typename Derived> void assign(const Derived& expression)
 		{
-			Matrix<ElementType>::Iterator it = begin();
-			/**
-				Add a mxn-matrix to the mxn matrix
-			*/
-			if (rows_ == matrix.getRows() && cols_ == matrix.getCols()) {
-				Matrix<ElementType>::Iterator it_matrix = matrix.begin();
-
-				while (it != end()) {
-					*it += *it_matrix;
-					it_matrix++;
-					it++;
-				}
-			}
-			/**
-				Add 1xn-matrix to the mxn-matrix
-			*/
-			else if (matrix.getRows() == 1 && cols_ == matrix.getCols()) {
-				for (size_t i = 0; i < rows_*cols_; i++) {
-					*it += matrix[0][i % matrix.getCols()];
+			ElementType* it = data_;
+			for (size_t row = 0; row < rows_; row++) {
+				for (size_t col = 0; col < cols_; col++) {
+					*it = expression(row, col);
 					it++;
 				}
 			}
-			else {
-				exitFailure(__FILE__, __LINE__);
-			}
-
-			return (*this);
 		}
 
 		/**
-			Operator- Subtract a matrix from the matrix
+			Applies an element-wise operation with a matrix expression to the matrix, the result is 
+			evaluated in a temporary matrix if the expression reads from the data-array
 
-			@param[in] matrix An instance of class Matrix
+			@param[in] expression Matrix expression, a mxn- or 1xn-matrix
 			@return Solution
 		*/
-		Matrix<ElementType> operator-(const Matrix<ElementType>& matrix) const
+		template<typename Operation, typename Derived> Matrix<ElementType>& compoundAssign(const Derived& expression)
 		{
-			return (*this) + matrix*(-1);
-		}
+			MatrixBinary<Matrix<ElementType>, Derived, Operation, ElementType> binary(*this, expression);
+			if (expression.references(data_)) {
+				*this = Matrix<ElementType>(binary);
+			}
+			else {
+				assign(binary);
+			}
 
-	private:
+			return (*this);
+		}
 
 		/**
 			Add a row to the matrix
@@ -861,72 +1129,14 @@ namespace utils
 	public:
 
 		/**
-			Operator- Subtract a matrix from the matrix
+			Operator-= Subtract a matrix from the matrix
 
-			@param[in] matrix An instance of class Matrix
+			@param[in] expression Matrix expression, a mxn- or 1xn-matrix
 			@return Solution
 		*/
-		Matrix<ElementType>& operator-=(const Matrix<ElementType>& matrix)
+		template<typename Derived> Matrix<ElementType>& operator-=(const MatrixExpression<Derived, ElementType>& expression)
 		{
-			*this += matrix * (-1);
-			
-			return (*this);
-		}
-
-		/**
-			Operator* Multiply two matrices
-
-			@param[in] matrix An instance of class Matrix
-			@return Solution
-		*/
-		Matrix<ElementType> operator*(const Matrix<ElementType>& matrix) const
-		{
-			Matrix<ElementType> matrix_new(rows_, matrix.getCols());
-			/**
-				Multiply a nxm-matrix with a mxo-matrix
-			*/
-			if (cols_ == matrix.getRows()) {
-				size_t index_left = 0, index_right = 0;
-				for (Matrix<ElementType>::Iterator it = matrix_new.begin(); it != matrix_new.end(); it++) {
-					for (size_t i = 0; i < cols_; i++) {
-						*it += (*this)[index_left][i] * matrix[i][index_right];
-					}
-					if (index_right != matrix.getCols() - 1) {
-						index_right++;
-					}
-					else {
-						index_right = 0;
-						index_left++;
-					}
-				}
-			}
-			/**
-				Multiply a nx1-vector with a nxm-matrix
-			*/
-			else if (rows_ == matrix.getRows() && cols_ == 1) {
-				Matrix<ElementType>::Iterator it = begin();
-				Matrix<ElementType>::Iterator it_matrix = matrix.begin();
-				Matrix<ElementType>::Iterator it_matrix_new = matrix_new.begin();
-				size_t index = 0;	
-				while (it_matrix != matrix.end()) {
-					*it_matrix_new = *it_matrix *  *it;
-					if (index == matrix.getCols() - 1) {
-						index = 0;
-						it++;
-					}
-					else {
-						index++;
-					}
-					it_matrix_new++;
-					it_matrix++;
-				}
-			}
-			else {
-				exitFailure(__FILE__, __LINE__);
-			}
-
-			return matrix_new;
-
+			return compoundAssign<MatrixSubtract>(expression.derived());
 		}
 
 		/**
@@ -942,27 +1152,6 @@ namespace utils
 			return (*this);
 		}
 
-		/**
-			Operator* Multiply a matrix with a scalar
-
-			@param[in] a Scalar
-			@return Solution
-		*/
-		Matrix<ElementType> operator*(ElementType a) const
-		{
-			Matrix<ElementType> matrix_new(rows_, cols_);
-		
-			Matrix<ElementType>::Iterator it = begin();
-			Matrix<ElementType>::Iterator it_matrix_new = matrix_new.begin();
-			while(it != end()){
-				*it_matrix_new = *it*a;
-				it++;
-				it_matrix_new++;
-			}
-
-			return matrix_new;
-		}
-
 		/**
 			Operator*= Multiply a matrix with a scalar
 
@@ -979,17 +1168,6 @@ namespace utils
 			return (*this);
 		}
 
-		/**
-			Operator/ Divide the matrix with a scalar
-
-			@param[in] a Scalar
-			@return Solution
-		*/
-		Matrix<ElementType> operator/(ElementType a) const
-		{
-			return (*this) * ((ElementType)1 / a);
-		}
-
 		/**
 			Operator/= Divide the matrix with a scalar
 
@@ -1003,23 +1181,6 @@ namespace utils
 			return (*this);
 		}
 
-		/**
-			Transpose the matrix
-
-			@return Transpose of the matrix
-		*/
-		Matrix<ElementType> transpose() const
-		{
-			Matrix<ElementType> matrix_new(cols_, rows_);
-			for (size_t row = 0; row < rows_; row++) {
-				for (size_t col = 0; col < cols_; col++) {
-					matrix_new[col][row] = (*this)[row][col];
-				}
-			}
-			
-			return matrix_new;
-		}
-
 		/**
 			Invert the matrix
 
@@ -1031,15 +1192,44 @@ namespace utils
 				exitFailure(__FILE__, __LINE__);
 			}
 
-			Matrix<ElementType> inv(rows_, cols_);
-			Matrix<ElementType> equation_left = (*this);
-			for (size_t i = 0; i < cols_; i++) {
-				Matrix<ElementType> equation_right(rows_, 1);
-				equation_right[i][0] = (ElementType) 1.0;
+			/**
+				Gauss-Jordan elimination with partial pivoting on the matrix and the identity at once
+			*/
+			const size_t n = rows_;
+			Matrix<ElementType> matrix = (*this);
+			Matrix<ElementType> inv(n, n);
+			for (size_t i = 0; i < n; i++) {
+				inv[i][i] = (ElementType) 1.0;
+			}
+
+			for (size_t j = 0; j < n; j++) {
+				size_t pivot = j;
+				for (size_t i = j + 1; i < n; i++) {
+					if (std::abs(matrix[i][j]) > std::abs(matrix[pivot][j])) {
+						pivot = i;
+					}
+				}
+				if (pivot != j) {
+					std::swap_ranges(matrix[j], matrix[j] + n, matrix[pivot]);
+					std::swap_ranges(inv[j], inv[j] + n, inv[pivot]);
+				}
 
-				Matrix<ElementType> equation = equation_left.concatenateCol(equation_right);
+				ElementType scale = (ElementType) 1.0 / matrix[j][j];
+				for (size_t k = 0; k < n; k++) {
+					matrix[j][k] *= scale;
+					inv[j][k] *= scale;
+				}
 
-				inv.setColMatrix(equation.gaussJordanElimination(), i);
+				for (size_t i = 0; i < n; i++) {
+					ElementType factor = matrix[i][j];
+					if (i == j || factor == 0) {
+						continue;
+					}
+					for (size_t k = 0; k < n; k++) {
+						matrix[i][k] -= factor * matrix[j][k];
+						inv[i][k] -= factor * inv[j][k];
+					}
+				}
 			}
 
 			return inv;
@@ -1121,6 +1311,48 @@ namespace utils
 				matrix[0][i] = (*this)[i][i];
 			}
 		}
+
+	private:
+
+		/**
+			Allocates an owned data-array of rows_ * cols_ elements which is aligned to UTILS_ALIGNMENT,
+			large data-arrays are mapped to a temporary file if spilling is enabled
+
+			@param[in] initialize Flag whether the data-array is set to zero
+		*/
+		void allocateMemory(bool initialize = false)
+		{
+			const size_t bytes = sizeof(ElementType) * rows_ * cols_;
+			owner_ = true;
+
+			const size_t threshold = utils::getSpillThreshold();
+			if (threshold && bytes >= threshold) {
+				data_ = (ElementType*)utils::mapTemporaryFile(utils::getSpillDirectory(), bytes);
+				if (data_) {
+					storage_ = MatrixStorage::MAPPED;
+					UTILS_MEMORY_ALLOCATE(MemoryTag::MAPPED, bytes);
+					return;
+				}
+			}
+
+			data_ = utils::alignedAllocate<ElementType>(rows_ * cols_);
+			storage_ = MatrixStorage::ALIGNED;
+			UTILS_MEMORY_ALLOCATE(MemoryTag::MATRIX, bytes);
+			if (initialize && data_) {
+				utils::initializeMemory(data_, bytes);
+			}
+		}
+
+		/**
+			Returns true if the matrix owns a data-array which may be overwritten
+
+			@return True if the data-array can be reused
+		*/
+		bool isWritableOwner() const
+		{
+			return data_ && owner_ && storage_ != MatrixStorage::MAPPED_READ;
+		}
+
 	public:
 
 		/** 
@@ -1137,6 +1369,16 @@ namespace utils
 			Pointer to data 
 		*/ 
 		ElementType* data_; 
+
+		/**
+			Flag whether the data-array is owned by the matrix
+		*/
+		bool owner_;
+
+		/**
+			Storage of the owned data-array
+		*/
+		MatrixStorage storage_;
 	};
 
 	template<typename ElementType>
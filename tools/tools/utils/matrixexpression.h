@@ -0,0 +1,519 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_MATRIXEXPRESSION_H_
+#define UTILS_MATRIXEXPRESSION_H_
+
+#include <stddef.h>
+
+#include "tools/utils/matrixproduct.h"
+
+namespace utils
+{
+	template<typename ElementType> class Matrix;
+
+	template<typename Operand, typename ElementType> class MatrixTranspose;
+
+	/**
+		Base of all matrix expressions. The arithmetic operators of matrices do not compute their
+		result but return an expression which holds its operands, the expression is evaluated 
+		element by element in a single loop when it is assigned to a matrix. Chained operations
+		therefore need neither temporary matrices nor additional passes over the data.
+
+		Matrices are held by reference, so an expression must be evaluated within the statement in
+		which it has been created.
+	*/
+	template<typename Derived, typename ElementType>
+	class MatrixExpression
+	{
+	public:
+
+		/**
+			Get the derived expression
+
+			@return Derived expression
+		*/
+		const Derived& derived() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+
+		/**
+			Returns the first value
+
+			@return First value
+		*/
+		ElementType getValue() const
+		{
+			return derived()(0, 0);
+		}
+
+		/**
+			Transpose the expression
+
+			@return Transposed expression
+		*/
+		MatrixTranspose<Derived, ElementType> transpose() const
+		{
+			return MatrixTranspose<Derived, ElementType>(derived());
+		}
+
+		/**
+			Evaluates the expression
+
+			@return Matrix with the result
+		*/
+		Matrix<ElementType> eval() const
+		{
+			return Matrix<ElementType>(*this);
+		}
+	};
+
+	/**
+		Type which is used to store an operand of an expression, matrices are stored by reference 
+		and expressions by value
+	*/
+	template<typename Operand> struct MatrixOperand
+	{
+		typedef const Operand type;
+	};
+
+	template<typename ElementType> struct MatrixOperand<Matrix<ElementType>>
+	{
+		typedef const Matrix<ElementType>& type;
+	};
+
+	/**
+		Prevents the deduction of a template parameter from a scalar argument, so that scalars of 
+		other types are converted
+	*/
+	template<typename Type> struct NonDeduced
+	{
+		typedef Type type;
+	};
+
+	/**
+		Addition of two elements
+	*/
+	struct MatrixAdd
+	{
+		template<typename ElementType> static ElementType apply(ElementType a_, ElementType b_)
+		{
+			return a_ + b_;
+		}
+	};
+
+	/**
+		Subtraction of two elements
+	*/
+	struct MatrixSubtract
+	{
+		template<typename ElementType> static ElementType apply(ElementType a_, ElementType b_)
+		{
+			return a_ - b_;
+		}
+	};
+
+	/**
+		Multiplication of two elements
+	*/
+	struct MatrixMultiply
+	{
+		template<typename ElementType> static ElementType apply(ElementType a_, ElementType b_)
+		{
+			return a_ * b_;
+		}
+	};
+
+	/**
+		Element-wise operation of two matrices with the same size, or of a mxn-matrix and a
+		1xn-matrix whose row is applied to every row
+	*/
+	template<typename Left, typename Right, typename Operation, typename ElementType>
+	class MatrixBinary : public MatrixExpression<MatrixBinary<Left, Right, Operation, ElementType>, ElementType>
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] left_ Left operand
+			@param[in] right_ Right operand
+		*/
+		MatrixBinary(const Left& left_, const Right& right_) : left(left_), right(right_), broadcast(false)
+		{
+			if (left.getCols() != right.getCols()) {
+				exitFailure(__FILE__, __LINE__);
+			}
+			if (left.getRows() != right.getRows()) {
+				if (right.getRows() != 1) {
+					exitFailure(__FILE__, __LINE__);
+				}
+				broadcast = true;
+			}
+		}
+
+		size_t getRows() const
+		{
+			return left.getRows();
+		}
+
+		size_t getCols() const
+		{
+			return left.getCols();
+		}
+
+		ElementType operator()(size_t row_, size_t col_) const
+		{
+			return Operation::apply(left(row_, col_), right(broadcast ? 0 : row_, col_));
+		}
+
+		/**
+			Returns true if the expression reads from a certain array
+
+			@param[in] data_ Array
+			@return True if the expression reads from the array
+		*/
+		bool references(const ElementType* data_) const
+		{
+			return left.references(data_) || right.references(data_);
+		}
+
+	private:
+
+		/**
+			Left operand
+		*/
+		typename MatrixOperand<Left>::type left;
+
+		/**
+			Right operand
+		*/
+		typename MatrixOperand<Right>::type right;
+
+		/**
+			Flag whether the row of the right operand is applied to every row
+		*/
+		bool broadcast;
+	};
+
+	/**
+		Element-wise operation of a matrix and a scalar
+	*/
+	template<typename Operand, typename Operation, typename ElementType>
+	class MatrixScalar : public MatrixExpression<MatrixScalar<Operand, Operation, ElementType>, ElementType>
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] operand_ Operand
+			@param[in] scalar_ Scalar
+		*/
+		MatrixScalar(const Operand& operand_, ElementType scalar_) : operand(operand_), scalar(scalar_)
+		{
+		}
+
+		size_t getRows() const
+		{
+			return operand.getRows();
+		}
+
+		size_t getCols() const
+		{
+			return operand.getCols();
+		}
+
+		ElementType operator()(size_t row_, size_t col_) const
+		{
+			return Operation::apply(operand(row_, col_), scalar);
+		}
+
+		bool references(const ElementType* data_) const
+		{
+			return operand.references(data_);
+		}
+
+	private:
+
+		/**
+			Operand
+		*/
+		typename MatrixOperand<Operand>::type operand;
+
+		/**
+			Scalar
+		*/
+		ElementType scalar;
+	};
+
+	/**
+		Transpose of a matrix
+	*/
+	template<typename Operand, typename ElementType>
+	class MatrixTranspose : public MatrixExpression<MatrixTranspose<Operand, ElementType>, ElementType>
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] operand_ Operand
+		*/
+		MatrixTranspose(const Operand& operand_) : operand(operand_)
+		{
+		}
+
+		size_t getRows() const
+		{
+			return operand.getCols();
+		}
+
+		size_t getCols() const
+		{
+			return operand.getRows();
+		}
+
+		ElementType operator()(size_t row_, size_t col_) const
+		{
+			return operand(col_, row_);
+		}
+
+		bool references(const ElementType* data_) const
+		{
+			return operand.references(data_);
+		}
+
+		/**
+			Returns the transposed operand
+
+			@return Operand
+		*/
+		const Operand& getOperand() const
+		{
+			return operand;
+		}
+
+	private:
+
+		/**
+			Operand
+		*/
+		typename MatrixOperand<Operand>::type operand;
+	};
+
+	/**
+		Operator+ Add two matrices
+
+		@param[in] left_ Left operand
+		@param[in] right_ Right operand, a mxn- or 1xn-matrix
+		@return Expression of the sum
+	*/
+	template<typename Left, typename Right, typename ElementType>
+	inline MatrixBinary<Left, Right, MatrixAdd, ElementType> operator+(
+		const MatrixExpression<Left, ElementType>& left_, const MatrixExpression<Right, ElementType>& right_)
+	{
+		return MatrixBinary<Left, Right, MatrixAdd, ElementType>(left_.derived(), right_.derived());
+	}
+
+	/**
+		Operator- Subtract two matrices
+
+		@param[in] left_ Left operand
+		@param[in] right_ Right operand, a mxn- or 1xn-matrix
+		@return Expression of the difference
+	*/
+	template<typename Left, typename Right, typename ElementType>
+	inline MatrixBinary<Left, Right, MatrixSubtract, ElementType> operator-(
+		const MatrixExpression<Left, ElementType>& left_, const MatrixExpression<Right, ElementType>& right_)
+	{
+		return MatrixBinary<Left, Right, MatrixSubtract, ElementType>(left_.derived(), right_.derived());
+	}
+
+	/**
+		Operator+ Add a scalar to the matrix
+
+		@param[in] operand_ Matrix
+		@param[in] a Scalar
+		@return Expression of the sum
+	*/
+	template<typename Operand, typename ElementType>
+	inline MatrixScalar<Operand, MatrixAdd, ElementType> operator+(
+		const MatrixExpression<Operand, ElementType>& operand_, typename NonDeduced<ElementType>::type a)
+	{
+		return MatrixScalar<Operand, MatrixAdd, ElementType>(operand_.derived(), a);
+	}
+
+	/**
+		Operator- Subtract a scalar from the matrix
+
+		@param[in] operand_ Matrix
+		@param[in] a Scalar
+		@return Expression of the difference
+	*/
+	template<typename Operand, typename ElementType>
+	inline MatrixScalar<Operand, MatrixAdd, ElementType> operator-(
+		const MatrixExpression<Operand, ElementType>& operand_, typename NonDeduced<ElementType>::type a)
+	{
+		return MatrixScalar<Operand, MatrixAdd, ElementType>(operand_.derived(), (-1) * a);
+	}
+
+	/**
+		Operator* Multiply a matrix with a scalar
+
+		@param[in] operand_ Matrix
+		@param[in] a Scalar
+		@return Expression of the product
+	*/
+	template<typename Operand, typename ElementType>
+	inline MatrixScalar<Operand, MatrixMultiply, ElementType> operator*(
+		const MatrixExpression<Operand, ElementType>& operand_, typename NonDeduced<ElementType>::type a)
+	{
+		return MatrixScalar<Operand, MatrixMultiply, ElementType>(operand_.derived(), a);
+	}
+
+	/**
+		Operator/ Divide the matrix with a scalar
+
+		@param[in] operand_ Matrix
+		@param[in] a Scalar
+		@return Expression of the quotient
+	*/
+	template<typename Operand, typename ElementType>
+	inline MatrixScalar<Operand, MatrixMultiply, ElementType> operator/(
+		const MatrixExpression<Operand, ElementType>& operand_, typename NonDeduced<ElementType>::type a)
+	{
+		return MatrixScalar<Operand, MatrixMultiply, ElementType>(operand_.derived(), (ElementType)1 / a);
+	}
+
+	/**
+		Operator* Multiply two matrices, the product is computed immediately. A nxm-matrix is 
+		multiplied with a mxo-matrix, a nx1-vector with a nxm-matrix scales the rows of the matrix.
+
+		@param[in] left_ Left operand
+		@param[in] right_ Right operand
+		@return Product
+	*/
+	template<typename Left, typename Right, typename ElementType>
+	inline Matrix<ElementType> operator*(
+		const MatrixExpression<Left, ElementType>& left_, const MatrixExpression<Right, ElementType>& right_)
+	{
+		const Left& left = left_.derived();
+		const Right& right = right_.derived();
+
+		Matrix<ElementType> matrix_new(left.getRows(), right.getCols());
+		/**
+			Multiply a nxm-matrix with a mxo-matrix
+		*/
+		if (left.getCols() == right.getRows()) {
+			for (size_t i = 0; i < left.getRows(); i++) {
+				ElementType* row = matrix_new[i];
+				for (size_t k = 0; k < left.getCols(); k++) {
+					ElementType value = left(i, k);
+					for (size_t j = 0; j < right.getCols(); j++) {
+						row[j] += value * right(k, j);
+					}
+				}
+			}
+		}
+		/**
+			Multiply a nx1-vector with a nxm-matrix
+		*/
+		else if (left.getRows() == right.getRows() && left.getCols() == 1) {
+			for (size_t i = 0; i < left.getRows(); i++) {
+				ElementType* row = matrix_new[i];
+				ElementType value = left(i, 0);
+				for (size_t j = 0; j < right.getCols(); j++) {
+					row[j] = right(i, j) * value;
+				}
+			}
+		}
+		else {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		return matrix_new;
+	}
+
+	/**
+		Operator* Multiply two matrices with a cache-blocked kernel. A nxm-matrix is multiplied with
+		a mxo-matrix, a nx1-vector with a nxm-matrix scales the rows of the matrix.
+
+		@param[in] left Left operand
+		@param[in] right Right operand
+		@return Product
+	*/
+	template<typename ElementType>
+	inline Matrix<ElementType> operator*(const Matrix<ElementType>& left, const Matrix<ElementType>& right)
+	{
+		if (left.getCols() != right.getRows()) {
+			return static_cast<const MatrixExpression<Matrix<ElementType>, ElementType>&>(left) * right;
+		}
+
+		Matrix<ElementType> matrix_new(left.getRows(), right.getCols());
+		multiply<ElementType>(left.getPtr(), right.getPtr(), matrix_new.getPtr(), left.getRows(), left.getCols(), right.getCols());
+
+		return matrix_new;
+	}
+
+	/**
+		Operator* Multiply a transposed nxm-matrix with a nxo-matrix, the product is accumulated row by
+		row of both matrices without transposing the left one. The product of a transposed matrix with
+		itself is symmetric and only its upper triangle is computed.
+
+		@param[in] left Left operand
+		@param[in] right Right operand
+		@return Product
+	*/
+	template<typename ElementType>
+	inline Matrix<ElementType> operator*(const MatrixTranspose<Matrix<ElementType>, ElementType>& left, const Matrix<ElementType>& right)
+	{
+		if (left.getCols() != right.getRows()) {
+			return static_cast<const MatrixExpression<MatrixTranspose<Matrix<ElementType>, ElementType>, ElementType>&>(left) * right;
+		}
+
+		Matrix<ElementType> matrix_new(left.getRows(), right.getCols());
+		if (left.references(right.getPtr())) {
+			multiplyTransposeWeighted<ElementType>(right.getPtr(), nullptr, matrix_new.getPtr(), right.getRows(), right.getCols());
+		}
+		else {
+			const Matrix<ElementType>& matrix = left.getOperand();
+			multiplyTransposeWeighted<ElementType>(matrix.getPtr(), nullptr, right.getPtr(), matrix_new.getPtr(), 
+				matrix.getRows(), matrix.getCols(), right.getCols());
+		}
+
+		return matrix_new;
+	}
+}
+
+#endif /* UTILS_MATRIXEXPRESSION_H_ */
@@ -0,0 +1,324 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_MATRIXPRODUCT_H_
+#define UTILS_MATRIXPRODUCT_H_
+
+#include <stddef.h>
+
+#ifdef UTILS_EIGEN
+#include "eigen3/Eigen/Dense"
+#endif
+
+namespace utils
+{
+	template<typename ElementType> class Matrix;
+
+	template<typename Derived, typename ElementType> class MatrixExpression;
+
+	/**
+		Number of rows of the left matrix which are multiplied at once, the corresponding row of the 
+		right matrix is loaded once for all of them
+	*/
+	const size_t PRODUCT_BLOCK_ROWS = 4;
+
+	/**
+		Number of rows of the right matrix in a block, PRODUCT_BLOCK_INNER x PRODUCT_BLOCK_COLS 
+		elements of the right matrix should fit into the L2 cache
+	*/
+	const size_t PRODUCT_BLOCK_INNER = 128;
+
+	/**
+		Number of columns of the right matrix in a block
+	*/
+	const size_t PRODUCT_BLOCK_COLS = 256;
+
+	/**
+		Adds the product of a block of the left and right matrix to the rows of the result, the 
+		loops over the columns are contiguous and are vectorized by the compiler
+
+		@param[in] a Left matrix, row-array
+		@param[in] b Right matrix, row-array
+		@param[in] c Result, row-array
+		@param[in] row_begin First row of the left matrix
+		@param[in] row_end Last row + 1 of the left matrix
+		@param[in] inner_begin First column of the left matrix
+		@param[in] inner_end Last column + 1 of the left matrix
+		@param[in] col_begin First column of the right matrix
+		@param[in] col_end Last column + 1 of the right matrix
+		@param[in] inner Columns of the left matrix
+		@param[in] cols Columns of the right matrix
+	*/
+	template<typename ElementType> inline void multiplyBlock(
+		const ElementType* __restrict a, const ElementType* __restrict b, ElementType* __restrict c,
+		size_t row_begin, size_t row_end, size_t inner_begin, size_t inner_end, size_t col_begin, size_t col_end,
+		size_t inner, size_t cols)
+	{
+		size_t width = col_end - col_begin;
+
+		size_t row = row_begin;
+		for (; row + PRODUCT_BLOCK_ROWS <= row_end; row += PRODUCT_BLOCK_ROWS) {
+			ElementType* c0 = c + row * cols + col_begin;
+			ElementType* c1 = c0 + cols;
+			ElementType* c2 = c1 + cols;
+			ElementType* c3 = c2 + cols;
+			const ElementType* a0 = a + row * inner;
+			const ElementType* a1 = a0 + inner;
+			const ElementType* a2 = a1 + inner;
+			const ElementType* a3 = a2 + inner;
+			for (size_t k = inner_begin; k < inner_end; k++) {
+				const ElementType* b_row = b + k * cols + col_begin;
+				ElementType v0 = a0[k], v1 = a1[k], v2 = a2[k], v3 = a3[k];
+				for (size_t col = 0; col < width; col++) {
+					ElementType value = b_row[col];
+					c0[col] += v0 * value;
+					c1[col] += v1 * value;
+					c2[col] += v2 * value;
+					c3[col] += v3 * value;
+				}
+			}
+		}
+		for (; row < row_end; row++) {
+			ElementType* c0 = c + row * cols + col_begin;
+			const ElementType* a0 = a + row * inner;
+			for (size_t k = inner_begin; k < inner_end; k++) {
+				const ElementType* b_row = b + k * cols + col_begin;
+				ElementType v0 = a0[k];
+				for (size_t col = 0; col < width; col++) {
+					c0[col] += v0 * b_row[col];
+				}
+			}
+		}
+	}
+
+	/**
+		Computes the product of a mxk-matrix and a kxn-matrix. The right matrix is traversed in 
+		blocks which stay in the cache, the summation order of every element is the same as of the
+		unblocked product.
+
+		@param[in] a Left matrix, row-array
+		@param[in] b Right matrix, row-array
+		@param[in] c Result, row-array initialized with zeros
+		@param[in] rows Rows of the left matrix
+		@param[in] inner Columns of the left matrix
+		@param[in] cols Columns of the right matrix
+	*/
+	template<typename ElementType> inline void multiply(
+		const ElementType* a, const ElementType* b, ElementType* c,
+		size_t rows, size_t inner, size_t cols)
+	{
+#ifdef UTILS_EIGEN
+		typedef Eigen::Matrix<ElementType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> EigenMatrix;
+		Eigen::Map<EigenMatrix>(c, rows, cols).noalias() += 
+			Eigen::Map<const EigenMatrix>(a, rows, inner) * Eigen::Map<const EigenMatrix>(b, inner, cols);
+#else
+		for (size_t inner_begin = 0; inner_begin < inner; inner_begin += PRODUCT_BLOCK_INNER) {
+			size_t inner_end = inner_begin + PRODUCT_BLOCK_INNER < inner ? inner_begin + PRODUCT_BLOCK_INNER : inner;
+			for (size_t col_begin = 0; col_begin < cols; col_begin += PRODUCT_BLOCK_COLS) {
+				size_t col_end = col_begin + PRODUCT_BLOCK_COLS < cols ? col_begin + PRODUCT_BLOCK_COLS : cols;
+				multiplyBlock(a, b, c, 0, rows, inner_begin, inner_end, col_begin, col_end, inner, cols);
+			}
+		}
+#endif
+	}
+
+	/**
+		Computes the symmetric product A'PA of a nxm-matrix A and a diagonal weight matrix P. Only 
+		the upper triangle is accumulated row by row of A and mirrored afterwards.
+
+		@param[in] a Matrix A, row-array
+		@param[in] weights Diagonal of P, nullptr if P is the identity
+		@param[in] c Result, mxm row-array initialized with zeros
+		@param[in] rows Rows of A
+		@param[in] cols Columns of A
+	*/
+	template<typename ElementType> inline void multiplyTransposeWeighted(
+		const ElementType* __restrict a, const ElementType* __restrict weights, ElementType* __restrict c,
+		size_t rows, size_t cols)
+	{
+#ifdef UTILS_EIGEN
+		typedef Eigen::Matrix<ElementType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> EigenMatrix;
+		typedef Eigen::Matrix<ElementType, Eigen::Dynamic, 1> EigenVector;
+		Eigen::Map<const EigenMatrix> map_a(a, rows, cols);
+		Eigen::Map<EigenMatrix> map_c(c, cols, cols);
+		if (weights) {
+			map_c.noalias() += map_a.transpose() * (Eigen::Map<const EigenVector>(weights, rows).asDiagonal() * map_a);
+		}
+		else {
+			map_c.noalias() += map_a.transpose() * map_a;
+		}
+#else
+		for (size_t row = 0; row < rows; row++) {
+			const ElementType* a_row = a + row * cols;
+			ElementType weight = weights ? weights[row] : (ElementType)1;
+			for (size_t i = 0; i < cols; i++) {
+				ElementType value = weight * a_row[i];
+				ElementType* c_row = c + i * cols;
+				for (size_t j = i; j < cols; j++) {
+					c_row[j] += value * a_row[j];
+				}
+			}
+		}
+		for (size_t i = 0; i < cols; i++) {
+			for (size_t j = 0; j < i; j++) {
+				c[i * cols + j] = c[j * cols + i];
+			}
+		}
+#endif
+	}
+
+	/**
+		Computes the product A'Pl of a nxm-matrix A, a diagonal weight matrix P and a nxk-matrix l
+
+		@param[in] a Matrix A, row-array
+		@param[in] weights Diagonal of P, nullptr if P is the identity
+		@param[in] l Matrix l, row-array
+		@param[in] c Result, mxk row-array initialized with zeros
+		@param[in] rows Rows of A
+		@param[in] cols Columns of A
+		@param[in] cols_l Columns of l
+	*/
+	template<typename ElementType> inline void multiplyTransposeWeighted(
+		const ElementType* __restrict a, const ElementType* __restrict weights, const ElementType* __restrict l, 
+		ElementType* __restrict c, size_t rows, size_t cols, size_t cols_l)
+	{
+		for (size_t row = 0; row < rows; row++) {
+			const ElementType* a_row = a + row * cols;
+			const ElementType* l_row = l + row * cols_l;
+			ElementType weight = weights ? weights[row] : (ElementType)1;
+			for (size_t i = 0; i < cols; i++) {
+				ElementType value = weight * a_row[i];
+				ElementType* c_row = c + i * cols_l;
+				for (size_t j = 0; j < cols_l; j++) {
+					c_row[j] += value * l_row[j];
+				}
+			}
+		}
+	}
+
+	/**
+		Computes the product A'A
+
+		@param[in] a Matrix A
+		@return Product A'A
+	*/
+	template<typename ElementType> Matrix<ElementType> transposeProduct(const Matrix<ElementType>& a)
+	{
+		Matrix<ElementType> product(a.getCols(), a.getCols());
+		multiplyTransposeWeighted<ElementType>(a.getPtr(), nullptr, product.getPtr(), a.getRows(), a.getCols());
+
+		return product;
+	}
+
+	/**
+		Computes the product A'PA with a diagonal weight matrix P
+
+		@param[in] a Matrix A, a nxm-matrix
+		@param[in] weights Diagonal of P, a nx1-matrix
+		@return Product A'PA
+	*/
+	template<typename ElementType> Matrix<ElementType> transposeProduct(const Matrix<ElementType>& a, const Matrix<ElementType>& weights)
+	{
+		if (weights.getRows() != a.getRows()) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		Matrix<ElementType> product(a.getCols(), a.getCols());
+		multiplyTransposeWeighted<ElementType>(a.getPtr(), weights.getPtr(), product.getPtr(), a.getRows(), a.getCols());
+
+		return product;
+	}
+
+	/**
+		Computes the product A'Pl with a diagonal weight matrix P
+
+		@param[in] a Matrix A, a nxm-matrix
+		@param[in] weights Diagonal of P, a nx1-matrix
+		@param[in] l Matrix l, a nxk-matrix
+		@return Product A'Pl
+	*/
+	template<typename ElementType> Matrix<ElementType> transposeProduct(const Matrix<ElementType>& a, const Matrix<ElementType>& weights, const Matrix<ElementType>& l)
+	{
+		if (weights.getRows() != a.getRows() || l.getRows() != a.getRows()) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		Matrix<ElementType> product(a.getCols(), l.getCols());
+		multiplyTransposeWeighted<ElementType>(a.getPtr(), weights.getPtr(), l.getPtr(), product.getPtr(), a.getRows(), a.getCols(), l.getCols());
+
+		return product;
+	}
+
+	/**
+		Builds the augmented matrix [A'PA | A'Pl] of the normal equations of a weighted least 
+		squares adjustment in a single pass over A
+
+		@param[in] a Design matrix A, a nxm-matrix
+		@param[in] weights Diagonal of the weight matrix P, a nx1-matrix
+		@param[in] observation Observation vector l, a nx1-matrix expression, e.g. a column view
+		@return Augmented mx(m+1)-matrix
+	*/
+	template<typename ElementType, typename Derived> Matrix<ElementType> normalEquations(const Matrix<ElementType>& a, const Matrix<ElementType>& weights, const MatrixExpression<Derived, ElementType>& observation)
+	{
+		const Derived& l = observation.derived();
+
+		if (weights.getRows() != a.getRows() || l.getRows() != a.getRows() || l.getCols() != 1) {
+			exitFailure(__FILE__, __LINE__);
+		}
+
+		size_t cols = a.getCols();
+		Matrix<ElementType> system(cols, cols + 1);
+		ElementType* c = system.getPtr();
+		for (size_t row = 0; row < a.getRows(); row++) {
+			const ElementType* a_row = a[row];
+			ElementType weight = weights[row][0];
+			ElementType value_l = l(row, 0);
+			for (size_t i = 0; i < cols; i++) {
+				ElementType value = weight * a_row[i];
+				ElementType* c_row = c + i * (cols + 1);
+				for (size_t j = i; j < cols; j++) {
+					c_row[j] += value * a_row[j];
+				}
+				c_row[cols] += value * value_l;
+			}
+		}
+		for (size_t i = 0; i < cols; i++) {
+			for (size_t j = 0; j < i; j++) {
+				c[i * (cols + 1) + j] = c[j * (cols + 1) + i];
+			}
+		}
+
+		return system;
+	}
+}
+
+#endif /* UTILS_MATRIXPRODUCT_H_ */
@@ -0,0 +1,312 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_MATRIXVIEW_H_
+#define UTILS_MATRIXVIEW_H_
+
+#include "tools/utils/matrixexpression.h"
+
+namespace utils
+{
+	/**
+		Non-owning view of the elements of a matrix, the elements are addressed with a row and a 
+		column stride. Rows, columns, blocks and transposes of a matrix can be read and written 
+		without copying them. A view is a matrix expression, it can be used in arithmetic and is
+		converted to an instance of class Matrix when a copy is needed. The viewed storage has to
+		outlive the view.
+	*/
+	template<typename ElementType>
+	class MatrixView : public MatrixExpression<MatrixView<ElementType>, ElementType>
+	{
+	public:
+
+		/**
+			Constructor
+		*/
+		MatrixView() :
+			data_(nullptr), buffer_(nullptr), rows_(0), cols_(0), row_stride_(0), col_stride_(0)
+		{
+		}
+
+		/**
+			Constructor
+
+			@param[in] data Pointer to the first element of the view
+			@param[in] rows Rows of the view
+			@param[in] cols Columns of the view
+			@param[in] row_stride Distance between two rows in elements
+			@param[in] col_stride Distance between two columns in elements
+			@param[in] buffer Data-array of the viewed matrix, used to detect aliasing
+		*/
+		MatrixView(ElementType* data, size_t rows, size_t cols, size_t row_stride, size_t col_stride, const ElementType* buffer = nullptr) :
+			data_(data), buffer_(buffer ? buffer : data), rows_(rows), cols_(cols), row_stride_(row_stride), col_stride_(col_stride)
+		{
+		}
+
+		/**
+			Operator = Writes a matrix expression with the same size into the viewed elements
+
+			@param[in] expression Matrix expression
+			@return Returns reference to the current instance
+		*/
+		template<typename Derived> MatrixView<ElementType>& operator=(const MatrixExpression<Derived, ElementType>& expression)
+		{
+			const Derived& expr = expression.derived();
+			if (expr.getRows() != rows_ || expr.getCols() != cols_) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			if (expr.references(buffer_)) {
+				Matrix<ElementType> matrix(expr);
+				assign(matrix);
+			}
+			else {
+				assign(expr);
+			}
+
+			return *this;
+		}
+
+		/**
+			Operator = Writes the elements of another view into the viewed elements
+
+			@param[in] view An instance of class MatrixView
+			@return Returns reference to the current instance
+		*/
+		MatrixView<ElementType>& operator=(const MatrixView<ElementType>& view)
+		{
+			return (*this) = static_cast<const MatrixExpression<MatrixView<ElementType>, ElementType>&>(view);
+		}
+
+		/**
+			Copy constructor, the new view refers to the same elements
+
+			@param[in] view An instance of class MatrixView
+		*/
+		MatrixView(const MatrixView<ElementType>& view) = default;
+
+		/**
+			Returns the number of rows
+
+			@return Number of rows
+		*/
+		size_t getRows() const
+		{
+			return rows_;
+		}
+
+		/**
+			Returns the number of columns
+
+			@return Number of columns
+		*/
+		size_t getCols() const
+		{
+			return cols_;
+		}
+
+		/**
+			Returns the distance between two rows in elements
+
+			@return Row stride
+		*/
+		size_t getRowStride() const
+		{
+			return row_stride_;
+		}
+
+		/**
+			Returns the distance between two columns in elements
+
+			@return Column stride
+		*/
+		size_t getColStride() const
+		{
+			return col_stride_;
+		}
+
+		/**
+			Returns the pointer to the first element of the view
+
+			@return Pointer to the first element
+		*/
+		ElementType* getPtr() const
+		{
+			return data_;
+		}
+
+		/**
+			Returns true if the elements of a row are contiguous
+
+			@return True if the column stride is one
+		*/
+		bool isContiguous() const
+		{
+			return col_stride_ == 1 || cols_ <= 1;
+		}
+
+		/**
+			Returns a specific value
+
+			@param[in] row Row
+			@param[in] col Column
+			@return Value
+		*/
+		inline ElementType operator()(size_t row, size_t col) const
+		{
+			return data_[row * row_stride_ + col * col_stride_];
+		}
+
+		/**
+			Returns a reference to a specific element
+
+			@param[in] row Row
+			@param[in] col Column
+			@return Reference to the element
+		*/
+		inline ElementType& operator()(size_t row, size_t col)
+		{
+			return data_[row * row_stride_ + col * col_stride_];
+		}
+
+		/**
+			Returns true if the view refers to the elements of a certain array
+
+			@param[in] data Data-array
+			@return True if the view refers to the array
+		*/
+		bool references(const ElementType* data) const
+		{
+			return buffer_ && buffer_ == data;
+		}
+
+		/**
+			Returns the view of a row as column vector
+
+			@param[in] row Row
+			@return View with cols x 1 elements
+		*/
+		MatrixView<ElementType> getRowView(size_t row) const
+		{
+			return MatrixView<ElementType>(data_ + row * row_stride_, cols_, 1, col_stride_, 0, buffer_);
+		}
+
+		/**
+			Returns the view of a column
+
+			@param[in] col Column
+			@return View with rows x 1 elements
+		*/
+		MatrixView<ElementType> getColView(size_t col) const
+		{
+			return MatrixView<ElementType>(data_ + col * col_stride_, rows_, 1, row_stride_, 0, buffer_);
+		}
+
+		/**
+			Returns the view of a block
+
+			@param[in] row First row of the block
+			@param[in] col First column of the block
+			@param[in] rows Rows of the block
+			@param[in] cols Columns of the block
+			@return View of the block
+		*/
+		MatrixView<ElementType> getBlockView(size_t row, size_t col, size_t rows, size_t cols) const
+		{
+			if (row + rows > rows_ || col + cols > cols_) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			return MatrixView<ElementType>(data_ + row * row_stride_ + col * col_stride_, rows, cols, row_stride_, col_stride_, buffer_);
+		}
+
+		/**
+			Transpose the view, the strides are swapped
+
+			@return Transposed view
+		*/
+		MatrixView<ElementType> transpose() const
+		{
+			return MatrixView<ElementType>(data_, cols_, rows_, col_stride_, row_stride_, buffer_);
+		}
+
+	private:
+
+		/**
+			Writes a matrix expression with the size of the view into the viewed elements
+
+			@param[in] expression Matrix expression
+		*/
+		template<typename Derived> void assign(const Derived& expression)
+		{
+			for (size_t row = 0; row < rows_; row++) {
+				ElementType* it = data_ + row * row_stride_;
+				for (size_t col = 0; col < cols_; col++) {
+					*it = expression(row, col);
+					it += col_stride_;
+				}
+			}
+		}
+
+		/**
+			Pointer to the first element
+		*/
+		ElementType* data_;
+
+		/**
+			Data-array of the viewed matrix
+		*/
+		const ElementType* buffer_;
+
+		/**
+			Rows of the view
+		*/
+		size_t rows_;
+
+		/**
+			Columns of the view
+		*/
+		size_t cols_;
+
+		/**
+			Distance between two rows in elements
+		*/
+		size_t row_stride_;
+
+		/**
+			Distance between two columns in elements
+		*/
+		size_t col_stride_;
+	};
+}
+
+#endif /* UTILS_MATRIXVIEW_H_ */
@@ -0,0 +1,202 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_MEMORYTRACKER_H_
+#define UTILS_MEMORYTRACKER_H_
+
+#include <atomic>
+#include <iostream>
+
+/**
+	The tracking of allocations is enabled by defining UTILS_MEMORY_TRACKING at build time, 
+	otherwise all tracking statements vanish
+*/
+#ifdef UTILS_MEMORY_TRACKING
+	#define UTILS_MEMORY_ALLOCATE(tag_, bytes_) (utils::MemoryTracker::getInstance().allocate((tag_), (bytes_)))
+	#define UTILS_MEMORY_FREE(tag_, bytes_) (utils::MemoryTracker::getInstance().free((tag_), (bytes_)))
+#else
+	#define UTILS_MEMORY_ALLOCATE(tag_, bytes_)
+	#define UTILS_MEMORY_FREE(tag_, bytes_)
+#endif
+
+namespace utils
+{
+	/**
+		Subsystems which allocations are tracked
+	*/
+	enum struct MemoryTag
+	{
+		/**
+			Data of matrices
+		*/
+		MATRIX = 0,
+
+		/**
+			Points, normals, colors and triangles of pointclouds
+		*/
+		POINTCLOUD = 1,
+
+		/**
+			Nodes and indices of the trees
+		*/
+		TREE = 2,
+
+		/**
+			Blocks of the pooled allocators
+		*/
+		ALLOCATOR = 3,
+
+		/**
+			File-backed data of matrices, which is not held in RAM
+		*/
+		MAPPED = 4,
+
+		/**
+			Number of tags
+		*/
+		COUNT = 5
+	};
+
+	/**
+		Process-wide tracker which counts the current and the peak number of allocated bytes of
+		every subsystem
+	*/
+	class MemoryTracker
+	{
+	public:
+
+		/**
+			Get the instance of the tracker
+
+			@return Tracker
+		*/
+		static MemoryTracker& getInstance()
+		{
+			static MemoryTracker tracker;
+			return tracker;
+		}
+
+		/**
+			Adds an allocation
+
+			@param[in] tag_ Subsystem
+			@param[in] bytes_ Number of bytes
+		*/
+		void allocate(MemoryTag tag_, size_t bytes_)
+		{
+			size_t tag = (size_t)tag_;
+			size_t current = current_bytes[tag].fetch_add(bytes_) + bytes_;
+			
+			size_t peak = peak_bytes[tag].load();
+			while (current > peak && !peak_bytes[tag].compare_exchange_weak(peak, current));
+		}
+
+		/**
+			Removes an allocation
+
+			@param[in] tag_ Subsystem
+			@param[in] bytes_ Number of bytes
+		*/
+		void free(MemoryTag tag_, size_t bytes_)
+		{
+			current_bytes[(size_t)tag_].fetch_sub(bytes_);
+		}
+
+		/**
+			Get the number of currently allocated bytes of a subsystem
+
+			@param[in] tag_ Subsystem
+			@return Number of bytes
+		*/
+		size_t getCurrent(MemoryTag tag_) const
+		{
+			return current_bytes[(size_t)tag_];
+		}
+
+		/**
+			Get the maximal number of allocated bytes of a subsystem
+
+			@param[in] tag_ Subsystem
+			@return Number of bytes
+		*/
+		size_t getPeak(MemoryTag tag_) const
+		{
+			return peak_bytes[(size_t)tag_];
+		}
+
+		/**
+			Operator <<, prints the breakdown of the subsystems
+
+			@param[in,out] out_ Outstream
+			@param[in] tracker_ Tracker
+			@return Outstream
+		*/
+		friend std::ostream& operator<<(std::ostream& out_, const MemoryTracker& tracker_)
+		{
+			const char* names[] = { "Matrix", "Pointcloud", "Tree", "Allocator", "Mapped" };
+
+			out_ << "Memory in MB (current / peak)" << std::endl;
+			for (size_t i = 0; i < (size_t)MemoryTag::COUNT; i++) {
+				out_ << names[i] << ": " 
+					<< tracker_.current_bytes[i] / (1024.0 * 1024.0) << " / " 
+					<< tracker_.peak_bytes[i] / (1024.0 * 1024.0) << std::endl;
+			}
+
+			return out_;
+		}
+
+	private:
+
+		/**
+			Constructor
+		*/
+		MemoryTracker()
+		{
+			for (size_t i = 0; i < (size_t)MemoryTag::COUNT; i++) {
+				current_bytes[i] = 0;
+				peak_bytes[i] = 0;
+			}
+		}
+
+		/**
+			Number of currently allocated bytes
+		*/
+		std::atomic<size_t> current_bytes[(size_t)MemoryTag::COUNT];
+
+		/**
+			Maximal number of allocated bytes
+		*/
+		std::atomic<size_t> peak_bytes[(size_t)MemoryTag::COUNT];
+	};
+}
+
+#endif /* UTILS_MEMORYTRACKER_H_ */
@@ -0,0 +1,221 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_MORTON_H_
+#define UTILS_MORTON_H_
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "tools/utils/parallel.h"
+
+namespace utils
+{
+	/**
+		Counts the leading zero bits of a value
+
+		@param[in] value_ Value
+		@return Number of leading zero bits, 64 if the value is zero
+	*/
+	inline int countLeadingZeros(uint64_t value_)
+	{
+		if (!value_) {
+			return 64;
+		}
+
+		int count = 0;
+		if (!(value_ & 0xffffffff00000000ULL)) { count += 32; value_ <<= 32; }
+		if (!(value_ & 0xffff000000000000ULL)) { count += 16; value_ <<= 16; }
+		if (!(value_ & 0xff00000000000000ULL)) { count += 8; value_ <<= 8; }
+		if (!(value_ & 0xf000000000000000ULL)) { count += 4; value_ <<= 4; }
+		if (!(value_ & 0xc000000000000000ULL)) { count += 2; value_ <<= 2; }
+		if (!(value_ & 0x8000000000000000ULL)) { count += 1; }
+		return count;
+	}
+
+	/**
+		Spreads the lower 21 bits of a value, so that two zero bits lie between two consecutive bits
+
+		@param[in] value_ Value
+		@return Spread value
+	*/
+	inline uint64_t mortonSplit3(uint64_t value_)
+	{
+		uint64_t x = value_ & 0x1fffff;
+		x = (x | x << 32) & 0x1f00000000ffff;
+		x = (x | x << 16) & 0x1f0000ff0000ff;
+		x = (x | x << 8) & 0x100f00f00f00f00f;
+		x = (x | x << 4) & 0x10c30c30c30c30c3;
+		x = (x | x << 2) & 0x1249249249249249;
+		return x;
+	}
+
+	/**
+		Interleaves three 21 bit coordinates to a 63 bit morton code
+
+		@param[in] x_ First coordinate
+		@param[in] y_ Second coordinate
+		@param[in] z_ Third coordinate
+		@return Morton code
+	*/
+	inline uint64_t mortonEncode3(uint32_t x_, uint32_t y_, uint32_t z_)
+	{
+		return mortonSplit3(x_) | (mortonSplit3(y_) << 1) | (mortonSplit3(z_) << 2);
+	}
+
+	/**
+		Computes the morton codes of three dimensional points, the coordinates are quantized 
+		with 21 bits per axis with respect to the cubic bounding box of the points
+
+		@param[in] points_ Points
+		@param[in] number_of_elements_ Number of points
+		@param[in] stride_ Number of elements between two consecutive points
+		@param[in,out] codes_ Morton codes
+	*/
+	template<typename ElementType>
+	void computeMortonCodes(const ElementType* points_, 
+		size_t number_of_elements_, 
+		size_t stride_, 
+		std::vector<uint64_t>& codes_)
+	{
+		codes_.resize(number_of_elements_);
+		if (!number_of_elements_) {
+			return;
+		}
+
+		ElementType min[3];
+		ElementType max[3];
+		for (size_t j = 0; j < 3; j++) {
+			min[j] = max[j] = points_[j];
+		}
+		for (size_t i = 1; i < number_of_elements_; i++) {
+			const ElementType* point = points_ + i * stride_;
+			for (size_t j = 0; j < 3; j++) {
+				min[j] = std::min(min[j], point[j]);
+				max[j] = std::max(max[j], point[j]);
+			}
+		}
+
+		double extent = std::max(std::max((double)(max[0] - min[0]), (double)(max[1] - min[1])), (double)(max[2] - min[2]));
+		double scale = extent > 0 ? (double)0x1fffff / extent : 0;
+
+		for (size_t i = 0; i < number_of_elements_; i++) {
+			const ElementType* point = points_ + i * stride_;
+			uint32_t cell[3];
+			for (size_t j = 0; j < 3; j++) {
+				cell[j] = (uint32_t)std::min((double)0x1fffff, (double)(point[j] - min[j]) * scale);
+			}
+			codes_[i] = mortonEncode3(cell[0], cell[1], cell[2]);
+		}
+	}
+
+	/**
+		Sorts 64 bit keys with a least significant digit radix sort and returns the permutation, 
+		the histograms and the scattering of every pass are computed in parallel on contiguous 
+		chunks of the keys, passes where all keys share the same digit are skipped
+
+		@param[in,out] keys_ Keys, which are sorted afterwards
+		@param[in,out] permutation_ Original position of the sorted keys
+		@param[in] cores_ Number of cores
+	*/
+	inline void radixSort(std::vector<uint64_t>& keys_, std::vector<size_t>& permutation_, size_t cores_ = 1)
+	{
+		const size_t bits = 8;
+		const size_t buckets = 1 << bits;
+
+		size_t number_of_elements = keys_.size();
+		permutation_.resize(number_of_elements);
+		for (size_t i = 0; i < number_of_elements; i++) {
+			permutation_[i] = i;
+		}
+
+		size_t chunks = std::max<size_t>(1, std::min(cores_, number_of_elements / 4096 + 1));
+
+		std::vector<uint64_t> keys(number_of_elements);
+		std::vector<size_t> permutation(number_of_elements);
+		std::vector<size_t> histogram(chunks * buckets);
+
+		for (size_t shift = 0; shift < 64; shift += bits) {
+			
+			std::fill(histogram.begin(), histogram.end(), 0);
+			utils::parallelChunks(number_of_elements, chunks, [&](size_t c, size_t begin, size_t end) {
+				size_t* count = &histogram[c * buckets];
+				for (size_t i = begin; i < end; i++) {
+					count[(keys_[i] >> shift) & (buckets - 1)]++;
+				}
+			});
+
+			/**
+				Skip the pass if all keys fall into one bucket
+			*/
+			bool trivial = false;
+			for (size_t b = 0; b < buckets && !trivial; b++) {
+				size_t sum = 0;
+				for (size_t c = 0; c < chunks; c++) {
+					sum += histogram[c * buckets + b];
+				}
+				trivial = sum == number_of_elements;
+			}
+			if (trivial) {
+				continue;
+			}
+
+			/**
+				Exclusive prefix sum over buckets and chunks, so that every chunk scatters into its 
+				own range of every bucket and the sort remains stable
+			*/
+			size_t offset = 0;
+			for (size_t b = 0; b < buckets; b++) {
+				for (size_t c = 0; c < chunks; c++) {
+					size_t count = histogram[c * buckets + b];
+					histogram[c * buckets + b] = offset;
+					offset += count;
+				}
+			}
+
+			utils::parallelChunks(number_of_elements, chunks, [&](size_t c, size_t begin, size_t end) {
+				size_t* position = &histogram[c * buckets];
+				for (size_t i = begin; i < end; i++) {
+					size_t loc = position[(keys_[i] >> shift) & (buckets - 1)]++;
+					keys[loc] = keys_[i];
+					permutation[loc] = permutation_[i];
+				}
+			});
+
+			keys_.swap(keys);
+			permutation_.swap(permutation);
+		}
+	}
+}
+
+#endif /* UTILS_MORTON_H_ */
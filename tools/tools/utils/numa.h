@@ -0,0 +1,143 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_NUMA_H_
+#define UTILS_NUMA_H_
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+/**
+	The placement of the threads with respect to the numa nodes requires libnuma on Linux and is 
+	enabled by defining UTILS_NUMA at build time, otherwise the threads are pinned in the order
+	of the logical processors
+*/
+#if defined(UTILS_NUMA) && !defined(_WIN32)
+	#include <numa.h>
+#endif
+
+namespace utils
+{
+	/**
+		Flag whether the numa mode is enabled
+
+		@return Reference to the flag
+	*/
+	inline std::atomic<bool>& getNumaModeRef()
+	{
+		static std::atomic<bool> numa_mode(false);
+		return numa_mode;
+	}
+
+	/**
+		Enables the numa mode: the threads of the executor are pinned to processors, large buffers 
+		are initialized by the threads which will process them and parallel loops are partitioned
+		statically, so that every thread works on the memory of its own node. Has to be called 
+		before the executor is used for the first time.
+
+		@param[in] numa_mode_ Flag whether the numa mode is enabled
+	*/
+	inline void setNumaMode(bool numa_mode_)
+	{
+		getNumaModeRef() = numa_mode_;
+	}
+
+	/**
+		Returns true if the numa mode is enabled
+
+		@return True if the numa mode is enabled
+	*/
+	inline bool isNumaMode()
+	{
+		return getNumaModeRef();
+	}
+
+	/**
+		Get the logical processors ordered by their numa node, so that consecutive threads are 
+		placed on the same node
+
+		@return Logical processors
+	*/
+	inline const std::vector<int>& getProcessors()
+	{
+		static const std::vector<int> processors = []() {
+			std::vector<int> processors(std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+			for (size_t i = 0; i < processors.size(); i++) {
+				processors[i] = (int)i;
+			}
+#if defined(UTILS_NUMA) && !defined(_WIN32)
+			if (numa_available() >= 0) {
+				std::stable_sort(processors.begin(), processors.end(), [](int a_, int b_) {
+					return numa_node_of_cpu(a_) < numa_node_of_cpu(b_);
+				});
+			}
+#endif
+			return processors;
+		}();
+		return processors;
+	}
+
+	/**
+		Pins the calling thread to a logical processor
+
+		@param[in] index_ Index of the thread, the threads are distributed over the processors 
+			ordered by their numa node
+		@return True if the thread has been pinned
+	*/
+	inline bool pinThread(size_t index_)
+	{
+		const std::vector<int>& processors = getProcessors();
+		int processor = processors[index_ % processors.size()];
+
+#if defined(_WIN32)
+		return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(processor, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+		return false;
+#endif
+	}
+}
+
+#endif /* UTILS_NUMA_H_ */
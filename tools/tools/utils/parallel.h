@@ -0,0 +1,792 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_PARALLEL_H_
+#define UTILS_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tools/utils/numa.h"
+
+namespace utils
+{
+	/**
+		Pool of worker threads where every worker owns a deque of tasks. A worker takes its newest 
+		task from the back of its own deque and steals the oldest tasks from the front of the 
+		deques of the other workers when it runs out of work. Tasks which are spawned by threads 
+		outside the pool are put into a shared deque. Threads which wait for a group of tasks 
+		execute tasks as well, so groups can be nested.
+	*/
+	class WorkStealingPool
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] threads_ Number of worker threads, the waiting thread is an additional worker
+			@param[in] pin_ Flag whether the worker threads are pinned to processors
+		*/
+		WorkStealingPool(size_t threads_, bool pin_ = false) : queued(0), sleeping(0), stopped(false), pin(pin_)
+		{
+			for (size_t i = 0; i <= threads_; i++) {
+				queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+			}
+			for (size_t i = 0; i < threads_; i++) {
+				threads.push_back(std::thread(&WorkStealingPool::work, this, i));
+			}
+		}
+
+		/**
+			Destructor, terminates the threads
+		*/
+		~WorkStealingPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+			}
+			changed.notify_all();
+
+			for (size_t i = 0; i < threads.size(); i++) {
+				threads[i].join();
+			}
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		WorkStealingPool(const WorkStealingPool&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		/**
+			Get the number of worker threads
+
+			@return Number of worker threads
+		*/
+		size_t getThreads() const
+		{
+			return threads.size();
+		}
+
+		/**
+			Puts a task into the deque of the calling worker or into the shared deque
+
+			@param[in] task_ Task
+		*/
+		void push(std::function<void()> task_)
+		{
+			WorkQueue& queue = *queues[getQueueIndex()];
+			{
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				queue.tasks.push_back(std::move(task_));
+			}
+			queued++;
+
+			/**
+				Every sleeping thread can execute the task, so a single one is woken up
+			*/
+			if (sleeping > 0) {
+				std::lock_guard<std::mutex> lock(mutex);
+				changed.notify_one();
+			}
+		}
+
+		/**
+			Puts a task into the deque of a certain worker, the task cannot be stolen. The shared
+			deque belongs to the threads which do not belong to the pool.
+
+			@param[in] task_ Task
+			@param[in] index_ Index of the worker, the index of the shared deque is the number of 
+				worker threads
+		*/
+		void pushPinned(std::function<void()> task_, size_t index_)
+		{
+			WorkQueue& queue = *queues[index_];
+			{
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				queue.pinned.push_back(std::move(task_));
+				queue.pinned_queued++;
+			}
+			notify();
+		}
+
+		/**
+			Returns true if the calling thread is a worker of the pool
+
+			@return True if the calling thread is a worker
+		*/
+		bool isWorker() const
+		{
+			return getCurrentPool() == this;
+		}
+
+		/**
+			Executes one task, tasks of the own deque are preferred to stolen ones
+
+			@return True if a task has been executed
+		*/
+		bool runOne()
+		{
+			std::function<void()> task;
+			if (!pop(task)) {
+				return false;
+			}
+			task();
+			return true;
+		}
+
+		/**
+			Blocks until a task is queued or the predicate is fulfilled
+
+			@param[in] predicate_ Predicate
+		*/
+		void waitFor(const std::function<bool()>& predicate_)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			sleeping++;
+			changed.wait(lock, [&]() { return predicate_() || hasWork() || stopped; });
+			sleeping--;
+		}
+
+		/**
+			Wakes up all waiting threads if there are any, used for pinned tasks and finished 
+			groups which only certain threads are waiting for
+		*/
+		void notify()
+		{
+			if (sleeping > 0) {
+				std::lock_guard<std::mutex> lock(mutex);
+				changed.notify_all();
+			}
+		}
+
+	private:
+
+		/**
+			Deque of a worker
+		*/
+		struct WorkQueue
+		{
+			WorkQueue() : pinned_queued(0) {}
+
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+			std::deque<std::function<void()>> pinned;
+			std::atomic<size_t> pinned_queued;
+		};
+
+		/**
+			Get the pool and the index of the worker of the calling thread
+
+			@return Reference to the pool of the calling thread
+		*/
+		static WorkStealingPool*& getCurrentPool()
+		{
+			static thread_local WorkStealingPool* pool = nullptr;
+			return pool;
+		}
+
+		/**
+			Get the index of the worker of the calling thread
+
+			@return Reference to the index of the calling thread
+		*/
+		static size_t& getCurrentIndex()
+		{
+			static thread_local size_t index = 0;
+			return index;
+		}
+
+		/**
+			Get the index of the deque of the calling thread, the last deque is shared by all 
+			threads which do not belong to the pool
+
+			@return Index of the deque
+		*/
+		size_t getQueueIndex() const
+		{
+			return getCurrentPool() == this ? getCurrentIndex() : threads.size();
+		}
+
+		/**
+			Returns true if there is a task which can be executed by the calling thread
+
+			@return True if there is a task
+		*/
+		bool hasWork() const
+		{
+			return queued > 0 || queues[getQueueIndex()]->pinned_queued > 0;
+		}
+
+		/**
+			Takes a pinned task or a task from the back of the own deque or steals one from the 
+			front of another
+
+			@param[in,out] task_ Task
+			@return True if a task has been found
+		*/
+		bool pop(std::function<void()>& task_)
+		{
+			size_t own = getQueueIndex();
+			{
+				WorkQueue& queue = *queues[own];
+				if (queue.pinned_queued > 0) {
+					std::lock_guard<std::mutex> lock(queue.mutex);
+					if (!queue.pinned.empty()) {
+						task_ = std::move(queue.pinned.front());
+						queue.pinned.pop_front();
+						queue.pinned_queued--;
+						return true;
+					}
+				}
+			}
+
+			if (queued == 0) {
+				return false;
+			}
+
+			{
+				WorkQueue& queue = *queues[own];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				if (!queue.tasks.empty()) {
+					task_ = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+					queued--;
+					return true;
+				}
+			}
+
+			for (size_t i = 1; i < queues.size(); i++) {
+				WorkQueue& queue = *queues[(own + i) % queues.size()];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				if (!queue.tasks.empty()) {
+					task_ = std::move(queue.tasks.front());
+					queue.tasks.pop_front();
+					queued--;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/**
+			Loop of the worker threads
+
+			@param[in] index_ Index of the worker
+		*/
+		void work(size_t index_)
+		{
+			getCurrentPool() = this;
+			getCurrentIndex() = index_;
+
+			if (pin) {
+				pinThread(index_);
+			}
+
+			for (;;) {
+				if (runOne()) {
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(mutex);
+				sleeping++;
+				changed.wait(lock, [this]() { return hasWork() || stopped; });
+				sleeping--;
+				if (stopped) {
+					return;
+				}
+			}
+		}
+
+		/**
+			Deques of the workers followed by the shared deque
+		*/
+		std::vector<std::unique_ptr<WorkQueue>> queues;
+
+		/**
+			Worker threads
+		*/
+		std::vector<std::thread> threads;
+
+		/**
+			Number of queued tasks
+		*/
+		std::atomic<size_t> queued;
+
+		/**
+			Number of threads which wait for the condition variable, it is incremented before the
+			condition is checked, so a thread which queues a task either sees the sleeper or the
+			sleeper sees the task
+		*/
+		std::atomic<size_t> sleeping;
+
+		/**
+			Flag whether the threads are terminated
+		*/
+		bool stopped;
+
+		/**
+			Flag whether the worker threads are pinned to processors
+		*/
+		bool pin;
+
+		/**
+			Mutex of the condition variable
+		*/
+		std::mutex mutex;
+
+		/**
+			Signals queued tasks and finished groups
+		*/
+		std::condition_variable changed;
+	};
+
+	/**
+		Group of tasks which can be waited for, the waiting thread executes tasks of the pool until
+		all tasks of the group are finished. The first exception thrown by a task is rethrown by 
+		wait().
+	*/
+	class TaskGroup
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] pool_ Pool which executes the tasks
+		*/
+		TaskGroup(WorkStealingPool& pool_) : pool(pool_), pending(0)
+		{
+		}
+
+		/**
+			Destructor, waits for the tasks
+		*/
+		~TaskGroup()
+		{
+			try
+			{
+				wait();
+			}
+			catch (...) {}
+		}
+
+		/**
+			Spawns a task
+
+			@param[in] task_ Task
+			@param[in] worker_ Index of the worker which has to execute the task, any worker if 
+				negative
+		*/
+		template<typename Task> void run(const Task& task_, int worker_ = -1)
+		{
+			pending++;
+
+			WorkStealingPool* pool_ptr = &pool;
+			std::function<void()> task = [this, pool_ptr, task_]() {
+				try
+				{
+					task_();
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!exception) {
+						exception = std::current_exception();
+					}
+				}
+				if (pending.fetch_sub(1) == 1) {
+					pool_ptr->notify();
+				}
+			};
+
+			if (worker_ < 0) {
+				pool.push(std::move(task));
+			}
+			else {
+				pool.pushPinned(std::move(task), (size_t)worker_);
+			}
+		}
+
+		/**
+			Waits for all tasks of the group and executes tasks of the pool in the meantime
+		*/
+		void wait()
+		{
+			while (pending > 0) {
+				if (!pool.runOne()) {
+					pool.waitFor([this]() { return pending == 0; });
+				}
+			}
+
+			if (exception) {
+				std::exception_ptr rethrow = exception;
+				exception = nullptr;
+				std::rethrow_exception(rethrow);
+			}
+		}
+
+	private:
+
+		/**
+			Pool which executes the tasks
+		*/
+		WorkStealingPool& pool;
+
+		/**
+			Number of unfinished tasks
+		*/
+		std::atomic<size_t> pending;
+
+		/**
+			Mutex of the exception
+		*/
+		std::mutex mutex;
+
+		/**
+			First exception thrown by a task
+		*/
+		std::exception_ptr exception;
+	};
+
+	/**
+		Number of worker threads of the process-wide executor
+
+		@return Reference to the number of worker threads
+	*/
+	inline std::atomic<size_t>& getExecutorSizeRef()
+	{
+		static std::atomic<size_t> size(std::max<size_t>(1, std::thread::hardware_concurrency()) - 1);
+		return size;
+	}
+
+	/**
+		Set the number of worker threads of the process-wide executor, has to be called before the
+		executor is used for the first time
+
+		@param[in] threads_ Number of worker threads, the calling thread is an additional worker
+	*/
+	inline void setExecutorSize(size_t threads_)
+	{
+		getExecutorSizeRef() = threads_;
+	}
+
+	/**
+		Get the process-wide executor which is shared by all subsystems, it is created at the 
+		first call
+
+		@return Executor
+	*/
+	inline WorkStealingPool& getExecutor()
+	{
+		static WorkStealingPool executor(getExecutorSizeRef(), isNumaMode());
+		return executor;
+	}
+
+	/**
+		Applies a function to all subranges of [begin_, end_), the range is split recursively into 
+		halves until the subranges are not larger than grain_, the halves are spawned as tasks 
+		which can be stolen by idle workers
+
+		@param[in] pool_ Pool which executes the tasks
+		@param[in] begin_ Begin of the range
+		@param[in] end_ End of the range
+		@param[in] grain_ Maximal size of a subrange
+		@param[in] function_ Function which is invoked with the bounds of a subrange
+	*/
+	template<typename Function>
+	void parallel_for(WorkStealingPool& pool_, size_t begin_, size_t end_, size_t grain_, const Function& function_)
+	{
+		if (begin_ >= end_) {
+			return;
+		}
+		grain_ = std::max<size_t>(1, grain_);
+
+		TaskGroup group(pool_);
+		std::function<void(size_t, size_t)> split = [&](size_t begin, size_t end) {
+			while (end - begin > grain_) {
+				size_t middle = begin + (end - begin) / 2;
+				group.run([&split, middle, end]() { split(middle, end); });
+				end = middle;
+			}
+			function_(begin, end);
+		};
+
+		split(begin_, end_);
+		group.wait();
+	}
+
+	/**
+		Splits a range into one contiguous chunk per worker of the process-wide executor and 
+		processes every chunk by its worker, the last chunk is processed by the calling thread. 
+		Ranges which are partitioned in the same way are always processed by the same threads, 
+		this is used in numa mode to process data by the thread which initialized it.
+
+		@param[in] number_of_elements_ Number of elements in the range
+		@param[in] function_ Function which is invoked with the number of the chunk and its bounds
+		@return Number of chunks
+	*/
+	inline size_t parallelStatic(size_t number_of_elements_, const std::function<void(size_t, size_t, size_t)>& function_)
+	{
+		WorkStealingPool& pool = getExecutor();
+
+		/**
+			Workers of the executor cannot wait for pinned tasks of other workers
+		*/
+		if (pool.isWorker()) {
+			function_(0, 0, number_of_elements_);
+			return 1;
+		}
+
+		size_t chunks = pool.getThreads() + 1;
+		size_t chunk_size = (number_of_elements_ + chunks - 1) / chunks;
+
+		TaskGroup group(pool);
+		for (size_t c = 0; c + 1 < chunks; c++) {
+			size_t begin = std::min(c * chunk_size, number_of_elements_);
+			size_t end = std::min((c + 1) * chunk_size, number_of_elements_);
+			if (begin < end) {
+				group.run([&function_, c, begin, end]() { function_(c, begin, end); }, (int)c);
+			}
+		}
+		size_t begin = std::min((chunks - 1) * chunk_size, number_of_elements_);
+		function_(chunks - 1, begin, number_of_elements_);
+		group.wait();
+
+		return chunks;
+	}
+
+	/**
+		Sets memory to zero, in numa mode large buffers are initialized in the same partition as 
+		used by parallelStatic, so that the pages are placed on the node of the thread which will
+		process them
+
+		@param[in,out] data_ Memory
+		@param[in] bytes_ Number of bytes
+	*/
+	inline void initializeMemory(void* data_, size_t bytes_)
+	{
+		const size_t threshold = 1 << 22;
+		if (!isNumaMode() || bytes_ < threshold) {
+			std::memset(data_, 0, bytes_);
+			return;
+		}
+
+		parallelStatic(bytes_, [data_](size_t, size_t begin_, size_t end_) {
+			std::memset((char*)data_ + begin_, 0, end_ - begin_);
+		});
+	}
+
+	/**
+		Copies memory, in numa mode large buffers are copied in the same partition as used by 
+		parallelStatic, so that the pages of a newly allocated destination are placed on the node 
+		of the thread which will process them
+
+		@param[out] destination_ Destination
+		@param[in] source_ Source
+		@param[in] bytes_ Number of bytes
+	*/
+	inline void copyMemory(void* destination_, const void* source_, size_t bytes_)
+	{
+		const size_t threshold = 1 << 22;
+		if (!isNumaMode() || bytes_ < threshold) {
+			std::memcpy(destination_, source_, bytes_);
+			return;
+		}
+
+		parallelStatic(bytes_, [destination_, source_](size_t, size_t begin_, size_t end_) {
+			std::memcpy((char*)destination_ + begin_, (const char*)source_ + begin_, end_ - begin_);
+		});
+	}
+
+	/**
+		Applies a function to all subranges of [begin_, end_) on the process-wide executor. Without
+		a limit the range is split recursively, otherwise at most concurrency_ threads take 
+		subranges of size grain_ from the range one after another. In numa mode the range is 
+		partitioned statically.
+
+		@param[in] begin_ Begin of the range
+		@param[in] end_ End of the range
+		@param[in] grain_ Maximal size of a subrange
+		@param[in] function_ Function which is invoked with the bounds of a subrange
+		@param[in] concurrency_ Maximal number of threads which process the range, no limit if zero
+	*/
+	template<typename Function>
+	void parallel_for(size_t begin_, size_t end_, size_t grain_, const Function& function_, size_t concurrency_ = 0)
+	{
+		if (begin_ >= end_) {
+			return;
+		}
+		grain_ = std::max<size_t>(1, grain_);
+
+		WorkStealingPool& pool = getExecutor();
+
+		/**
+			In numa mode every thread processes the part of the range which has been initialized by
+			itself, the concurrency limit is not applied
+		*/
+		if (isNumaMode() && !pool.isWorker()) {
+			parallelStatic(end_ - begin_, [&](size_t, size_t first_, size_t last_) {
+				for (size_t begin = begin_ + first_; begin < begin_ + last_; begin += grain_) {
+					function_(begin, std::min(begin_ + last_, begin + grain_));
+				}
+			});
+			return;
+		}
+
+		if (!concurrency_ || concurrency_ > pool.getThreads()) {
+			parallel_for(pool, begin_, end_, grain_, function_);
+			return;
+		}
+
+		std::atomic<size_t> next(begin_);
+		auto lane = [&]() {
+			for (size_t begin = next.fetch_add(grain_); begin < end_; begin = next.fetch_add(grain_)) {
+				function_(begin, std::min(end_, begin + grain_));
+			}
+		};
+
+		size_t lanes = std::min(concurrency_, (end_ - begin_ + grain_ - 1) / grain_);
+		TaskGroup group(pool);
+		for (size_t i = 1; i < lanes; i++) {
+			group.run(lane);
+		}
+		lane();
+		group.wait();
+	}
+
+	/**
+		Splits a range into contiguous chunks and processes every chunk as a task on the 
+		process-wide executor, the calling thread processes the first chunk and returns when all 
+		chunks are finished
+
+		@param[in] number_of_elements_ Number of elements in the range
+		@param[in] cores_ Maximal number of chunks
+		@param[in] function_ Function which is invoked with the number of the chunk and its bounds
+		@return Number of chunks
+	*/
+	inline size_t parallelChunks(size_t number_of_elements_, size_t cores_,
+		const std::function<void(size_t, size_t, size_t)>& function_)
+	{
+		size_t chunks = std::max<size_t>(1, std::min(cores_, number_of_elements_));
+		size_t chunk_size = (number_of_elements_ + chunks - 1) / chunks;
+
+		TaskGroup group(getExecutor());
+		for (size_t c = 1; c < chunks; c++) {
+			size_t begin = std::min(c * chunk_size, number_of_elements_);
+			size_t end = std::min((c + 1) * chunk_size, number_of_elements_);
+			group.run([&function_, c, begin, end]() { function_(c, begin, end); });
+		}
+		function_(0, 0, std::min(chunk_size, number_of_elements_));
+		group.wait();
+
+		return chunks;
+	}
+
+	/**
+		Fills a newly allocated buffer of elements. In numa mode the range is partitioned like in
+		parallelStatic, so that the pages are first touched by the threads which will process 
+		them, otherwise the range is split into at most cores_ chunks like in parallelChunks
+
+		@param[in] number_of_elements_ Number of elements in the range
+		@param[in] cores_ Maximal number of chunks outside of the numa mode
+		@param[in] function_ Function which is invoked with the bounds of a subrange
+	*/
+	inline void parallelFirstTouch(size_t number_of_elements_, size_t cores_,
+		const std::function<void(size_t, size_t)>& function_)
+	{
+		if (isNumaMode()) {
+			parallelStatic(number_of_elements_, [&function_](size_t, size_t begin_, size_t end_) {
+				function_(begin_, end_);
+			});
+		}
+		else {
+			parallelChunks(number_of_elements_, cores_, [&function_](size_t, size_t begin_, size_t end_) {
+				function_(begin_, end_);
+			});
+		}
+	}
+
+	/**
+		Reduces the range [begin_, end_) in parallel, the range is split recursively into halves 
+		until the subranges are not larger than grain_
+
+		@param[in] pool_ Pool which executes the tasks
+		@param[in] begin_ Begin of the range
+		@param[in] end_ End of the range
+		@param[in] grain_ Maximal size of a subrange
+		@param[in] identity_ Result of an empty range
+		@param[in] map_ Function which computes the result of a subrange given its bounds
+		@param[in] reduce_ Function which combines the results of two adjacent subranges
+		@return Result of the range
+	*/
+	template<typename ResultType, typename Map, typename Reduce>
+	ResultType parallel_reduce(WorkStealingPool& pool_, size_t begin_, size_t end_, size_t grain_, 
+		const ResultType& identity_, const Map& map_, const Reduce& reduce_)
+	{
+		if (begin_ >= end_) {
+			return identity_;
+		}
+		grain_ = std::max<size_t>(1, grain_);
+
+		if (end_ - begin_ <= grain_) {
+			return map_(begin_, end_);
+		}
+
+		size_t middle = begin_ + (end_ - begin_) / 2;
+		ResultType right = identity_;
+		
+		TaskGroup group(pool_);
+		group.run([&]() { right = parallel_reduce(pool_, middle, end_, grain_, identity_, map_, reduce_); });
+		ResultType left = parallel_reduce(pool_, begin_, middle, grain_, identity_, map_, reduce_);
+		group.wait();
+
+		return reduce_(left, right);
+	}
+}
+
+#endif /* UTILS_PARALLEL_H_ */
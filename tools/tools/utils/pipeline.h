@@ -0,0 +1,455 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef UTILS_PIPELINE_H_
+#define UTILS_PIPELINE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tools/utils/queue.h"
+
+namespace utils
+{
+	/**
+		Function which passes an element to the next stage of a pipeline, returns false if the 
+		pipeline has been aborted
+	*/
+	template<typename ElementType> using Emit = std::function<bool(ElementType)>;
+
+	/**
+		Bounded queue which connects two stages of a pipeline, the transport is a lock-free 
+		ring buffer. Producers wait while the channel is full and consumers wait while it is empty,
+		so the number of elements in flight and thereby the memory of the pipeline is bounded by 
+		the capacity.
+	*/
+	template<typename ElementType>
+	class Channel
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] capacity_ Minimal number of elements in the channel, rounded up to a power 
+				of two
+		*/
+		Channel(size_t capacity_) : elements(capacity_), closed(false)
+		{
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		Channel(const Channel&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		Channel& operator=(const Channel&) = delete;
+
+		/**
+			Puts an element into the channel, waits while the channel is full
+
+			@param[in] element_ Element
+			@return False if the channel has been closed
+		*/
+		bool push(ElementType element_)
+		{
+			return elements.pushUntil(element_, [this]() { return closed.load(std::memory_order_acquire); });
+		}
+
+		/**
+			Takes an element from the channel, waits while the channel is empty and open
+
+			@param[out] element_ Element
+			@return False if the channel is closed and empty
+		*/
+		bool pop(ElementType& element_)
+		{
+			return elements.popUntil(element_, [this]() { return closed.load(std::memory_order_acquire); });
+		}
+
+		/**
+			Closes the channel, remaining elements can still be taken. Has to be called after the 
+			last element has been put.
+
+			@param[in] discard_ Flag whether the remaining elements are dropped
+		*/
+		void close(bool discard_ = false)
+		{
+			closed.store(true, std::memory_order_release);
+			elements.wake();
+			if (discard_) {
+				ElementType element;
+				while (elements.tryPop(element)) {
+				}
+			}
+		}
+
+		/**
+			Get the capacity of the channel
+
+			@return Capacity
+		*/
+		size_t getCapacity() const
+		{
+			return elements.getCapacity();
+		}
+
+	private:
+
+		/**
+			Elements
+		*/
+		MPMCQueue<ElementType> elements;
+
+		/**
+			Flag whether the channel has been closed
+		*/
+		std::atomic<bool> closed;
+	};
+
+	/**
+		Restores the order of elements which are passed by several threads, elements are emitted
+		as soon as all elements with lower sequence numbers have been emitted
+	*/
+	template<typename ElementType>
+	class Reorder
+	{
+	public:
+
+		/**
+			Constructor
+		*/
+		Reorder() : next(0)
+		{
+		}
+
+		/**
+			Adds an element and emits all elements which are in order
+
+			@param[in] sequence_ Sequence number of the element, starting at zero
+			@param[in] element_ Element
+			@param[in] emit_ Function which is invoked with the elements in order
+			@return False if emit_ returned false
+		*/
+		template<typename Function> bool push(size_t sequence_, ElementType element_, const Function& emit_)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			pending.insert(std::make_pair(sequence_, std::move(element_)));
+
+			/**
+				The elements are emitted under the lock, otherwise two threads could emit them 
+				interleaved
+			*/
+			typename std::map<size_t, ElementType>::iterator it = pending.begin();
+			while (it != pending.end() && it->first == next) {
+				ElementType element = std::move(it->second);
+				pending.erase(it);
+				next++;
+				if (!emit_(std::move(element))) {
+					return false;
+				}
+				it = pending.begin();
+			}
+
+			return true;
+		}
+
+		/**
+			Get the number of elements which wait for their predecessors
+
+			@return Number of elements
+		*/
+		size_t getPending()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return pending.size();
+		}
+
+	private:
+
+		/**
+			Elements which wait for their predecessors
+		*/
+		std::map<size_t, ElementType> pending;
+
+		/**
+			Sequence number of the next element
+		*/
+		size_t next;
+
+		/**
+			Mutex
+		*/
+		std::mutex mutex;
+	};
+
+	/**
+		Linear pipeline of stages which are connected by bounded channels. Every stage runs on its
+		own threads, so reading, computation and writing overlap and the memory is bounded by the
+		capacity of the channels. The stages are defined first and started by run(), which waits 
+		until the source is exhausted and all elements have passed the sink. An exception in a 
+		stage aborts the pipeline and is rethrown by run().
+
+		The stages block on the channels and therefore use dedicated threads instead of the 
+		executor, computations inside a stage may still use parallel_for.
+	*/
+	class Pipeline
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] capacity_ Capacity of the channels between the stages
+		*/
+		Pipeline(size_t capacity_ = 4) : capacity(capacity_)
+		{
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		Pipeline(const Pipeline&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		Pipeline& operator=(const Pipeline&) = delete;
+
+		/**
+			Adds the first stage, the function is invoked once and emits all elements
+
+			@param[in] function_ Function which is invoked with an Emit<Out>
+			@return Output channel of the stage
+		*/
+		template<typename Out, typename Function> Channel<Out>& source(Function function_)
+		{
+			Channel<Out>& output = createChannel<Out>();
+
+			Channel<Out>* output_ptr = &output;
+			jobs.push_back([output_ptr, function_]() {
+				Emit<Out> emit = [output_ptr](Out element_) { return output_ptr->push(std::move(element_)); };
+				try {
+					function_(emit);
+				}
+				catch (...) {
+					output_ptr->close();
+					throw;
+				}
+				output_ptr->close();
+			});
+
+			return output;
+		}
+
+		/**
+			Adds a stage which processes the elements of a channel on several threads, the function
+			may emit any number of elements for every input element. The order of the elements is 
+			kept if the stage has only one thread.
+
+			@param[in] input_ Input channel
+			@param[in] function_ Function which is invoked with an element and an Emit<Out>
+			@param[in] parallelism_ Number of threads of the stage
+			@return Output channel of the stage
+		*/
+		template<typename Out, typename In, typename Function> Channel<Out>& stage(Channel<In>& input_, 
+			Function function_, size_t parallelism_ = 1)
+		{
+			return stageWithFlush<Out>(input_, function_, [](const Emit<Out>&) {}, parallelism_);
+		}
+
+		/**
+			Adds a stage which processes the elements of a channel on several threads, the function
+			may emit any number of elements for every input element. The order of the elements is 
+			kept if the stage has only one thread.
+
+			@param[in] input_ Input channel
+			@param[in] function_ Function which is invoked with an element and an Emit<Out>
+			@param[in] flush_ Function which is invoked with an Emit<Out> after all elements have 
+				been processed, e.g. to emit buffered elements
+			@param[in] parallelism_ Number of threads of the stage
+			@return Output channel of the stage
+		*/
+		template<typename Out, typename In, typename Function, typename Flush> Channel<Out>& stageWithFlush(Channel<In>& input_, 
+			Function function_, Flush flush_, size_t parallelism_ = 1)
+		{
+			Channel<Out>& output = createChannel<Out>();
+
+			Channel<In>* input_ptr = &input_;
+			Channel<Out>* output_ptr = &output;
+			std::shared_ptr<std::atomic<size_t>> running = std::make_shared<std::atomic<size_t>>(std::max<size_t>(1, parallelism_));
+			for (size_t i = 0; i < std::max<size_t>(1, parallelism_); i++) {
+				jobs.push_back([input_ptr, output_ptr, running, function_, flush_]() {
+					Emit<Out> emit = [output_ptr](Out element_) { return output_ptr->push(std::move(element_)); };
+
+					/**
+						The last thread of the stage flushes and closes the output channel
+					*/
+					try {
+						In element;
+						while (input_ptr->pop(element)) {
+							function_(element, emit);
+						}
+						if (running->fetch_sub(1) == 1) {
+							flush_(emit);
+							output_ptr->close();
+						}
+					}
+					catch (...) {
+						output_ptr->close();
+						throw;
+					}
+				});
+			}
+
+			return output;
+		}
+
+		/**
+			Adds the last stage which consumes the elements of a channel on several threads
+
+			@param[in] input_ Input channel
+			@param[in] function_ Function which is invoked with an element
+			@param[in] parallelism_ Number of threads of the stage
+		*/
+		template<typename In, typename Function> void sink(Channel<In>& input_, Function function_, size_t parallelism_ = 1)
+		{
+			Channel<In>* input_ptr = &input_;
+			for (size_t i = 0; i < std::max<size_t>(1, parallelism_); i++) {
+				jobs.push_back([input_ptr, function_]() {
+					In element;
+					while (input_ptr->pop(element)) {
+						function_(element);
+					}
+				});
+			}
+		}
+
+		/**
+			Starts all stages and waits until they are finished, rethrows the first exception of 
+			a stage
+		*/
+		void run()
+		{
+			std::exception_ptr exception;
+			std::mutex exception_mutex;
+
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < jobs.size(); i++) {
+				std::function<void()>& job = jobs[i];
+				threads.push_back(std::thread([this, &job, &exception, &exception_mutex]() {
+					try {
+						job();
+					}
+					catch (...) {
+						{
+							std::lock_guard<std::mutex> lock(exception_mutex);
+							if (!exception) {
+								exception = std::current_exception();
+							}
+						}
+						abort();
+					}
+				}));
+			}
+
+			for (size_t i = 0; i < threads.size(); i++) {
+				threads[i].join();
+			}
+			jobs.clear();
+
+			if (exception) {
+				std::rethrow_exception(exception);
+			}
+		}
+
+		/**
+			Aborts the pipeline, all channels are closed and their elements are dropped
+		*/
+		void abort()
+		{
+			for (size_t i = 0; i < closers.size(); i++) {
+				closers[i]();
+			}
+		}
+
+	private:
+
+		/**
+			Creates a channel which is owned by the pipeline
+
+			@return Channel
+		*/
+		template<typename ElementType> Channel<ElementType>& createChannel()
+		{
+			std::shared_ptr<Channel<ElementType>> channel = std::make_shared<Channel<ElementType>>(capacity);
+			channels.push_back(channel);
+
+			Channel<ElementType>* channel_ptr = channel.get();
+			closers.push_back([channel_ptr]() { channel_ptr->close(true); });
+
+			return *channel;
+		}
+
+		/**
+			Capacity of the channels
+		*/
+		size_t capacity;
+
+		/**
+			Channels between the stages
+		*/
+		std::vector<std::shared_ptr<void>> channels;
+
+		/**
+			Functions which close the channels
+		*/
+		std::vector<std::function<void()>> closers;
+
+		/**
+			Jobs which are run by one thread each
+		*/
+		std::vector<std::function<void()>> jobs;
+	};
+}
+
+#endif /* UTILS_PIPELINE_H_ */
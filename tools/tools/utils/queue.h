@@ -32,6 +32,13 @@
 #ifndef UTILS_QUEUE_H_
 #define UTILS_QUEUE_H_
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace utils
@@ -84,7 +91,7 @@ namespace utils
 		/**
 			Set the array amd the size
 		*/
-		void setQueue(ElementType* pointer, size_t size_) 
+		void setQueue(ElementType* pointer_, size_t size_) 
 		{
 			if (queuearray) {
 				delete[] queuearray;
@@ -104,12 +111,12 @@ namespace utils
 		*/
 		void resize(size_t size_) {
 
-			queuearray_new = new ElementType[size_];
-			std::memcpy(queuearray_new, queuarray, size);
+			ElementType* queuearray_new = new ElementType[size_];
+			std::memcpy(queuearray_new, queuearray, sizeof(ElementType) * std::min(size, size_));
 			if (queuearray) {
 				delete[] queuearray;
 			}
-			queuarray = queuearray_new;
+			queuearray = queuearray_new;
 
 			size = size_;
 			loc = queuearray;
@@ -130,6 +137,721 @@ namespace utils
 		bool greater;
 	};
 
+	/**
+		Size of a cache line, counters which are written by different threads are separated by 
+		padding so that they do not share a cache line
+	*/
+	const size_t QUEUE_CACHE_LINE = 64;
+
+	/**
+		Waits with increasing pauses, first by spinning and then by yielding. Afterwards the 
+		caller should block instead of polling.
+	*/
+	class Backoff
+	{
+	public:
+
+		/**
+			Constructor
+		*/
+		Backoff() : step(0)
+		{
+		}
+
+		/**
+			Waits for a short time which increases with every call
+
+			@return False if the pauses are exhausted
+		*/
+		bool wait()
+		{
+			if (step < 64) {
+				step++;
+				return true;
+			}
+			if (step < 128) {
+				step++;
+				std::this_thread::yield();
+				return true;
+			}
+			return false;
+		}
+
+		/**
+			Resets the pauses
+		*/
+		void reset()
+		{
+			step = 0;
+		}
+
+	private:
+
+		/**
+			Number of calls
+		*/
+		size_t step;
+	};
+
+	/**
+		Blocks threads until a condition holds, e.g. until a ring is not empty. Waiting threads 
+		spin for a short time and then sleep on a condition variable. A thread which changes the 
+		state calls notify(), which costs a fence and only takes the mutex if a thread sleeps. The
+		condition is never evaluated while the mutex is held, so conditions may notify other 
+		notifiers without lock-order inversions.
+	*/
+	class Notifier
+	{
+	public:
+
+		/**
+			Constructor
+		*/
+		Notifier() : sleepers(0), generation(0)
+		{
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		Notifier(const Notifier&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		Notifier& operator=(const Notifier&) = delete;
+
+		/**
+			Waits until a condition holds, the condition is evaluated repeatedly and may have side 
+			effects, e.g. taking an element
+
+			@param[in] condition_ Function which returns true if the wait is over
+		*/
+		template<typename Condition> void wait(Condition condition_)
+		{
+			Backoff backoff;
+			while (!condition_()) {
+				if (backoff.wait()) {
+					continue;
+				}
+
+				/**
+					The sleeper is announced and the generation is read before the condition is 
+					checked again, so a notifying thread either sees the sleeper and advances the
+					generation or its change is seen by the check
+				*/
+				sleepers.fetch_add(1, std::memory_order_seq_cst);
+				const size_t observed = generation.load(std::memory_order_seq_cst);
+				if (condition_()) {
+					sleepers.fetch_sub(1, std::memory_order_relaxed);
+					return;
+				}
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					while (generation.load(std::memory_order_relaxed) == observed) {
+						condition.wait(lock);
+					}
+				}
+				sleepers.fetch_sub(1, std::memory_order_relaxed);
+				backoff.reset();
+			}
+		}
+
+		/**
+			Wakes all sleeping threads, has to be called after the state has been changed
+		*/
+		void notify()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleepers.load(std::memory_order_relaxed)) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					generation.fetch_add(1, std::memory_order_seq_cst);
+				}
+				condition.notify_all();
+			}
+		}
+
+	private:
+
+		/**
+			Number of sleeping threads
+		*/
+		std::atomic<size_t> sleepers;
+
+		/**
+			Number of notifications which found sleeping threads
+		*/
+		std::atomic<size_t> generation;
+
+		/**
+			Mutex of the condition variable
+		*/
+		std::mutex mutex;
+
+		/**
+			Condition variable
+		*/
+		std::condition_variable condition;
+	};
+
+	/**
+		Rounds up to the next power of two
+
+		@param[in] value_ Value
+		@return Power of two which is greater or equal to value_
+	*/
+	inline size_t roundUpPowerOfTwo(size_t value_)
+	{
+		size_t power = 1;
+		while (power < value_) {
+			power <<= 1;
+		}
+		return power;
+	}
+
+	/**
+		Bounded lock-free ring buffer for exactly one producer and one consumer thread. The 
+		producer only writes the tail and the consumer only writes the head, each side caches the 
+		counter of the other side and reloads it only when the ring seems to be full or empty.
+	*/
+	template<typename ElementType>
+	class SPSCQueue
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] capacity_ Minimal capacity, rounded up to a power of two
+		*/
+		SPSCQueue(size_t capacity_) : capacity(roundUpPowerOfTwo(std::max<size_t>(1, capacity_))), 
+			mask(capacity - 1), head(0), tail_cache(0), tail(0), head_cache(0)
+		{
+			elements = new ElementType[capacity];
+		}
+
+		/**
+			Destructor
+		*/
+		~SPSCQueue()
+		{
+			delete[] elements;
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		SPSCQueue(const SPSCQueue&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+		/**
+			Get the capacity
+
+			@return Capacity
+		*/
+		size_t getCapacity() const
+		{
+			return capacity;
+		}
+
+		/**
+			Puts an element into the ring if it is not full, called by the producer
+
+			@param[in] element_ Element
+			@return True if the element has been put
+		*/
+		bool tryPush(ElementType& element_)
+		{
+			return tryPushBatch(&element_, 1) == 1;
+		}
+
+		/**
+			Puts as many elements as possible into the ring and publishes them at once, called by 
+			the producer
+
+			@param[in] elements_ Elements, the put elements are moved
+			@param[in] number_ Number of elements
+			@return Number of put elements
+		*/
+		size_t tryPushBatch(ElementType* elements_, size_t number_)
+		{
+			size_t position = tail.load(std::memory_order_relaxed);
+			if (position + number_ - head_cache > capacity) {
+				head_cache = head.load(std::memory_order_acquire);
+			}
+
+			size_t number = std::min(number_, capacity - (position - head_cache));
+			for (size_t i = 0; i < number; i++) {
+				elements[(position + i) & mask] = std::move(elements_[i]);
+			}
+			if (number) {
+				tail.store(position + number, std::memory_order_release);
+				not_empty.notify();
+			}
+
+			return number;
+		}
+
+		/**
+			Takes an element from the ring if it is not empty, called by the consumer
+
+			@param[out] element_ Element
+			@return True if an element has been taken
+		*/
+		bool tryPop(ElementType& element_)
+		{
+			return tryPopBatch(&element_, 1) == 1;
+		}
+
+		/**
+			Takes as many elements as possible up to a maximal number, called by the consumer
+
+			@param[out] elements_ Elements
+			@param[in] number_ Maximal number of elements
+			@return Number of taken elements
+		*/
+		size_t tryPopBatch(ElementType* elements_, size_t number_)
+		{
+			size_t position = head.load(std::memory_order_relaxed);
+			if (tail_cache - position < number_) {
+				tail_cache = tail.load(std::memory_order_acquire);
+			}
+
+			size_t number = std::min(number_, tail_cache - position);
+			for (size_t i = 0; i < number; i++) {
+				elements_[i] = std::move(elements[(position + i) & mask]);
+			}
+			if (number) {
+				head.store(position + number, std::memory_order_release);
+				not_full.notify();
+			}
+
+			return number;
+		}
+
+		/**
+			Puts an element into the ring, blocks while it is full
+
+			@param[in] element_ Element
+		*/
+		void push(ElementType element_)
+		{
+			not_full.wait([&]() { return tryPush(element_); });
+		}
+
+		/**
+			Takes an element from the ring, blocks while it is empty
+
+			@param[out] element_ Element
+		*/
+		void pop(ElementType& element_)
+		{
+			not_empty.wait([&]() { return tryPop(element_); });
+		}
+
+		/**
+			Puts an element into the ring, blocks while it is full until a stop condition holds. 
+			Threads which change the stop condition have to call wake().
+
+			@param[in] element_ Element, moved if it has been put
+			@param[in] stop_ Function which returns true if the element shall not be put anymore
+			@return False if the element has not been put
+		*/
+		template<typename Predicate> bool pushUntil(ElementType& element_, Predicate stop_)
+		{
+			bool pushed = false;
+			not_full.wait([&]() {
+				if (stop_()) {
+					return true;
+				}
+				pushed = tryPush(element_);
+				return pushed;
+			});
+			return pushed;
+		}
+
+		/**
+			Takes an element from the ring, blocks while it is empty until a stop condition holds.
+			Threads which change the stop condition have to call wake().
+
+			@param[out] element_ Element
+			@param[in] stop_ Function which returns true if no more elements are expected
+			@return False if the ring is empty and the stop condition holds
+		*/
+		template<typename Predicate> bool popUntil(ElementType& element_, Predicate stop_)
+		{
+			bool popped = false;
+			not_empty.wait([&]() {
+				if (tryPop(element_)) {
+					popped = true;
+					return true;
+				}
+
+				/**
+					Elements which have been put before the stop condition holds are still taken
+				*/
+				if (stop_()) {
+					popped = tryPop(element_);
+					return true;
+				}
+				return false;
+			});
+			return popped;
+		}
+
+		/**
+			Wakes all blocked producers and consumers, so that they check their stop conditions
+		*/
+		void wake()
+		{
+			not_full.notify();
+			not_empty.notify();
+		}
+
+	private:
+
+		/**
+			Capacity, power of two
+		*/
+		const size_t capacity;
+
+		/**
+			Capacity - 1
+		*/
+		const size_t mask;
+
+		/**
+			Elements
+		*/
+		ElementType* elements;
+
+		char padding_0[QUEUE_CACHE_LINE];
+
+		/**
+			Number of taken elements, written by the consumer
+		*/
+		std::atomic<size_t> head;
+
+		/**
+			Last read value of tail, used by the consumer
+		*/
+		size_t tail_cache;
+
+		char padding_1[QUEUE_CACHE_LINE];
+
+		/**
+			Number of put elements, written by the producer
+		*/
+		std::atomic<size_t> tail;
+
+		/**
+			Last read value of head, used by the producer
+		*/
+		size_t head_cache;
+
+		char padding_2[QUEUE_CACHE_LINE];
+
+		/**
+			Producers which wait while the ring is full
+		*/
+		Notifier not_full;
+
+		/**
+			Consumers which wait while the ring is empty
+		*/
+		Notifier not_empty;
+	};
+
+	/**
+		Bounded lock-free ring buffer for any number of producer and consumer threads (Vyukov). 
+		Every cell holds a sequence number which tells whether the cell is free for the producer
+		of a certain position or filled for the consumer of a certain position, producers and 
+		consumers claim positions by compare-and-swap on their counter.
+	*/
+	template<typename ElementType>
+	class MPMCQueue
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] capacity_ Minimal capacity, rounded up to a power of two
+		*/
+		MPMCQueue(size_t capacity_) : capacity(roundUpPowerOfTwo(std::max<size_t>(2, capacity_))), 
+			mask(capacity - 1), enqueue_position(0), dequeue_position(0)
+		{
+			cells = new Cell[capacity];
+			for (size_t i = 0; i < capacity; i++) {
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+			Destructor
+		*/
+		~MPMCQueue()
+		{
+			delete[] cells;
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		MPMCQueue(const MPMCQueue&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+		/**
+			Get the capacity
+
+			@return Capacity
+		*/
+		size_t getCapacity() const
+		{
+			return capacity;
+		}
+
+		/**
+			Puts an element into the ring if it is not full
+
+			@param[in] element_ Element, moved if it has been put
+			@return True if the element has been put
+		*/
+		bool tryPush(ElementType& element_)
+		{
+			Cell* cell;
+			size_t position = enqueue_position.load(std::memory_order_relaxed);
+			for (;;) {
+				cell = &cells[position & mask];
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+				if (difference == 0) {
+					if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				}
+				else if (difference < 0) {
+					return false;
+				}
+				else {
+					position = enqueue_position.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->element = std::move(element_);
+			cell->sequence.store(position + 1, std::memory_order_release);
+			not_empty.notify();
+
+			return true;
+		}
+
+		/**
+			Takes an element from the ring if it is not empty
+
+			@param[out] element_ Element
+			@return True if an element has been taken
+		*/
+		bool tryPop(ElementType& element_)
+		{
+			Cell* cell;
+			size_t position = dequeue_position.load(std::memory_order_relaxed);
+			for (;;) {
+				cell = &cells[position & mask];
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+				if (difference == 0) {
+					if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				}
+				else if (difference < 0) {
+					return false;
+				}
+				else {
+					position = dequeue_position.load(std::memory_order_relaxed);
+				}
+			}
+
+			element_ = std::move(cell->element);
+			cell->sequence.store(position + mask + 1, std::memory_order_release);
+			not_full.notify();
+
+			return true;
+		}
+
+		/**
+			Puts elements into the ring until it is full
+
+			@param[in] elements_ Elements, the put elements are moved
+			@param[in] number_ Number of elements
+			@return Number of put elements
+		*/
+		size_t tryPushBatch(ElementType* elements_, size_t number_)
+		{
+			size_t number = 0;
+			while (number < number_ && tryPush(elements_[number])) {
+				number++;
+			}
+			return number;
+		}
+
+		/**
+			Takes elements from the ring until it is empty
+
+			@param[out] elements_ Elements
+			@param[in] number_ Maximal number of elements
+			@return Number of taken elements
+		*/
+		size_t tryPopBatch(ElementType* elements_, size_t number_)
+		{
+			size_t number = 0;
+			while (number < number_ && tryPop(elements_[number])) {
+				number++;
+			}
+			return number;
+		}
+
+		/**
+			Puts an element into the ring, blocks while it is full
+
+			@param[in] element_ Element
+		*/
+		void push(ElementType element_)
+		{
+			not_full.wait([&]() { return tryPush(element_); });
+		}
+
+		/**
+			Takes an element from the ring, blocks while it is empty
+
+			@param[out] element_ Element
+		*/
+		void pop(ElementType& element_)
+		{
+			not_empty.wait([&]() { return tryPop(element_); });
+		}
+
+		/**
+			Puts an element into the ring, blocks while it is full until a stop condition holds. 
+			Threads which change the stop condition have to call wake().
+
+			@param[in] element_ Element, moved if it has been put
+			@param[in] stop_ Function which returns true if the element shall not be put anymore
+			@return False if the element has not been put
+		*/
+		template<typename Predicate> bool pushUntil(ElementType& element_, Predicate stop_)
+		{
+			bool pushed = false;
+			not_full.wait([&]() {
+				if (stop_()) {
+					return true;
+				}
+				pushed = tryPush(element_);
+				return pushed;
+			});
+			return pushed;
+		}
+
+		/**
+			Takes an element from the ring, blocks while it is empty until a stop condition holds.
+			Threads which change the stop condition have to call wake().
+
+			@param[out] element_ Element
+			@param[in] stop_ Function which returns true if no more elements are expected
+			@return False if the ring is empty and the stop condition holds
+		*/
+		template<typename Predicate> bool popUntil(ElementType& element_, Predicate stop_)
+		{
+			bool popped = false;
+			not_empty.wait([&]() {
+				if (tryPop(element_)) {
+					popped = true;
+					return true;
+				}
+
+				/**
+					Elements which have been put before the stop condition holds are still taken
+				*/
+				if (stop_()) {
+					popped = tryPop(element_);
+					return true;
+				}
+				return false;
+			});
+			return popped;
+		}
+
+		/**
+			Wakes all blocked producers and consumers, so that they check their stop conditions
+		*/
+		void wake()
+		{
+			not_full.notify();
+			not_empty.notify();
+		}
+
+	private:
+
+		/**
+			Cell of the ring
+		*/
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			ElementType element;
+		};
+
+		/**
+			Capacity, power of two
+		*/
+		const size_t capacity;
+
+		/**
+			Capacity - 1
+		*/
+		const size_t mask;
+
+		/**
+			Cells
+		*/
+		Cell* cells;
+
+		char padding_0[QUEUE_CACHE_LINE];
+
+		/**
+			Next position of a producer
+		*/
+		std::atomic<size_t> enqueue_position;
+
+		char padding_1[QUEUE_CACHE_LINE];
+
+		/**
+			Next position of a consumer
+		*/
+		std::atomic<size_t> dequeue_position;
+
+		char padding_2[QUEUE_CACHE_LINE];
+
+		/**
+			Producers which wait while the ring is full
+		*/
+		Notifier not_full;
+
+		/**
+			Consumers which wait while the ring is empty
+		*/
+		Notifier not_empty;
+	};
+
 	/////**
 	////	Operator << Prints the values of the heap
 
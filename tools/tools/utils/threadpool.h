@@ -32,82 +32,158 @@
 #ifndef UTILS_THREADPOOL_H_
 #define UTILS_THREADPOOL_H_
 
-#include <boost/asio.hpp>
-#include <boost/atomic.hpp>
-#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace utils
 {
+	/**
+		Pool of worker threads which process the tasks of a bounded queue. Idle workers sleep on a 
+		condition variable, a caller which submits a task to a full queue executes queued tasks 
+		itself until there is space, so the submitting thread never busy waits.
+	*/
 	class Threadpool
 	{
-	private:
-	
-		boost::asio::io_service io_service;
-		boost::asio::io_service::work work;
-		boost::thread_group threads;
-		std::size_t available;
-		boost::mutex mutex;
-
 	public:
 
 		/**
 			Constructor
 			
-			@param[in] pool_ Number of active threads
+			@param[in] pool_ Number of worker threads
+			@param[in] capacity_ Maximal number of queued tasks, four tasks per thread if zero
 		*/
-		Threadpool(std::size_t pool_) : work(io_service), available(pool_)
+		Threadpool(std::size_t pool_, std::size_t capacity_ = 0) : 
+			capacity(capacity_ ? capacity_ : std::max<std::size_t>(1, 4 * pool_)),
+			active(0),
+			stopped(false)
 		{
 			for (std::size_t i = 0; i < pool_; ++i)
 			{
-				threads.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+				threads.push_back(std::thread(&Threadpool::work, this));
 			}
 		}
 
 		/**
-			Destructor
+			Destructor, waits for all tasks and terminates the threads
 		*/
 		~Threadpool()
 		{
+			shutdown();
 		}
 
 		/**
-			Terminates io_service and threads
+			Copy constructor, deleted
+		*/
+		Threadpool(const Threadpool&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		Threadpool& operator=(const Threadpool&) = delete;
+
+		/**
+			Waits for all tasks and terminates the threads
 		*/
 		void shutdown()
 		{
-			// Force all threads to return from io_service::run().
-			io_service.stop();
+			wait_all();
 
-			// Suppress all exceptions.
-			try
 			{
-				threads.join_all();
+				std::unique_lock<std::mutex> lock(mutex);
+				if (stopped) {
+					return;
+				}
+				stopped = true;
+			}
+			not_empty.notify_all();
+
+			for (std::size_t i = 0; i < threads.size(); ++i) {
+				threads[i].join();
 			}
-			catch (const std::exception&) {}
+			threads.clear();
+		}
+
+		/**
+			Queues a task, if the queue is full the calling thread executes queued tasks until 
+			there is space
+
+			@param[in] task_ Function which will be invoked
+			@return Future which holds the result of the task
+		*/
+		template <typename Task> 
+		auto submit(Task task_) -> std::future<decltype(task_())>
+		{
+			typedef decltype(task_()) ResultType;
+
+			std::shared_ptr<std::packaged_task<ResultType()>> packaged_task = 
+				std::make_shared<std::packaged_task<ResultType()>>(task_);
+			std::future<ResultType> future = packaged_task->get_future();
+
+			push([packaged_task]() { (*packaged_task)(); });
+
+			return future;
 		}
 
 		/**
-			Start a thread with a specific task
+			Queues a task, exceptions of the task are suppressed
 			
 			@param[in] task_ Function which will be invoked
-			@return True if the function could be invoked			
+			@return True, the task is always accepted
 		*/		
 		template <typename Task> bool runTask(Task task_)
 		{
-			boost::unique_lock< boost::mutex > lock(mutex);
+			push([task_]() {
+				try
+				{
+					task_();
+				}
+				// Suppress all exceptions.
+				catch (...) {}
+			});
+
+			return true;
+		}
 
-			// If no threads are available, then return.
-			if (0 == available) return false;
+		/**
+			Waits until all tasks have been finished, the calling thread helps to execute the 
+			queued tasks. If it is called from a task of the pool, the tasks which are executed 
+			by the calling thread itself are not waited for, tasks on other workers which wait 
+			at the same time would wait for each other.
+		*/
+		void wait_all()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!tasks.empty()) {
+				runFront(lock);
+			}
 
-			// Decrement count, indicating thread is no longer available.
-			--available;
+			const std::size_t own = std::count(getRunning().begin(), getRunning().end(), this);
+			finished.wait(lock, [this, own]() { return tasks.empty() && active == own; });
+		}
 
-			// Post a wrapped task into the queue.
-			io_service.post(boost::bind(&Threadpool::wrapTask, this, boost::function<void()>(task_)));
+		/**
+			Waits until all tasks have been finished or the timeout expired
 
-			return true;
+			@param[in] timeout_ Maximal duration to wait
+			@return True if all tasks have been finished
+		*/
+		template <typename Rep, typename Period>
+		bool wait_for(const std::chrono::duration<Rep, Period>& timeout_)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			return finished.wait_for(lock, timeout_, [this]() { return tasks.empty() && !active; });
 		}
-		
+
 		/**
 			Waits until all threads has been finished
 
@@ -115,32 +191,154 @@ namespace utils
 		*/
 		bool waitTasks()
 		{
-			while (available != threads.size());
+			wait_all();
 			
 			return true;
 		}
+
+		/**
+			Get the number of worker threads
+
+			@return Number of worker threads
+		*/
+		std::size_t getThreads() const
+		{
+			return threads.size();
+		}
 		
 	private:
-		
+
 		/**
-			Invoke the function task_
-			
+			Queues a task
+
 			@param[in] task_ Function which will be invoked
-		*/	
-		void wrapTask(boost::function<void()> task_)
+		*/
+		void push(std::function<void()> task_)
 		{
-			// Run the user supplied task.
-			try
-			{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			if (threads.empty() || stopped) {
+				lock.unlock();
 				task_();
+				return;
+			}
+
+			while (tasks.size() >= capacity) {
+				runFront(lock);
+			}
+
+			tasks.push_back(std::move(task_));
+			lock.unlock();
+			not_empty.notify_one();
+		}
+
+		/**
+			Executes the first queued task, the lock is released during the execution
+
+			@param[in,out] lock_ Lock of the queue
+		*/
+		void runFront(std::unique_lock<std::mutex>& lock_)
+		{
+			std::function<void()> task = std::move(tasks.front());
+			tasks.pop_front();
+			++active;
+			getRunning().push_back(this);
+
+			lock_.unlock();
+			try {
+				task();
+			}
+			catch (...) {
+				finishTask(lock_);
+				throw;
+			}
+			finishTask(lock_);
+		}
+
+		/**
+			Marks the task of the calling thread as finished, whether it returned or threw
+
+			@param[in,out] lock_ Unlocked lock of the queue, it is locked on return
+		*/
+		void finishTask(std::unique_lock<std::mutex>& lock_)
+		{
+			lock_.lock();
+			getRunning().pop_back();
+
+			/**
+				Waiting tasks wait for their own number of active tasks, not only for zero
+			*/
+			--active;
+			if (tasks.empty()) {
+				finished.notify_all();
 			}
-			// Suppress all exceptions.
-			catch (const std::exception&) {}
+		}
+
+		/**
+			Get the pools whose tasks are executed by the calling thread, innermost last
 
-			// Task has finished, so increment count of available threads.
-			boost::unique_lock< boost::mutex > lock(mutex);
-			++available;
+			@return Reference to the pools
+		*/
+		static std::vector<const Threadpool*>& getRunning()
+		{
+			static thread_local std::vector<const Threadpool*> running;
+			return running;
+		}
+		
+		/**
+			Loop of the worker threads
+		*/	
+		void work()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			for (;;) {
+				not_empty.wait(lock, [this]() { return stopped || !tasks.empty(); });
+				if (tasks.empty()) {
+					return;
+				}
+				runFront(lock);
+			}
 		}
+
+		/**
+			Worker threads
+		*/
+		std::vector<std::thread> threads;
+
+		/**
+			Queued tasks
+		*/
+		std::deque<std::function<void()>> tasks;
+
+		/**
+			Maximal number of queued tasks
+		*/
+		std::size_t capacity;
+
+		/**
+			Number of tasks which are executed at the moment
+		*/
+		std::size_t active;
+
+		/**
+			Flag whether the threads are terminated
+		*/
+		bool stopped;
+
+		/**
+			Mutex of the queue
+		*/
+		std::mutex mutex;
+
+		/**
+			Signals queued tasks to the workers
+		*/
+		std::condition_variable not_empty;
+
+		/**
+			Signals that all tasks have been finished
+		*/
+		std::condition_variable finished;
 	};
 }
 
@@ -36,6 +36,7 @@
 
 #include "trees/algorithms/nn_index.h"
 #include "trees/algorithms/kdtree_index.h"
+#include "trees/algorithms/lbvh_index.h"
 
 #include "tools/utils.h"
 
@@ -48,10 +49,10 @@ namespace trees
 		@param[in] params_ Input parameters for the tree
 		@return Returns a pointer of the created index
 	*/
-	template<template<typename> typename Index, typename ElementType>
-	inline NNIndex<ElementType>* createIndex(const utils::Matrix<ElementType>& dataset_, const IndexParams& params_)
+	template<template<typename, typename> typename Index, typename ElementType, typename IndexType>
+	inline NNIndex<ElementType, IndexType>* createIndex(const utils::Matrix<ElementType>& dataset_, const IndexParams& params_)
 	{
-		return new Index<ElementType>(dataset_, params_);
+		return new Index<ElementType, IndexType>(dataset_, params_);
 	}
 
 	/**
@@ -62,15 +63,18 @@ namespace trees
 		@param[in] params_ Input parameters for the tree
 		@return Returns a pointer of the created index
 	*/
-	template<typename ElementType>
-	inline NNIndex<ElementType>* createIndexByType(const treeIndex indexType_,
+	template<typename ElementType, typename IndexType>
+	inline NNIndex<ElementType, IndexType>* createIndexByType(const treeIndex indexType_,
 		const utils::Matrix<ElementType>& dataset_, const IndexParams& params_)
 	{
-		NNIndex<ElementType>* nnIndex;
+		NNIndex<ElementType, IndexType>* nnIndex;
 
 		switch (indexType_) {
 		case TREE_INDEX_KDTREE:
-			nnIndex = createIndex<KDTreeIndex, ElementType>(dataset_, params_);
+			nnIndex = createIndex<KDTreeIndex, ElementType, IndexType>(dataset_, params_);
+			break;
+		case TREE_INDEX_LBVH:
+			nnIndex = createIndex<LBVHIndex, ElementType, IndexType>(dataset_, params_);
 			break;
 		}
 
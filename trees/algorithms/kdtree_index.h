@@ -34,6 +34,8 @@
 #ifndef TREES_KDTREE_INDEX_H_
 #define TREES_KDTREE_INDEX_H_
 
+#include <limits>
+#include <stdint.h>
 #include <vector>
 
 #include "trees/defines.h"
@@ -43,6 +45,7 @@
 
 #include "trees/utils/params.h"
 #include "trees/utils/result_set.h"
+#include "trees/utils/search_stats.h"
 
 namespace trees
 {
@@ -68,8 +71,8 @@ namespace trees
 	};
 
 
-	template<typename ElementType>
-	class KDTreeIndex : public NNIndex<ElementType>
+	template<typename ElementType, typename IndexType = uint32_t>
+	class KDTreeIndex : public NNIndex<ElementType, IndexType>
 	{
 	public:
 
@@ -79,15 +82,20 @@ namespace trees
 			@param[in] dataset_ Pointcloud
 			@param[in] params_ Input parameters for the tree
 		*/
-		KDTreeIndex(const utils::Matrix<ElementType>& dataset_, const IndexParams& params_ = KDTreeIndexParams()) : root_node(nullptr), dataset_nodes(nullptr)
+		KDTreeIndex(const utils::Matrix<ElementType>& dataset_, const IndexParams& params_ = KDTreeIndexParams()) : root_node(nullptr), dataset_leaves(nullptr), tracked_memory(0)
 		{
 			neighbor = get_param(params_, "neighbor", 30);
 			ordered = get_param(params_, "ordered", true);
 
 			setDataset(dataset_);
+		}
 
-			dataset_points = utils::Matrix<ElementType>(new ElementType[size*veclen], size, veclen);
-			std::copy(dataset[0], dataset[0] + size*veclen, dataset_points[0]);
+		/**
+			Destructor
+		*/
+		~KDTreeIndex()
+		{
+			freeIndex();
 		}
 	
 	private:
@@ -157,7 +165,7 @@ namespace trees
 			/**
 				Indices of points in leaf node
 			*/
-			size_t* indices;
+			IndexType* indices;
 
 			/**
 				Number of points
@@ -184,17 +192,27 @@ namespace trees
 
 		typedef Node* NodePtr;
 
+		/**
+			Marks points which are not assigned to a leaf node
+		*/
+		static const IndexType NO_LEAF = std::numeric_limits<IndexType>::max();
+
 		/**
 			Free allocated memory
 		*/
 		void freeIndex()
 		{
-			if (dataset_nodes) {
-				delete[] dataset_nodes;
-				dataset_nodes = nullptr;
+			UTILS_MEMORY_FREE(utils::MemoryTag::TREE, tracked_memory);
+			tracked_memory = 0;
+
+			if (dataset_leaves) {
+				delete[] dataset_leaves;
+				dataset_leaves = nullptr;
 			}
+			leaves.clear();
 			dataset_points.clearMemory();
 			if (root_node) { root_node->~Node(); }
+			root_node = nullptr;
 			pool.clear();
 		}
 
@@ -206,6 +224,34 @@ namespace trees
 			dataset_ = dataset_points;
 		}
 
+		/**
+			Get the number of bytes allocated by the tree including the ordered copy of the dataset
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			return NNIndex<ElementType, IndexType>::usedMemory() + dataset_points.usedMemory() + pool.usedMemory() + getTreeMemory();
+		}
+
+		/**
+			Get the number of bytes of the structures of the tree which are not allocated in the pool,
+			every point is referenced in exactly one leaf
+
+			@return Number of bytes
+		*/
+		size_t getTreeMemory() const
+		{
+			size_t bytes = vind.capacity() * sizeof(IndexType) + leaves.capacity() * sizeof(NodePtr);
+			if (dataset_leaves) {
+				bytes += size * sizeof(IndexType);
+			}
+			if (!leaves.empty()) {
+				bytes += size * sizeof(IndexType);
+			}
+			return bytes;
+		}
+
 		/**
 			Prepares the building processs of the tree and calls the initial divide function
 		*/
@@ -217,25 +263,40 @@ namespace trees
 				vind[i] = i;
 			}
 
-			dataset_nodes = new NodePtr[size];
+			dataset_leaves = new IndexType[size];
+			leaves.clear();
+
+			/**
+				The tree is built on the borrowed dataset, only an ordered tree stores its own copy 
+				of the points in the order of the leaves
+			*/
+			dataset_points = utils::Matrix<ElementType>::borrow(dataset.getPtr(), size, veclen);
 
 			computeBoundingBox(root_bbox);
 			root_node = divideTree(nullptr, 0, size, root_bbox);
 			
 			if (ordered) {
-				utils::Matrix<ElementType> dataset_points_temp = utils::Matrix<ElementType>(new ElementType[size*veclen], size, veclen);
-				for (size_t i = 0; i < size; ++i) {
-					std::copy(dataset_points[vind[i]], dataset_points[vind[i]] + veclen, dataset_points_temp[i]);
-				}
-				dataset_points = dataset_points_temp;
+				utils::Matrix<ElementType> dataset_points_temp = utils::Matrix<ElementType>::uninitialized(size, veclen);
+				/**
+					In numa mode the copy is written by the threads which will search it
+				*/
+				utils::parallelFirstTouch(size, 1, [&](size_t begin_, size_t end_) {
+					for (size_t i = begin_; i < end_; ++i) {
+						std::copy(dataset_points[vind[i]], dataset_points[vind[i]] + veclen, dataset_points_temp[i]);
+					}
+				});
+				dataset_points = std::move(dataset_points_temp);
 
-				NodePtr* dataset_nodes_temp = new NodePtr[size];
+				IndexType* dataset_leaves_temp = new IndexType[size];
 				for (size_t i = 0; i < size; ++i) {
-					dataset_nodes_temp[i] = dataset_nodes[vind[i]];
+					dataset_leaves_temp[i] = dataset_leaves[vind[i]];
 				}
-				delete[] dataset_nodes;
-				dataset_nodes = dataset_nodes_temp;
+				delete[] dataset_leaves;
+				dataset_leaves = dataset_leaves_temp;
 			}
+
+			tracked_memory = getTreeMemory();
+			UTILS_MEMORY_ALLOCATE(utils::MemoryTag::TREE, tracked_memory);
 		}
 
 		/**
@@ -243,11 +304,16 @@ namespace trees
 		*/
 		void freeBuild() 
 		{
-			if (dataset_nodes) {
-				delete[] dataset_nodes;
-				dataset_nodes = nullptr;
+			UTILS_MEMORY_FREE(utils::MemoryTag::TREE, tracked_memory);
+			tracked_memory = 0;
+
+			if (dataset_leaves) {
+				delete[] dataset_leaves;
+				dataset_leaves = nullptr;
 			}
+			leaves.clear();
 			if (root_node) { root_node->~Node(); }
+			root_node = nullptr;
 			pool.clear();
 		}
 
@@ -260,9 +326,6 @@ namespace trees
 		{
 			setDataset(dataset_);
 
-			dataset_points.setMatrix(new ElementType[size*veclen], size, veclen);
-			std::copy(dataset[0], dataset[0] + size*veclen, dataset_points[0]);
-
 			buildIndex();
 		}
 
@@ -306,11 +369,14 @@ namespace trees
 				node->child1 = node->child2 = nullptr;    /* Mark as leaf node. */
 				
 				node->points = right_ - left_;
-				node->indices= new size_t[node->points];
+				node->indices= new IndexType[node->points];
+
+				IndexType leaf = (IndexType)leaves.size();
+				leaves.push_back(node);
 				for (size_t i = left_; i < right_; i++) {
-					node->indices[i - left_] = i;
+					node->indices[i - left_] = (IndexType)i;
 
-					dataset_nodes[vind[i]] = node;
+					dataset_leaves[vind[i]] = leaf;
 				}
 
 				// compute bounding-box of leaf points
@@ -363,7 +429,7 @@ namespace trees
 			@param[in,out] max_elem_ Maximal value
 
 		*/
-		void computeMinMax(size_t* ind_, int count_, size_t dim_, ElementType& min_elem_, ElementType& max_elem_)
+		void computeMinMax(IndexType* ind_, int count_, size_t dim_, ElementType& min_elem_, ElementType& max_elem_)
 		{
 			min_elem_ = dataset_points[ind_[0]][dim_];
 			max_elem_ = dataset_points[ind_[0]][dim_];
@@ -384,7 +450,7 @@ namespace trees
 			@param[in,out] cutval_ Value of the point where the list will be split
 			@param[in] bbox_ Bounding Box of the entire pointcloud
 		*/
-		void middleSplit(size_t* ind_, int count_, int& index_, int& cutfeat_, ElementType& cutval_, const BoundingBox& bbox_)
+		void middleSplit(IndexType* ind_, int count_, int& index_, int& cutfeat_, ElementType& cutval_, const BoundingBox& bbox_)
 		{
 			// find the largest span from the approximate bounding box
 			ElementType max_span = bbox_[0].high - bbox_[0].low;
@@ -442,7 +508,7 @@ namespace trees
 			@param[in,out] lim1_ Left index which is the split index
 			@param[in,out] lim2_ Right index which is the plit index
 		*/
-		void planeSplit(size_t* ind_, int count_, int cutfeat_, ElementType cutval_, int& lim1_, int& lim2_)
+		void planeSplit(IndexType* ind_, int count_, int cutfeat_, ElementType cutval_, int& lim1_, int& lim2_)
 		{
 			int left = 0;
 			int right = count_ - 1;
@@ -480,7 +546,7 @@ namespace trees
 			bool flag = false;
 
 			size_t index = ordered ? vind[index_] : index_;
-			NodePtr node = dataset_nodes[index];
+			NodePtr node = dataset_leaves[index] != NO_LEAF ? leaves[dataset_leaves[index]] : nullptr;
 
 			if (node)
 			{
@@ -499,7 +565,7 @@ namespace trees
 					node->parent->removeChild(node);
 				}
 
-				dataset_nodes[index] = nullptr;
+				dataset_leaves[index] = NO_LEAF;
 			}
 
 			return flag;
@@ -514,15 +580,26 @@ namespace trees
 			@param[in] vec_ Point which neighbors shall be found
 			@param[in] params_ Input parameters for the search
 		*/
-		void findNeighbors(ResultSet<ElementType>& result_set_, const ElementType* vec_, const TreeParams& params_) const
+		void findNeighbors(ResultSet<ElementType, IndexType>& result_set_, const ElementType* vec_, const TreeParams& params_) const
 		{
 			float epsError = 1 + params_.getEpsilon();
 
+#ifdef TREES_SEARCH_STATS
+			SearchCounters& counters = getSearchCounters();
+			counters.clear();
+			counters.queries = 1;
+#endif
+
 			std::vector<ElementType> dists(veclen, 0);
 			ElementType distsq = computeInitialDistances(vec_, dists);
 
 			searchLevel(result_set_, vec_, root_node, distsq, dists, epsError);
 
+#ifdef TREES_SEARCH_STATS
+			if (params_.getSearchStats()) {
+				params_.getSearchStats()->add(counters);
+			}
+#endif
 		}
 		
 	private:
@@ -563,17 +640,23 @@ namespace trees
 			@param[in] epsError_ Error value
 
 		*/
-		void searchLevel(ResultSet<ElementType>& result_set_, const ElementType* vec_, const NodePtr node_, ElementType mindistsq_,
+		void searchLevel(ResultSet<ElementType, IndexType>& result_set_, const ElementType* vec_, const NodePtr node_, ElementType mindistsq_,
 			std::vector<ElementType>& dists_, const float epsError_) const
 		{
+			TREES_SEARCH_COUNT(nodes_visited, 1);
+
 			/* If this is a leaf node, then do check and return. */
 			if ((node_->child1 == nullptr) && (node_->child2 == nullptr)) {
+				TREES_SEARCH_COUNT(leaves_scanned, 1);
+				TREES_SEARCH_COUNT(distance_evaluations, node_->points);
+
 				ElementType worst_dist = result_set_.worstDist();
 				for (int i = 0; i<node_->points; ++i) {	
 					ElementType* point = ordered ? dataset_points[node_->indices[i]] : dataset_points[vind[node_->indices[i]]];
 					
 					ElementType dist = distance(const_cast<ElementType*>(vec_), point, veclen);
 					if (dist<worst_dist) {
+						TREES_SEARCH_COUNT(insertions, 1);
 						result_set_.addPoint(dist, vind[node_->indices[i]]);
 					}
 				}
@@ -612,6 +695,9 @@ namespace trees
 				if (mindistsq_*epsError_ <= result_set_.worstDist()) {
 					searchLevel(result_set_, vec_, other_child, mindistsq_, dists_, epsError_);
 				}
+				else {
+					TREES_SEARCH_COUNT(pruned_branches, 1);
+				}
 				dists_[idx] = dst;
 			}
 		}
@@ -636,7 +722,7 @@ namespace trees
 		/**
 			Array of indices to vectors in the dataset.
 		*/
-		std::vector<size_t> vind;
+		std::vector<IndexType> vind;
 		
 		/**
 			Pooled memory allocator.
@@ -654,9 +740,19 @@ namespace trees
 		utils::Matrix<ElementType> dataset_points;
 
 		/**
-			List with the indices to nodes
+			List with the leaf nodes
+		*/
+		std::vector<NodePtr> leaves;
+
+		/**
+			List with the indices of the leaf nodes of the points
+		*/
+		IndexType* dataset_leaves;
+
+		/**
+			Number of bytes of the tree which are registered at the memory tracker
 		*/
-		NodePtr* dataset_nodes;
+		size_t tracked_memory;
 
 		/**
 			Distance structure
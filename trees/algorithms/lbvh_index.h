@@ -0,0 +1,641 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef TREES_LBVH_INDEX_H_
+#define TREES_LBVH_INDEX_H_
+
+#include <atomic>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+#include "trees/defines.h"
+#include "trees/algorithms/nn_index.h"
+
+#include "tools/utils.h"
+
+#include "trees/utils/params.h"
+#include "trees/utils/result_set.h"
+#include "trees/utils/search_stats.h"
+
+namespace trees
+{
+
+	/**
+		Input parameters for the linear bounding volume hierarchy
+	*/
+	struct LBVHIndexParams : public IndexParams
+	{
+		/**
+			Constructor
+
+			@param[in] neighbor_ Maximal number of points in one leaf
+			@param[in] cores_ Number of cores used for building the hierarchy
+		*/
+		LBVHIndexParams(int neighbor_ = 30, int cores_ = 1)
+		{
+			(*this)["index"] = TREE_INDEX_LBVH;
+			(*this)["neighbor"] = neighbor_;
+			(*this)["cores"] = cores_;
+		}
+	};
+
+	/**
+		Linear bounding volume hierarchy for three dimensional pointclouds. The points are sorted 
+		along a morton curve and grouped into leaves of consecutive points, the hierarchy is emitted 
+		from the sorted morton codes of the leaves, where every internal node can be computed 
+		independently (Karras, 2012). The build is linear in the number of points and runs in 
+		parallel, but the resulting tree is less balanced than the one of KDTreeIndex.
+	*/
+	template<typename ElementType, typename IndexType = uint32_t>
+	class LBVHIndex : public NNIndex<ElementType, IndexType>
+	{
+	public:
+
+		/**
+			Constructor
+
+			@param[in] dataset_ Pointcloud
+			@param[in] params_ Input parameters for the tree
+		*/
+		LBVHIndex(const utils::Matrix<ElementType>& dataset_, const IndexParams& params_ = LBVHIndexParams()) : tracked_memory(0)
+		{
+			neighbor = get_param(params_, "neighbor", 30);
+			cores = get_param(params_, "cores", 1);
+
+			setDataset(dataset_);
+
+			if (veclen != 3) {
+				std::cout << "LBVHIndex supports only three dimensional pointclouds" << std::endl;
+				exitFailure(__FILE__, __LINE__);
+			}
+		}
+
+		/**
+			Destructor
+		*/
+		~LBVHIndex()
+		{
+			freeIndex();
+		}
+
+	private:
+
+		/**
+			Marks children which are leaves
+		*/
+		static const IndexType LEAF_FLAG = (IndexType)1 << (sizeof(IndexType) * 8 - 1);
+
+		/**
+			Marks the missing parent of the root
+		*/
+		static const IndexType NO_PARENT = std::numeric_limits<IndexType>::max();
+
+		/**
+			Structure for an internal node of the hierarchy
+		*/
+		struct Node
+		{
+			/**
+				The child nodes, leaves are marked with LEAF_FLAG
+			*/
+			IndexType child1, child2;
+
+			/**
+				Parent
+			*/
+			IndexType parent;
+		};
+
+		/**
+			Structure for a leaf of the hierarchy
+		*/
+		struct Leaf
+		{
+			/**
+				Range of the points in the sorted pointcloud
+			*/
+			IndexType begin, end;
+
+			/**
+				Parent
+			*/
+			IndexType parent;
+		};
+
+		/**
+			Free allocated memory
+		*/
+		void freeIndex()
+		{
+			freeBuild();
+			dataset_points.clearMemory();
+		}
+
+		/**
+			Get the dataset
+		*/
+		void getDataset(utils::Matrix<ElementType>& dataset_)
+		{
+			dataset_ = dataset;
+		}
+
+		/**
+			Get the number of bytes allocated by the hierarchy including the ordered copy of the dataset
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			return NNIndex<ElementType, IndexType>::usedMemory() + dataset_points.usedMemory() + getTreeMemory();
+		}
+
+		/**
+			Get the number of bytes of the nodes, leaves and lists of the hierarchy
+
+			@return Number of bytes
+		*/
+		size_t getTreeMemory() const
+		{
+			return nodes.capacity() * sizeof(Node) +
+				leaves.capacity() * sizeof(Leaf) +
+				(node_bboxes.capacity() + leaf_bboxes.capacity()) * sizeof(ElementType) +
+				(vind.capacity() + positions.capacity()) * sizeof(IndexType) +
+				removed.capacity() * sizeof(uint8_t);
+		}
+
+		/**
+			Free allocated memory for build process
+		*/
+		void freeBuild()
+		{
+			UTILS_MEMORY_FREE(utils::MemoryTag::TREE, tracked_memory);
+			tracked_memory = 0;
+
+			nodes.clear();
+			leaves.clear();
+			node_bboxes.clear();
+			leaf_bboxes.clear();
+			vind.clear();
+			positions.clear();
+			removed.clear();
+		}
+
+		/**
+			Rebuilds the index
+
+			@param[in] dataset_ Pointcloud
+		*/
+		void rebuild(const utils::Matrix<ElementType>& dataset_)
+		{
+			setDataset(dataset_);
+
+			buildIndex();
+		}
+
+		/**
+			Sorts the points along the morton curve, creates the leaves and emits the hierarchy
+		*/
+		void buildIndexImpl()
+		{
+			if (!size) {
+				return;
+			}
+
+			/**
+				Sort the points along the morton curve and store them in this order
+			*/
+			std::vector<uint64_t> codes;
+			std::vector<size_t> order;
+			utils::computeMortonCodes<ElementType>(dataset.getPtr(), size, veclen, codes);
+			utils::radixSort(codes, order, cores);
+
+			vind.resize(size);
+			positions.resize(size);
+			removed.assign(size, 0);
+			dataset_points = utils::Matrix<ElementType>::uninitialized(size, veclen);
+			utils::parallelFirstTouch(size, cores, [&](size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					vind[i] = (IndexType)order[i];
+					positions[order[i]] = (IndexType)i;
+					std::copy(dataset[order[i]], dataset[order[i]] + veclen, dataset_points[i]);
+				}
+			});
+
+			/**
+				Group consecutive points into leaves, the first code of every leaf is its key
+			*/
+			size_t number_of_leaves = (size + neighbor - 1) / neighbor;
+			leaves.resize(number_of_leaves);
+			leaf_codes.resize(number_of_leaves);
+			for (size_t i = 0; i < number_of_leaves; i++) {
+				leaves[i].begin = (IndexType)(i * neighbor);
+				leaves[i].end = (IndexType)std::min(size, (i + 1) * neighbor);
+				leaves[i].parent = NO_PARENT;
+				leaf_codes[i] = codes[i * neighbor];
+			}
+
+			/**
+				Emit the internal nodes, each one independently of the others
+			*/
+			nodes.resize(number_of_leaves - 1);
+			utils::parallelChunks(nodes.size(), cores, [&](size_t, size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					emitNode(i);
+				}
+			});
+			for (size_t i = 0; i < nodes.size(); i++) {
+				setParent(nodes[i].child1, (IndexType)i);
+				setParent(nodes[i].child2, (IndexType)i);
+			}
+			if (!nodes.empty()) {
+				nodes[0].parent = NO_PARENT;
+			}
+
+			computeBoundingBoxes();
+
+			leaf_codes.clear();
+			leaf_codes.shrink_to_fit();
+
+			tracked_memory = getTreeMemory();
+			UTILS_MEMORY_ALLOCATE(utils::MemoryTag::TREE, tracked_memory);
+		}
+
+		/**
+			Computes the length of the common prefix of the keys of two leaves, identical keys are 
+			distinguished by the position of the leaves
+
+			@param[in] i_ First leaf
+			@param[in] j_ Second leaf
+			@return Length of the common prefix, -1 if the second leaf does not exist
+		*/
+		int delta(int64_t i_, int64_t j_) const
+		{
+			if (j_ < 0 || j_ >= (int64_t)leaf_codes.size()) {
+				return -1;
+			}
+			if (leaf_codes[i_] == leaf_codes[j_]) {
+				return 64 + utils::countLeadingZeros((uint64_t)(i_ ^ j_));
+			}
+			return utils::countLeadingZeros(leaf_codes[i_] ^ leaf_codes[j_]);
+		}
+
+		/**
+			Determines the range of leaves covered by an internal node and the position where this 
+			range is split
+
+			@param[in] index_ Index of the internal node
+		*/
+		void emitNode(size_t index_)
+		{
+			int64_t i = (int64_t)index_;
+
+			/**
+				Direction of the range
+			*/
+			int d = delta(i, i + 1) - delta(i, i - 1) > 0 ? 1 : -1;
+
+			/**
+				Upper bound of the length of the range
+			*/
+			int delta_min = delta(i, i - d);
+			int64_t lmax = 2;
+			while (delta(i, i + lmax * d) > delta_min) {
+				lmax *= 2;
+			}
+
+			/**
+				Other end of the range
+			*/
+			int64_t l = 0;
+			for (int64_t t = lmax / 2; t >= 1; t /= 2) {
+				if (delta(i, i + (l + t) * d) > delta_min) {
+					l += t;
+				}
+			}
+			int64_t j = i + l * d;
+
+			/**
+				Split position
+			*/
+			int delta_node = delta(i, j);
+			int64_t s = 0;
+			int64_t t = l;
+			do {
+				t = (t + 1) / 2;
+				if (delta(i, i + (s + t) * d) > delta_node) {
+					s += t;
+				}
+			} while (t > 1);
+			int64_t gamma = i + s * d + std::min(d, 0);
+
+			nodes[index_].child1 = std::min(i, j) == gamma ? (IndexType)gamma | LEAF_FLAG : (IndexType)gamma;
+			nodes[index_].child2 = std::max(i, j) == gamma + 1 ? (IndexType)(gamma + 1) | LEAF_FLAG : (IndexType)(gamma + 1);
+		}
+
+		/**
+			Sets the parent of a node
+
+			@param[in] child_ Child node, leaves are marked with LEAF_FLAG
+			@param[in] parent_ Parent node
+		*/
+		void setParent(IndexType child_, IndexType parent_)
+		{
+			if (child_ & LEAF_FLAG) {
+				leaves[child_ & ~LEAF_FLAG].parent = parent_;
+			}
+			else {
+				nodes[child_].parent = parent_;
+			}
+		}
+
+		/**
+			Computes the bounding boxes of the leaves and propagates them to the root, the second 
+			child which reaches a node computes its bounding box
+		*/
+		void computeBoundingBoxes()
+		{
+			leaf_bboxes.resize(leaves.size() * 2 * veclen);
+			node_bboxes.resize(nodes.size() * 2 * veclen);
+			std::vector<std::atomic<int>> visits(nodes.size());
+			for (size_t i = 0; i < visits.size(); i++) {
+				visits[i] = 0;
+			}
+
+			utils::parallelChunks(leaves.size(), cores, [&](size_t, size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					ElementType* bbox = &leaf_bboxes[i * 2 * veclen];
+					for (size_t k = 0; k < veclen; k++) {
+						bbox[k] = bbox[veclen + k] = dataset_points[leaves[i].begin][k];
+					}
+					for (size_t j = leaves[i].begin + 1; j < leaves[i].end; j++) {
+						for (size_t k = 0; k < veclen; k++) {
+							bbox[k] = std::min(bbox[k], dataset_points[j][k]);
+							bbox[veclen + k] = std::max(bbox[veclen + k], dataset_points[j][k]);
+						}
+					}
+
+					IndexType parent = leaves[i].parent;
+					while (parent != NO_PARENT && visits[parent].fetch_add(1, std::memory_order_acq_rel) == 1) {
+						const ElementType* bbox1 = getBoundingBox(nodes[parent].child1);
+						const ElementType* bbox2 = getBoundingBox(nodes[parent].child2);
+						ElementType* bbox_parent = &node_bboxes[parent * 2 * veclen];
+						for (size_t k = 0; k < veclen; k++) {
+							bbox_parent[k] = std::min(bbox1[k], bbox2[k]);
+							bbox_parent[veclen + k] = std::max(bbox1[veclen + k], bbox2[veclen + k]);
+						}
+						parent = nodes[parent].parent;
+					}
+				}
+			});
+		}
+
+		/**
+			Get the bounding box of a node, the lower bounds are followed by the upper bounds
+
+			@param[in] node_ Node, leaves are marked with LEAF_FLAG
+			@return Pointer to the bounding box
+		*/
+		const ElementType* getBoundingBox(IndexType node_) const
+		{
+			if (node_ & LEAF_FLAG) {
+				return &leaf_bboxes[(node_ & ~LEAF_FLAG) * 2 * veclen];
+			}
+			return &node_bboxes[node_ * 2 * veclen];
+		}
+
+		/**
+			Removes point from the hierarchy, the point is only marked and skipped during search
+
+			@param[in] index_ Index of the point in the pointcloud
+			@return True when removing of point was successful
+		*/
+		bool remove(size_t index_)
+		{
+			if (index_ >= size) {
+				exitFailure(__FILE__, __LINE__);
+			}
+
+			if (removed[positions[index_]]) {
+				return false;
+			}
+
+			removed[positions[index_]] = 1;
+			return true;
+		}
+
+	public:
+
+		/**
+			Prepares the search process and calls the search function
+
+			@param[in,out] result_set_ Container which contains the found neighbors
+			@param[in] vec_ Point which neighbors shall be found
+			@param[in] params_ Input parameters for the search
+		*/
+		void findNeighbors(ResultSet<ElementType, IndexType>& result_set_, const ElementType* vec_, const TreeParams& params_) const
+		{
+			if (leaves.empty()) {
+				return;
+			}
+
+			float epsError = 1 + params_.getEpsilon();
+
+#ifdef TREES_SEARCH_STATS
+			SearchCounters& counters = getSearchCounters();
+			counters.clear();
+			counters.queries = 1;
+#endif
+
+			IndexType root = nodes.empty() ? (0 | LEAF_FLAG) : 0;
+			searchLevel(result_set_, vec_, root, epsError);
+
+#ifdef TREES_SEARCH_STATS
+			if (params_.getSearchStats()) {
+				params_.getSearchStats()->add(counters);
+			}
+#endif
+		}
+
+	private:
+
+		/**
+			Computes the squared distance between a point and a bounding box
+
+			@param[in] vec_ Point
+			@param[in] bbox_ Bounding box
+			@return Squared distance
+		*/
+		ElementType computeBoxDistance(const ElementType* vec_, const ElementType* bbox_) const
+		{
+			ElementType distsq = 0;
+			for (size_t i = 0; i < veclen; ++i) {
+				if (vec_[i] < bbox_[i]) {
+					distsq += (bbox_[i] - vec_[i])*(bbox_[i] - vec_[i]);
+				}
+				else if (vec_[i] > bbox_[veclen + i]) {
+					distsq += (vec_[i] - bbox_[veclen + i])*(vec_[i] - bbox_[veclen + i]);
+				}
+			}
+			return distsq;
+		}
+
+		/**
+			Performs an exact search in the hierarchy starting from a node, the child which is 
+			closer to the point is examined first
+
+			@param[in,out] result_set_ Container which contains the found neighbors
+			@param[in] vec_ Point which neighbors shall be found
+			@param[in] node_ Node which will be examined, leaves are marked with LEAF_FLAG
+			@param[in] epsError_ Error value
+		*/
+		void searchLevel(ResultSet<ElementType, IndexType>& result_set_, const ElementType* vec_, IndexType node_, const float epsError_) const
+		{
+			TREES_SEARCH_COUNT(nodes_visited, 1);
+
+			if (node_ & LEAF_FLAG) {
+				const Leaf& leaf = leaves[node_ & ~LEAF_FLAG];
+
+				TREES_SEARCH_COUNT(leaves_scanned, 1);
+				TREES_SEARCH_COUNT(distance_evaluations, leaf.end - leaf.begin);
+
+				ElementType worst_dist = result_set_.worstDist();
+				for (IndexType i = leaf.begin; i < leaf.end; ++i) {
+					if (removed[i]) {
+						continue;
+					}
+					ElementType dist = distance(const_cast<ElementType*>(vec_), dataset_points[i], veclen);
+					if (dist < worst_dist) {
+						TREES_SEARCH_COUNT(insertions, 1);
+						result_set_.addPoint(dist, vind[i]);
+					}
+				}
+				return;
+			}
+
+			const Node& node = nodes[node_];
+			ElementType dist1 = computeBoxDistance(vec_, getBoundingBox(node.child1));
+			ElementType dist2 = computeBoxDistance(vec_, getBoundingBox(node.child2));
+
+			IndexType best_child = node.child1;
+			IndexType other_child = node.child2;
+			if (dist2 < dist1) {
+				std::swap(best_child, other_child);
+				std::swap(dist1, dist2);
+			}
+
+			if (dist1*epsError_ <= result_set_.worstDist()) {
+				searchLevel(result_set_, vec_, best_child, epsError_);
+			}
+			else {
+				TREES_SEARCH_COUNT(pruned_branches, 1);
+			}
+
+			if (dist2*epsError_ <= result_set_.worstDist()) {
+				searchLevel(result_set_, vec_, other_child, epsError_);
+			}
+			else {
+				TREES_SEARCH_COUNT(pruned_branches, 1);
+			}
+		}
+
+	private:
+
+		/**
+			Maximal number of points in a leaf
+		*/
+		size_t neighbor;
+
+		/**
+			Number of cores used for building the hierarchy
+		*/
+		size_t cores;
+
+		/**
+			Internal nodes, the root is the first node
+		*/
+		std::vector<Node> nodes;
+
+		/**
+			Leaves
+		*/
+		std::vector<Leaf> leaves;
+
+		/**
+			Morton codes of the leaves, only needed during the build
+		*/
+		std::vector<uint64_t> leaf_codes;
+
+		/**
+			Bounding boxes of the internal nodes
+		*/
+		std::vector<ElementType> node_bboxes;
+
+		/**
+			Bounding boxes of the leaves
+		*/
+		std::vector<ElementType> leaf_bboxes;
+
+		/**
+			Index of every sorted point in the pointcloud
+		*/
+		std::vector<IndexType> vind;
+
+		/**
+			Position of every point of the pointcloud in the sorted pointcloud
+		*/
+		std::vector<IndexType> positions;
+
+		/**
+			Flags of removed points in the sorted pointcloud
+		*/
+		std::vector<uint8_t> removed;
+
+		/**
+			Pointcloud sorted along the morton curve
+		*/
+		utils::Matrix<ElementType> dataset_points;
+
+		/**
+			Number of bytes of the hierarchy which are registered at the memory tracker
+		*/
+		size_t tracked_memory;
+
+		/**
+			Distance structure
+		*/
+		utils::L2<ElementType> distance;
+	};
+
+}
+
+#endif /* TREES_LBVH_INDEX_H_ */
@@ -34,7 +34,10 @@
 #ifndef TREES_NN_INDEX_H_
 #define TREES_NN_INDEX_H_
 
+#include <algorithm>
 #include <assert.h>
+#include <limits>
+#include <stdint.h>
 
 #include "tools/utils.h"
 
@@ -44,7 +47,12 @@
 namespace trees
 {
 
-	template<typename ElementType>
+	/**
+		Base class of the indices, the type of the indices of the points stored in the tree is given
+		by IndexType, which determines the memory consumption of the tree and the result sets. The
+		default 32-bit indices are sufficient for pointclouds with less than 2^32 points.
+	*/
+	template<typename ElementType, typename IndexType = uint32_t>
 	class NNIndex
 	{
 	
@@ -57,6 +65,13 @@ namespace trees
 		{
 		}
 
+		/**
+			Destructor
+		*/
+		virtual ~NNIndex()
+		{
+		}
+
 		/**
 			Free allocated memory
 		*/
@@ -69,16 +84,37 @@ namespace trees
 		virtual void getDataset(utils::Matrix<ElementType>& dataset_) = 0;
 
 		/**
-			Set parameters based on the input pointcloud
+			Get the number of dimensions of the data
+
+			@return Number of dimensions
+		*/
+		size_t getVeclen() const
+		{
+			return veclen;
+		}
+
+		/**
+			Set parameters based on the input pointcloud, the index borrows the pointcloud without 
+			copying it, so it has to outlive the index
 			
 			@param[in] dataset_ Pointcloud
 		*/
 		void setDataset(const utils::Matrix<ElementType>& dataset_)
 		{
+			/**
+				The indices of the points must be representable by IndexType, callers which do not 
+				know the size in advance select the type by the number of points, see 
+				pointcloud::computeNormals
+			*/
+			if (dataset_.getRows() > (size_t)std::numeric_limits<IndexType>::max()) {
+				std::cout << "Pointcloud exceeds the range of the index type, use a wider index type" << std::endl;
+				exitFailure(__FILE__, __LINE__);
+			}
+
 			size = dataset_.getRows();
 			veclen = dataset_.getCols();
 
-			dataset = dataset_;
+			dataset = utils::Matrix<ElementType>::borrow(const_cast<ElementType*>(dataset_.getPtr()), size, veclen);
 		}
 
 		/**
@@ -115,6 +151,16 @@ namespace trees
 		*/
 		virtual bool remove(size_t index_) = 0;
 
+		/**
+			Get the number of bytes allocated by the index, the borrowed dataset is not accounted
+
+			@return Number of bytes
+		*/
+		virtual size_t usedMemory() const
+		{
+			return 0;
+		}
+
 		/**
 			Prepares the search process, computes initial distances and calls the search function
 			
@@ -122,10 +168,11 @@ namespace trees
 			@param[in] vec_ Point which neighbors shall be found
 			@param[in] params_ Input parameters for the search
 		*/
-		virtual void findNeighbors(ResultSet<ElementType>& result_set_, const ElementType* vec_, const TreeParams& params_) const = 0;
+		virtual void findNeighbors(ResultSet<ElementType, IndexType>& result_set_, const ElementType* vec_, const TreeParams& params_) const = 0;
 
 		/**
-			Perform k-nearest neighbor search
+			Perform k-nearest neighbor search, the indices are written directly into the container of the
+			caller, so the type of the indices might differ from IndexType
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
 			@param[in,out] indices_ The indices of the nearest neighbors found
@@ -133,32 +180,24 @@ namespace trees
 			@param[in] knn_ Number of nearest neighbors to return
 			@param[in] params_ Search parameters
 		*/
+		template<typename OutIndexType>
 		void knnSearch(const utils::Matrix<ElementType>& queries_,
-			utils::Matrix<size_t>& indices_,
+			utils::Matrix<OutIndexType>& indices_,
 			utils::Matrix<ElementType>& dists_,
 			size_t knn_,
 			const TreeParams& params_)
 		{
-			assert(queries_.cols == veclen());
-			assert(indices_.rows >= queries_.rows);
-			assert(dists_.rows >= queries_.rows);
-			assert(indices_.cols >= knn_);
-			assert(dists_.cols >= knn_);
+			assert(queries_.getCols() == veclen);
+			assert(indices_.getRows() >= queries_.getRows());
+			assert(dists_.getRows() >= queries_.getRows());
+			assert(indices_.getCols() >= knn_);
+			assert(dists_.getCols() >= knn_);
 			
-			utils::Threadpool pool(params_.getCores());
-
-			for (int i = 0; i < queries_.getRows(); i++) {
-				while (!pool.runTask(boost::bind(&NNIndex<ElementType>::knnSearchThreadpool,
-					this, 
-					boost::ref(queries_), 
-					boost::ref(indices_), 
-					boost::ref(dists_), 
-					knn_,
-					boost::ref(params_), 
-					i)));
-			}
-
-			pool.shutdown();
+			utils::parallel_for(0, queries_.getRows(), params_.getGrain(), [&](size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					knnSearchThreadpool(queries_, indices_, dists_, knn_, params_, i);
+				}
+			}, params_.getCores());
 		}
 
 		/**
@@ -171,14 +210,15 @@ namespace trees
 			@param[in] params_ Search parameters
 			@param[in] index_ Number of the row of the queries
 		*/
+		template<typename OutIndexType>
 		void knnSearchThreadpool(const utils::Matrix<ElementType>& queries_,
-								 utils::Matrix<size_t>& indices_,
+								 utils::Matrix<OutIndexType>& indices_,
 								 utils::Matrix<ElementType>& dists_,
 								size_t knn_,
 								const TreeParams& params_,
 								size_t index_)
 		{
-			KNNResultSet2<ElementType> resultSet(knn_);
+			KNNResultSet2<ElementType, IndexType> resultSet(knn_);
 			resultSet.clear();
 			findNeighbors(resultSet, queries_[index_], params_);
 			size_t n = std::min(resultSet.size(), knn_);
@@ -186,29 +226,29 @@ namespace trees
 		}
 
 		/**
-			Perform k-nearest neighbor search
+			Perform radius search, the indices are written directly into the container of the caller, 
+			so the type of the indices might differ from IndexType
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
 			@param[in,out] indices_ The indices of the nearest neighbors found
 			@param[in,out] dists_ Distances to the nearest neighbors found
-			@param[in] knn_ Number of nearest neighbors to return
+			@param[in] radius_ The radius used for search
 			@param[in] params_ Search parameters
 		*/
-		void knnSearch(const utils::Matrix<ElementType>& queries_,
-			utils::Matrix<int>& indices_,
-			utils::Matrix<ElementType>& dists_,
-			size_t knn_,
+		template<typename OutIndexType>
+		void radiusSearch(const utils::Matrix<ElementType>& queries_,
+			std::vector< std::vector<OutIndexType> >& indices_,
+			std::vector<std::vector<ElementType>>& dists_,
+			float radius_,
 			const TreeParams& params_)
 		{
-			utils::::Matrix<size_t> indices(new size_t[indices_.rows*indices_.cols], indices_.rows, indices_.cols);
-			knnSearch(queries_, indices, dists_, knn_, params_);
+			assert(queries_.getCols() == veclen);
 
-			for (size_t i = 0; i < indices_.rows; ++i) {
-				for (size_t j = 0; j < indices_.cols; ++j) {
-					indices_[i][j] = indices[i][j];
+			utils::parallel_for(0, queries_.getRows(), params_.getGrain(), [&](size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					radiusSearchThread(queries_, indices_, dists_, radius_, params_, i);
 				}
-			}
-			delete[] indices.ptr();
+			}, params_.getCores());
 		}
 
 		/**
@@ -219,83 +259,190 @@ namespace trees
 			@param[in,out] dists_ Distances to the nearest neighbors found
 			@param[in] radius_ The radius used for search
 			@param[in] params_ Search parameters
+			@param[in] index_ Number of the row of the queries
 		*/
-		void radiusSearch(const utils::Matrix<ElementType>& queries_,
-			std::vector< std::vector<size_t> >& indices_,
+		template<typename OutIndexType>
+		void radiusSearchThread(const utils::Matrix<ElementType>& queries_,
+			std::vector< std::vector<OutIndexType>>& indices_,
 			std::vector<std::vector<ElementType>>& dists_,
 			float radius_,
+			const TreeParams& params_,
+			size_t index_)
+		{
+			RadiusResultSet<ElementType, IndexType> resultSet(radius_);
+			resultSet.clear();
+			findNeighbors(resultSet, queries_[index_], params_);
+			size_t n = resultSet.size();
+
+			if (n > 0) {
+				indices_[index_].resize(n);
+				dists_[index_].resize(n);
+				resultSet.copy(&indices_[index_][0], &dists_[index_][0], n);
+			}
+		}
+
+		/**
+			Perform k-nearest neighbor search with a different number of neighbors for every query. The 
+			neighbors of all queries are stored consecutively, the neighbors of query i are found between
+			offsets_[i] and offsets_[i+1]
+
+			@param[in] queries_ The query points for which to find the nearest neighbors
+			@param[in] knn_ Number of nearest neighbors to return for every query
+			@param[in,out] indices_ The indices of the nearest neighbors found
+			@param[in,out] dists_ Distances to the nearest neighbors found
+			@param[in,out] offsets_ Offsets of the neighbors of every query, number of queries + 1 elements
+			@param[in] params_ Search parameters
+		*/
+		template<typename OutIndexType>
+		void knnSearch(const utils::Matrix<ElementType>& queries_,
+			const std::vector<size_t>& knn_,
+			std::vector<OutIndexType>& indices_,
+			std::vector<ElementType>& dists_,
+			std::vector<size_t>& offsets_,
 			const TreeParams& params_)
 		{
-			assert(queries.cols == veclen());
-
-			utils::Threadpool pool(params_.cores);
-
-			for (int i = 0; i < queries_.rows; i++) {
-				while (!pool.runTask(boost::bind(&NNIndex<ElementType>::radiusSearchThread,
-					this,
-					boost::ref(queries_),
-					boost::ref(indices_),
-					boost::ref(dists_),
-					radius_,
-					boost::ref(params_),
-					i)));
+			assert(queries_.getCols() == veclen);
+			assert(knn_.size() >= queries_.getRows());
+
+			/**
+				Reserve the space for the neighbors of every query
+			*/
+			offsets_.resize(queries_.getRows() + 1);
+			offsets_[0] = 0;
+			for (size_t i = 0; i < queries_.getRows(); i++) {
+				offsets_[i + 1] = offsets_[i] + std::min(knn_[i], size);
 			}
+			indices_.resize(offsets_[queries_.getRows()]);
+			dists_.resize(offsets_[queries_.getRows()]);
+
+			std::vector<size_t> counts(queries_.getRows());
+
+			utils::parallel_for(0, queries_.getRows(), params_.getGrain(), [&](size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					knnSearchOffsetsThreadpool(queries_, indices_, dists_, offsets_, counts, params_, i);
+				}
+			}, params_.getCores());
 
-			pool.shutdown();
+			compactOffsets(indices_, dists_, offsets_, counts);
 		}
 
 		/**
-			Perform radius search
+			Perform k-nearest neighbor search with a different number of neighbors for every query
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
 			@param[in,out] indices_ The indices of the nearest neighbors found
 			@param[in,out] dists_ Distances to the nearest neighbors found
-			@param[in] radius_ The radius used for search
+			@param[in] offsets_ Offsets of the neighbors of every query, they define the number of 
+				neighbors of every query
+			@param[in,out] counts_ Number of neighbors found for every query
 			@param[in] params_ Search parameters
 			@param[in] index_ Number of the row of the queries
 		*/
-		void radiusSearchThread(const utils::Matrix<ElementType>& queries_,
-			std::vector< std::vector<size_t>>& indices_,
-			std::vector<std::vector<ElementType>>& dists_,
-			float radius_,
+		template<typename OutIndexType>
+		void knnSearchOffsetsThreadpool(const utils::Matrix<ElementType>& queries_,
+			std::vector<OutIndexType>& indices_,
+			std::vector<ElementType>& dists_,
+			const std::vector<size_t>& offsets_,
+			std::vector<size_t>& counts_,
 			const TreeParams& params_,
 			size_t index_)
 		{
-			RadiusResultSet<ElementType> resultSet(radius_);
+			size_t knn = offsets_[index_ + 1] - offsets_[index_];
+			if (!knn) {
+				counts_[index_] = 0;
+				return;
+			}
+
+			KNNResultSet2<ElementType, IndexType> resultSet(knn);
 			resultSet.clear();
 			findNeighbors(resultSet, queries_[index_], params_);
-			size_t n = resultSet.size();
-
-			if (n > 0) {
-				indices_[index_].resize(n);
-				dists_[index_].resize(n);
-				resultSet.copy(&indices_[index_][0], &dists_[index_][0], n);
-			}
+			counts_[index_] = std::min(resultSet.size(), knn);
+			resultSet.copy(&indices_[offsets_[index_]], &dists_[offsets_[index_]], counts_[index_]);
 		}
 
 		/**
-			Perform radius search
+			Perform radius search with a different radius for every query. The neighbors of all queries 
+			are stored consecutively, the neighbors of query i are found between offsets_[i] and 
+			offsets_[i+1]
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
+			@param[in] radius_ The radius used for search for every query
 			@param[in,out] indices_ The indices of the nearest neighbors found
 			@param[in,out] dists_ Distances to the nearest neighbors found
-			@param[in] radius_ The radius used for search
+			@param[in,out] offsets_ Offsets of the neighbors of every query, number of queries + 1 elements
 			@param[in] params_ Search parameters
 		*/
+		template<typename OutIndexType>
 		void radiusSearch(const utils::Matrix<ElementType>& queries_,
-			std::vector<std::vector<int>>& indices_,
-			std::vector<std::vector<ElementType>>& dists_,
-			float radius_,
+			const std::vector<float>& radius_,
+			std::vector<OutIndexType>& indices_,
+			std::vector<ElementType>& dists_,
+			std::vector<size_t>& offsets_,
 			const TreeParams& params_)
 		{
-			std::vector<std::vector<size_t> > indices(indices_.size());
-			radiusSearch(queries_, indices, dists_, radius_, params_);
-			
-			for (size_t i = 0; i<indices_.size(); ++i) {
-				indices_[i].assign(indices[i].begin(), indices[i].end());
+			assert(queries_.getCols() == veclen);
+			assert(radius_.size() >= queries_.getRows());
+
+			/**
+				The number of neighbors is not known in advance, so the neighbors are gathered for 
+				every query and concatenated afterwards
+			*/
+			std::vector<std::vector<OutIndexType>> indices(queries_.getRows());
+			std::vector<std::vector<ElementType>> dists(queries_.getRows());
+
+			utils::parallel_for(0, queries_.getRows(), params_.getGrain(), [&](size_t begin_, size_t end_) {
+				for (size_t i = begin_; i < end_; i++) {
+					radiusSearchThread(queries_, indices, dists, radius_[i], params_, i);
+				}
+			}, params_.getCores());
+
+			offsets_.resize(queries_.getRows() + 1);
+			offsets_[0] = 0;
+			for (size_t i = 0; i < queries_.getRows(); i++) {
+				offsets_[i + 1] = offsets_[i] + indices[i].size();
+			}
+			indices_.resize(offsets_[queries_.getRows()]);
+			dists_.resize(offsets_[queries_.getRows()]);
+
+			for (size_t i = 0; i < queries_.getRows(); i++) {
+				std::copy(indices[i].begin(), indices[i].end(), indices_.begin() + offsets_[i]);
+				std::copy(dists[i].begin(), dists[i].end(), dists_.begin() + offsets_[i]);
 			}
 		}
 
+	private:
+
+		/**
+			Removes the gaps between the neighbors of the queries which have less neighbors than 
+			reserved, e.g. if points has been removed from the tree
+
+			@param[in,out] indices_ The indices of the nearest neighbors found
+			@param[in,out] dists_ Distances to the nearest neighbors found
+			@param[in,out] offsets_ Offsets of the neighbors of every query
+			@param[in] counts_ Number of neighbors found for every query
+		*/
+		template<typename OutIndexType>
+		void compactOffsets(std::vector<OutIndexType>& indices_,
+			std::vector<ElementType>& dists_,
+			std::vector<size_t>& offsets_,
+			const std::vector<size_t>& counts_)
+		{
+			size_t loc = 0;
+			for (size_t i = 0; i < counts_.size(); i++) {
+				size_t begin = offsets_[i];
+				if (loc != begin) {
+					std::copy(indices_.begin() + begin, indices_.begin() + begin + counts_[i], indices_.begin() + loc);
+					std::copy(dists_.begin() + begin, dists_.begin() + begin + counts_[i], dists_.begin() + loc);
+				}
+				offsets_[i] = loc;
+				loc += counts_[i];
+			}
+			offsets_[counts_.size()] = loc;
+
+			indices_.resize(loc);
+			dists_.resize(loc);
+		}
+
 	protected:
 	
 		/**
@@ -309,7 +456,7 @@ namespace trees
 		size_t veclen;
 
 		/**
-			Pointcloud
+			Pointcloud, borrowed from the caller
 		*/
 		utils::Matrix<ElementType> dataset;
 	};
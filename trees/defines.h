@@ -39,7 +39,8 @@ namespace trees
 	*/
 	enum treeIndex
 	{
-		TREE_INDEX_KDTREE = 1
+		TREE_INDEX_KDTREE = 1,
+		TREE_INDEX_LBVH = 2
 	};
 }
 
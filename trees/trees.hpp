@@ -39,32 +39,65 @@
 #include "trees/algorithms/all_indices.h"
 
 #include "trees/utils/params.h"
+#include "trees/utils/result_cache.h"
+#include "trees/utils/search_batcher.h"
 
 #include "tools/utils.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+
 namespace trees
 {
-	template<typename ElementType>
+	template<typename ElementType, typename IndexType = uint32_t>
 	class Index
 	{
 	public:
 
 		/**
-			Constructor
+			Constructor, the pointcloud is borrowed and has to outlive the index
 
 			@param[in] dataset_ Pointcloud
 			@param[in] params_ Input parameters
 		*/
-		Index(const utils::Matrix<ElementType>&  dataset_, const IndexParams& params_) : params(params_)
+		Index(const utils::Matrix<ElementType>&  dataset_, const IndexParams& params_) : params(params_), freed(false)
 		{
 			treeIndex indexType = get_param<treeIndex>(params, "index");
-			nnIndex = createIndexByType<ElementType>(indexType, dataset_, params);
+			nnIndex = createIndexByType<ElementType, IndexType>(indexType, dataset_, params);
+		}
+
+		/**
+			Destructor, the asynchronous search is stopped before the index is deleted
+		*/
+		~Index()
+		{
+			disableAsync();
+			delete nnIndex;
 		}
 
 		/**
-			Frees allocated memory
+			Copy constructor, deleted
+		*/
+		Index(const Index&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		Index& operator=(const Index&) = delete;
+
+		/**
+			Frees allocated memory, the asynchronous search is disabled before, so that its workers
+			do not search the freed tree, and cannot be enabled until the index is built again
 		*/
 		void freeIndex() {
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			batcher.reset();
+			freed = true;
 			nnIndex->freeIndex();
 		}
 
@@ -83,6 +116,8 @@ namespace trees
 		void buildIndex()
 		{
 			nnIndex->buildIndex();
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			freed = false;
 		}
 
 		/** 
@@ -93,6 +128,21 @@ namespace trees
 		void rebuild(const utils::Matrix<ElementType>& dataset_)
 		{
 			nnIndex->rebuild(dataset_);
+			if (cache) {
+				cache->clear();
+			}
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			freed = false;
+		}
+
+		/**
+			Get the number of bytes allocated by the index
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			return nnIndex->usedMemory() + (cache ? cache->usedMemory() : 0);
 		}
 
 		/**
@@ -102,7 +152,138 @@ namespace trees
 		*/
 		bool remove(size_t index_)
 		{
-			return nnIndex->remove(index_);
+			bool removed = nnIndex->remove(index_);
+			if (cache) {
+				cache->clear();
+			}
+			return removed;
+		}
+
+		/**
+			Enables the cache for the results of knnSearch and radiusSearch, the cache is cleared 
+			whenever the index changes
+
+			@param[in] capacity_ Maximal number of bytes of the cached results
+			@param[in] quantization_ Size of the grid cells of the query positions, queries in the 
+				same cell share a result, if zero only identical queries do
+			@param[in] shards_ Number of independently locked parts of the cache
+		*/
+		void enableCache(size_t capacity_, float quantization_ = 0.0f, size_t shards_ = 16)
+		{
+			cache.reset(new ResultCache<ElementType>(capacity_, quantization_, shards_));
+		}
+
+		/**
+			Disables the cache and frees the cached results
+		*/
+		void disableCache()
+		{
+			cache.reset();
+		}
+
+		/**
+			Get the number of searches which have been answered by the cache
+
+			@return Number of hits
+		*/
+		size_t getCacheHits() const
+		{
+			return cache ? cache->getHits() : 0;
+		}
+
+		/**
+			Get the number of searches which have not been answered by the cache
+
+			@return Number of misses
+		*/
+		size_t getCacheMisses() const
+		{
+			return cache ? cache->getMisses() : 0;
+		}
+
+		/**
+			Enables the asynchronous search, concurrent requests of knnSearchAsync are collected 
+			into batches which are searched by long-lived worker threads. The index must not be 
+			changed while requests are pending. Fails if the index has been freed.
+
+			@param[in] max_batch_ Maximal number of requests in a batch
+			@param[in] max_delay_ Maximal time in microseconds a request waits for further requests
+			@param[in] workers_ Number of threads which search batches
+			@param[in] params_ Search parameters of the batches
+		*/
+		void enableAsync(size_t max_batch_ = 64, size_t max_delay_ = 200, size_t workers_ = 1, 
+			const TreeParams& params_ = TreeParams())
+		{
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			if (freed) {
+				exitFailure(__FILE__, __LINE__);
+			}
+			startBatcher(max_batch_, max_delay_, workers_, params_);
+		}
+
+		/**
+			Disables the asynchronous search, pending requests are answered before
+		*/
+		void disableAsync()
+		{
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			batcher.reset();
+		}
+
+		/**
+			Requests the k-nearest neighbors of a point, the request is answered together with
+			other concurrent requests. Enables the asynchronous search with default parameters if 
+			necessary, fails if the index has been freed.
+
+			@param[in] point_ Query point
+			@param[in] knn_ Number of nearest neighbors to return
+			@return Future of the indices and distances of the nearest neighbors
+		*/
+		std::future<KnnResult<ElementType>> knnSearchAsync(const ElementType* point_, size_t knn_)
+		{
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			if (freed) {
+				exitFailure(__FILE__, __LINE__);
+			}
+			if (!batcher) {
+				startBatcher(64, 200, 1, TreeParams());
+			}
+			return batcher->knnSearch(point_, knn_);
+		}
+
+		/**
+			Requests the k-nearest neighbors of a point, the request is answered together with
+			other concurrent requests
+
+			@param[in] point_ Query point as matrix with one row
+			@param[in] knn_ Number of nearest neighbors to return
+			@return Future of the indices and distances of the nearest neighbors
+		*/
+		std::future<KnnResult<ElementType>> knnSearchAsync(const utils::Matrix<ElementType>& point_, size_t knn_)
+		{
+			return knnSearchAsync(point_.getPtr(), knn_);
+		}
+
+		/**
+			Get the number of batches which have been searched asynchronously
+
+			@return Number of batches
+		*/
+		size_t getAsyncBatches()
+		{
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			return batcher ? batcher->getBatches() : 0;
+		}
+
+		/**
+			Get the number of requests which have been answered asynchronously
+
+			@return Number of requests
+		*/
+		size_t getAsyncRequests()
+		{
+			std::lock_guard<std::mutex> lock(batcher_mutex);
+			return batcher ? batcher->getRequests() : 0;
 		}
 
 		/**
@@ -114,82 +295,223 @@ namespace trees
 			@param[in] knn_ Number of nearest neighbors to return
 			@param[in] params_ Search parameters
 		*/
+		template<typename OutIndexType>
 		void knnSearch(const utils::Matrix<ElementType>& queries_,
-			utils::Matrix<size_t>& indices_,
+			utils::Matrix<OutIndexType>& indices_,
 			utils::Matrix<ElementType>& dists_,
 			size_t knn_,
 			const TreeParams& params_) 
 		{
-			nnIndex->knnSearch(queries_, indices_, dists_, knn_, params_);
+			if (!cache) {
+				nnIndex->knnSearch(queries_, indices_, dists_, knn_, params_);
+				return;
+			}
+
+			/**
+				Answer the queries found in the cache and gather the remaining ones
+			*/
+			size_t cols = queries_.getCols();
+			std::vector<size_t> misses;
+			std::vector<ResultCacheKey> keys(queries_.getRows());
+			std::vector<size_t> indices;
+			std::vector<ElementType> dists;
+			for (size_t i = 0; i < queries_.getRows(); i++) {
+				keys[i] = cache->getKey(queries_[i], cols, knn_, false, params_.getEpsilon());
+				if (cache->get(keys[i], indices, dists)) {
+					for (size_t j = 0; j < indices.size(); j++) {
+						indices_[i][j] = (OutIndexType)indices[j];
+						dists_[i][j] = dists[j];
+					}
+				}
+				else {
+					misses.push_back(i);
+				}
+			}
+
+			if (misses.empty()) {
+				return;
+			}
+
+			utils::Matrix<ElementType> queries(misses.size(), cols);
+			for (size_t i = 0; i < misses.size(); i++) {
+				std::memcpy(queries[i], queries_[misses[i]], sizeof(ElementType) * cols);
+			}
+			utils::Matrix<OutIndexType> indices_misses(misses.size(), knn_);
+			utils::Matrix<ElementType> dists_misses(misses.size(), knn_);
+			std::fill(dists_misses.getPtr(), dists_misses.getPtr() + misses.size() * knn_, std::numeric_limits<ElementType>::max());
+			nnIndex->knnSearch(queries, indices_misses, dists_misses, knn_, params_);
+
+			/**
+				Neighbors which have not been found keep the initial distance and are not cached
+			*/
+			for (size_t i = 0; i < misses.size(); i++) {
+				size_t knn = 0;
+				while (knn < knn_ && dists_misses[i][knn] != std::numeric_limits<ElementType>::max()) {
+					knn++;
+				}
+				std::memcpy(indices_[misses[i]], indices_misses[i], sizeof(OutIndexType) * knn);
+				std::memcpy(dists_[misses[i]], dists_misses[i], sizeof(ElementType) * knn);
+				cache->put(keys[misses[i]], indices_misses[i], dists_misses[i], knn);
+			}
 		}
 
 		/**
-			Perform k-nearest neighbor search
+			Perform radius search
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
 			@param[in,out] indices_ The indices of the nearest neighbors found
 			@param[in,out] dists_ Distances to the nearest neighbors found
-			@param[in] knn_ Number of nearest neighbors to return
+			@param[in] radius_ The radius used for search
 			@param[in] params_ Search parameters
 		*/
-		void knnSearch(const utils::Matrix<ElementType>& queries_,
-			utils::Matrix<int>& indices_,
-			utils::Matrix<ElementType>& dists_,
-			size_t knn_,
+		template<typename OutIndexType>
+		void radiusSearch(const utils::Matrix<ElementType>& queries_,
+			std::vector< std::vector<OutIndexType>>& indices_,
+			std::vector<std::vector<ElementType>>& dists_,
+			float radius_,
 			const TreeParams& params_)
 		{
-			nnIndex->knnSearch(queries_, indices_, dists_, knn_, params_);
-		}
+			if (!cache) {
+				nnIndex->radiusSearch(queries_, indices_, dists_, radius_, params_);
+				return;
+			}
+
+			/**
+				Answer the queries found in the cache and gather the remaining ones, the key holds 
+				the bit pattern of the radius
+			*/
+			size_t cols = queries_.getCols();
+			size_t radius = 0;
+			std::memcpy(&radius, &radius_, sizeof(float));
+			std::vector<size_t> misses;
+			std::vector<ResultCacheKey> keys(queries_.getRows());
+			std::vector<size_t> indices;
+			for (size_t i = 0; i < queries_.getRows(); i++) {
+				keys[i] = cache->getKey(queries_[i], cols, radius, true, params_.getEpsilon());
+				if (cache->get(keys[i], indices, dists_[i])) {
+					indices_[i].assign(indices.begin(), indices.end());
+				}
+				else {
+					misses.push_back(i);
+				}
+			}
 
+			if (misses.empty()) {
+				return;
+			}
+
+			utils::Matrix<ElementType> queries(misses.size(), cols);
+			for (size_t i = 0; i < misses.size(); i++) {
+				std::memcpy(queries[i], queries_[misses[i]], sizeof(ElementType) * cols);
+			}
+			std::vector<std::vector<OutIndexType>> indices_misses(misses.size());
+			std::vector<std::vector<ElementType>> dists_misses(misses.size());
+			nnIndex->radiusSearch(queries, indices_misses, dists_misses, radius_, params_);
+
+			for (size_t i = 0; i < misses.size(); i++) {
+				cache->put(keys[misses[i]], indices_misses[i].data(), dists_misses[i].data(), indices_misses[i].size());
+				indices_[misses[i]].swap(indices_misses[i]);
+				dists_[misses[i]].swap(dists_misses[i]);
+			}
+		}
 
 		/**
-			Perform radius search
+			Perform k-nearest neighbor search with a different number of neighbors for every query, the
+			neighbors of query i are found between offsets_[i] and offsets_[i+1]
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
+			@param[in] knn_ Number of nearest neighbors to return for every query
 			@param[in,out] indices_ The indices of the nearest neighbors found
 			@param[in,out] dists_ Distances to the nearest neighbors found
-			@param[in] radius_ The radius used for search
+			@param[in,out] offsets_ Offsets of the neighbors of every query
 			@param[in] params_ Search parameters
 		*/
-		void radiusSearch(const utils::Matrix<ElementType>& queries_,
-			std::vector< std::vector<size_t>>& indices_,
-			std::vector<std::vector<ElementType>>& dists_,
-			float radius_,
+		template<typename OutIndexType>
+		void knnSearch(const utils::Matrix<ElementType>& queries_,
+			const std::vector<size_t>& knn_,
+			std::vector<OutIndexType>& indices_,
+			std::vector<ElementType>& dists_,
+			std::vector<size_t>& offsets_,
 			const TreeParams& params_)
 		{
-			nnIndex->radiusSearch(queries_, indices_, dists_, radius_, params_);
+			nnIndex->knnSearch(queries_, knn_, indices_, dists_, offsets_, params_);
 		}
 
 		/**
-			Perform radius search
+			Perform radius search with a different radius for every query, the neighbors of query i 
+			are found between offsets_[i] and offsets_[i+1]
 
 			@param[in] queries_ The query points for which to find the nearest neighbors
+			@param[in] radius_ The radius used for search for every query
 			@param[in,out] indices_ The indices of the nearest neighbors found
 			@param[in,out] dists_ Distances to the nearest neighbors found
-			@param[in] radius_ The radius used for search
+			@param[in,out] offsets_ Offsets of the neighbors of every query
 			@param[in] params_ Search parameters
 		*/
+		template<typename OutIndexType>
 		void radiusSearch(const utils::Matrix<ElementType>& queries_,
-			std::vector< std::vector<int>>& indices_,
-			std::vector<std::vector<ElementType>>& dists_,
-			float radius_,
+			const std::vector<float>& radius_,
+			std::vector<OutIndexType>& indices_,
+			std::vector<ElementType>& dists_,
+			std::vector<size_t>& offsets_,
 			const TreeParams& params_)
 		{
-			nnIndex->radiusSearch(queries_, indices_, dists_, radius_, params_);
+			nnIndex->radiusSearch(queries_, radius_, indices_, dists_, offsets_, params_);
 		}
 
 	private:
 
+		/**
+			Replaces the batcher of the asynchronous search, has to be called with the mutex of the
+			batcher locked
+
+			@param[in] max_batch_ Maximal number of requests in a batch
+			@param[in] max_delay_ Maximal time in microseconds a request waits for further requests
+			@param[in] workers_ Number of threads which search batches
+			@param[in] params_ Search parameters of the batches
+		*/
+		void startBatcher(size_t max_batch_, size_t max_delay_, size_t workers_, const TreeParams& params_)
+		{
+			NNIndex<ElementType, IndexType>* index = nnIndex;
+			TreeParams params = params_;
+			batcher.reset(new SearchBatcher<ElementType>(
+				[index, params](const utils::Matrix<ElementType>& queries_, const std::vector<size_t>& knn_,
+					std::vector<size_t>& indices_, std::vector<ElementType>& dists_, std::vector<size_t>& offsets_) {
+					index->knnSearch(queries_, knn_, indices_, dists_, offsets_, params);
+				},
+				nnIndex->getVeclen(), max_batch_, std::chrono::microseconds(max_delay_), workers_));
+		}
+
 		/**
 			Index
 		*/
-		NNIndex<ElementType>* nnIndex;
+		NNIndex<ElementType, IndexType>* nnIndex;
 
 		/**
 			Input parameters
 		*/
 		IndexParams params;
 
+		/**
+			Cache for the results of the searches, disabled if empty
+		*/
+		std::unique_ptr<ResultCache<ElementType>> cache;
+
+		/**
+			Batcher of the asynchronous searches, disabled if empty
+		*/
+		std::unique_ptr<SearchBatcher<ElementType>> batcher;
+
+		/**
+			Mutex of the batcher
+		*/
+		std::mutex batcher_mutex;
+
+		/**
+			True if the index has been freed and not built again, guarded by the mutex of the batcher
+		*/
+		bool freed;
+
 	};
 }
 
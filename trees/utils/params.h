@@ -38,6 +38,7 @@
 #include <assert.h>
 
 #include "trees/defines.h"
+#include "trees/utils/search_stats.h"
 
 #include "tools/utils.h"
 
@@ -55,7 +56,9 @@ namespace trees
 		*/
 		TreeParams() : 
 			cores_(1),
-			eps_(std::numeric_limits<float>::epsilon())
+			eps_(std::numeric_limits<float>::epsilon()),
+			grain_(64),
+			stats_(nullptr)
 		{
 		}
 
@@ -91,6 +94,27 @@ namespace trees
 			eps_ = eps;
 		}
 		
+		/**
+			Set the maximal number of queries which are processed by one task
+			
+			@param[in] grain Number of queries
+		*/
+		void setGrain(size_t grain)
+		{
+			grain_ = grain;
+		}
+
+		/**
+			Set the container which collects the counters of the search, the counters are only
+			gathered when TREES_SEARCH_STATS is defined
+
+			@param[in] stats Container for the counters
+		*/
+		void setSearchStats(SearchStats* stats)
+		{
+			stats_ = stats;
+		}
+
 		/** 
 			Get number of cores
 			
@@ -110,6 +134,26 @@ namespace trees
 		{
 			return eps_;
 		}	
+
+		/**
+			Get the maximal number of queries which are processed by one task
+			
+			@return Number of queries
+		*/
+		size_t getGrain() const
+		{
+			return grain_;
+		}
+
+		/**
+			Get the container which collects the counters of the search
+
+			@return Container for the counters
+		*/
+		SearchStats* getSearchStats() const
+		{
+			return stats_;
+		}
 		
 		/**
 			Number of cores
@@ -120,6 +164,16 @@ namespace trees
 			Machine epsilon
 		*/
 		float eps_;
+
+		/**
+			Maximal number of queries which are processed by one task
+		*/
+		size_t grain_;
+
+		/**
+			Container for the counters of the search
+		*/
+		SearchStats* stats_;
 	};
 
 	/**
@@ -0,0 +1,359 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef TREES_RESULT_CACHE_H_
+#define TREES_RESULT_CACHE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace trees
+{
+	/**
+		Key of a cached search, the query position is quantized to a grid so that queries which
+		differ only slightly share the same entry
+	*/
+	struct ResultCacheKey
+	{
+		/**
+			Quantized query position
+		*/
+		std::vector<long long> position;
+
+		/**
+			Number of neighbors or bit pattern of the radius
+		*/
+		size_t parameter;
+
+		/**
+			Bit pattern of the epsilon of the search parameters
+		*/
+		uint32_t eps;
+
+		/**
+			True if the entry stems from a radius search
+		*/
+		bool radius;
+
+		bool operator==(const ResultCacheKey& key_) const
+		{
+			return parameter == key_.parameter && eps == key_.eps && radius == key_.radius && position == key_.position;
+		}
+	};
+
+	/**
+		Hash function of the keys
+	*/
+	struct ResultCacheKeyHash
+	{
+		size_t operator()(const ResultCacheKey& key_) const
+		{
+			size_t hash = std::hash<size_t>()(key_.parameter) ^ (key_.radius ? 0x9e3779b97f4a7c15ULL : 0);
+			hash ^= std::hash<uint32_t>()(key_.eps) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			for (size_t i = 0; i < key_.position.size(); i++) {
+				hash ^= std::hash<long long>()(key_.position[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			return hash;
+		}
+	};
+
+	/**
+		Least recently used cache for the results of searches, bounded by the number of bytes of 
+		the entries. The entries are distributed over several shards, each one guarded by its own 
+		mutex, so concurrent lookups only contend if they hit the same shard
+	*/
+	template<typename ElementType>
+	class ResultCache
+	{
+	public:
+
+		/**
+			Entry of the cache
+		*/
+		struct Entry
+		{
+			ResultCacheKey key;
+			std::vector<size_t> indices;
+			std::vector<ElementType> dists;
+		};
+
+		/**
+			Constructor
+
+			@param[in] capacity_ Maximal number of bytes of the cached results
+			@param[in] quantization_ Size of the grid cells of the query positions, if zero the exact
+				query position is used
+			@param[in] shards_ Number of shards
+		*/
+		ResultCache(size_t capacity_, float quantization_ = 0.0f, size_t shards_ = 16) :
+			quantization(quantization_),
+			shards(shards_ ? shards_ : 1),
+			hits(0),
+			misses(0),
+			bytes(0)
+		{
+			shard_capacity = std::max<size_t>(1, (capacity_ + shards.size() - 1) / shards.size());
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		ResultCache(const ResultCache&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		ResultCache& operator=(const ResultCache&) = delete;
+
+		/**
+			Creates the key of a query
+
+			@param[in] query_ Query point
+			@param[in] veclen_ Dimension of the query
+			@param[in] parameter_ Number of neighbors or bit pattern of the radius
+			@param[in] radius_ True if the key belongs to a radius search
+			@param[in] eps_ Epsilon of the search parameters, approximate searches with different 
+				epsilons do not share results
+			@return Key
+		*/
+		ResultCacheKey getKey(const ElementType* query_, size_t veclen_, size_t parameter_, bool radius_, float eps_) const
+		{
+			ResultCacheKey key;
+			key.parameter = parameter_;
+			key.radius = radius_;
+			std::memcpy(&key.eps, &eps_, sizeof(float));
+			key.position.resize(veclen_);
+			for (size_t i = 0; i < veclen_; i++) {
+				if (quantization > 0) {
+					key.position[i] = (long long)std::floor(query_[i] / quantization);
+				}
+				else {
+					double value = (double)query_[i];
+					std::memcpy(&key.position[i], &value, sizeof(double));
+				}
+			}
+			return key;
+		}
+
+		/**
+			Looks up a result and marks it as recently used
+
+			@param[in] key_ Key of the query
+			@param[in,out] indices_ Indices of the cached neighbors
+			@param[in,out] dists_ Distances of the cached neighbors
+			@return True if the result has been found
+		*/
+		bool get(const ResultCacheKey& key_, std::vector<size_t>& indices_, std::vector<ElementType>& dists_)
+		{
+			Shard& shard = getShard(key_);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+
+			auto it = shard.map.find(key_);
+			if (it == shard.map.end()) {
+				misses++;
+				return false;
+			}
+
+			shard.list.splice(shard.list.begin(), shard.list, it->second);
+			indices_ = it->second->indices;
+			dists_ = it->second->dists;
+			hits++;
+			return true;
+		}
+
+		/**
+			Inserts a result, the least recently used entries are dropped until the shard fits into 
+			its share of the capacity
+
+			@param[in] key_ Key of the query
+			@param[in] indices_ Indices of the neighbors
+			@param[in] dists_ Distances of the neighbors
+			@param[in] number_ Number of neighbors
+		*/
+		template<typename OutIndexType>
+		void put(const ResultCacheKey& key_, const OutIndexType* indices_, const ElementType* dists_, size_t number_)
+		{
+			Shard& shard = getShard(key_);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+
+			auto it = shard.map.find(key_);
+			if (it != shard.map.end()) {
+				shard.bytes -= getBytes(*it->second);
+				shard.list.erase(it->second);
+				shard.map.erase(it);
+			}
+
+			shard.list.push_front(Entry());
+			Entry& entry = shard.list.front();
+			entry.key = key_;
+			entry.indices.assign(indices_, indices_ + number_);
+			entry.dists.assign(dists_, dists_ + number_);
+			shard.map[key_] = shard.list.begin();
+			shard.bytes += getBytes(entry);
+			bytes += getBytes(entry);
+
+			while (!shard.list.empty() && shard.bytes > shard_capacity) {
+				shard.bytes -= getBytes(shard.list.back());
+				bytes -= getBytes(shard.list.back());
+				shard.map.erase(shard.list.back().key);
+				shard.list.pop_back();
+			}
+		}
+
+		/**
+			Removes all entries, has to be called whenever the underlying index changes
+		*/
+		void clear()
+		{
+			for (size_t i = 0; i < shards.size(); i++) {
+				std::lock_guard<std::mutex> lock(shards[i].mutex);
+				bytes -= shards[i].bytes;
+				shards[i].bytes = 0;
+				shards[i].map.clear();
+				shards[i].list.clear();
+			}
+		}
+
+		/**
+			Get the number of bytes of the cached results
+
+			@return Number of bytes
+		*/
+		size_t usedMemory() const
+		{
+			return bytes;
+		}
+
+		/**
+			Get the number of lookups which have been answered by the cache
+
+			@return Number of hits
+		*/
+		size_t getHits() const
+		{
+			return hits;
+		}
+
+		/**
+			Get the number of lookups which have not been answered by the cache
+
+			@return Number of misses
+		*/
+		size_t getMisses() const
+		{
+			return misses;
+		}
+
+	private:
+
+		/**
+			Part of the cache with its own lock
+		*/
+		struct Shard
+		{
+			std::mutex mutex;
+			std::list<Entry> list;
+			std::unordered_map<ResultCacheKey, typename std::list<Entry>::iterator, ResultCacheKeyHash> map;
+			size_t bytes = 0;
+		};
+
+		/**
+			Get the number of bytes of an entry including its nodes in the list and in the map
+
+			@param[in] entry_ Entry
+			@return Number of bytes
+		*/
+		static size_t getBytes(const Entry& entry_)
+		{
+			const size_t nodes = sizeof(Entry) + 2 * sizeof(void*) + sizeof(ResultCacheKey) + 
+				sizeof(typename std::list<Entry>::iterator) + 2 * sizeof(void*);
+			return nodes + 2 * entry_.key.position.size() * sizeof(long long) + 
+				entry_.indices.size() * sizeof(size_t) + entry_.dists.size() * sizeof(ElementType);
+		}
+
+		/**
+			Get the shard which holds a certain key
+
+			@param[in] key_ Key of the query
+			@return Shard
+		*/
+		Shard& getShard(const ResultCacheKey& key_)
+		{
+			/**
+				Mix the bits, the low bits of the hash of exact positions are often equal
+			*/
+			uint64_t hash = ResultCacheKeyHash()(key_);
+			hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+			return shards[(hash ^ (hash >> 31)) % shards.size()];
+		}
+
+		/**
+			Size of the grid cells of the query positions
+		*/
+		float quantization;
+
+		/**
+			Shards
+		*/
+		std::vector<Shard> shards;
+
+		/**
+			Maximal number of bytes per shard
+		*/
+		size_t shard_capacity;
+
+		/**
+			Number of hits
+		*/
+		std::atomic<size_t> hits;
+
+		/**
+			Number of misses
+		*/
+		std::atomic<size_t> misses;
+
+		/**
+			Number of bytes of all shards
+		*/
+		std::atomic<size_t> bytes;
+	};
+}
+
+#endif /* TREES_RESULT_CACHE_H_ */
@@ -70,10 +70,10 @@ struct BranchStruct
 };
 
 
-template <typename DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
 struct DistanceIndex
 {
-    DistanceIndex(DistanceType dist, size_t index) :
+    DistanceIndex(DistanceType dist, IndexType index) :
         dist_(dist), index_(index)
     {
     }
@@ -82,11 +82,11 @@ struct DistanceIndex
         return (dist_ < dist_index.dist_) || ((dist_ == dist_index.dist_) && index_ < dist_index.index_);
     }
     DistanceType dist_;
-    size_t index_;
+    IndexType index_;
 };
 
 
-template <typename DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
 class ResultSet
 {
 public:
@@ -97,7 +97,7 @@ public:
 
     virtual bool full() const = 0;
 
-    virtual void addPoint(DistanceType dist, size_t index) = 0;
+    virtual void addPoint(DistanceType dist, IndexType index) = 0;
 
     virtual DistanceType worstDist() const = 0;
 
@@ -109,17 +109,17 @@ public:
  * Is used in those cases where the nearest neighbour algorithm used does not
  * attempt to insert the same element multiple times.
  */
-template <typename DistanceType>
-class KNNSimpleResultSet : public ResultSet<DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
+class KNNSimpleResultSet : public ResultSet<DistanceType, IndexType>
 {
 public:
-	typedef DistanceIndex<DistanceType> DistIndex;
+	typedef DistanceIndex<DistanceType, IndexType> DistIndex;
 
-	KNNSimpleResultSet(size_t capacity_) : ResultSet(capacity_)
+	KNNSimpleResultSet(size_t capacity_) : ResultSet<DistanceType, IndexType>(capacity_)
     
     {
 		// reserving capacity to prevent memory re-allocations
-		dist_index_.resize(capacity_, DistIndex(std::numeric_limits<DistanceType>::max(),-1));
+		dist_index_.resize(capacity_, DistIndex(std::numeric_limits<DistanceType>::max(),(IndexType)-1));
     	clear();
     }
 
@@ -160,7 +160,7 @@ public:
      * @param dist distance to point
      * @param index index of point
      */
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
     	if (dist>=worst_distance_) return;
 
@@ -190,11 +190,12 @@ public:
      * @param num_elements Number of elements to copy
      * @param sorted Indicates if results should be sorted
      */
-    void copy(size_t* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
+    template<typename OutIndexType>
+    void copy(OutIndexType* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
 	{
 		size_t n = std::min(count_, num_elements);
 		for (size_t i = 0; i<n; ++i) {
-			*indices++ = dist_index_[i].index_;
+			*indices++ = (OutIndexType)dist_index_[i].index_;
 			*dists++ = dist_index_[i].dist_;
 		}
 	}
@@ -213,17 +214,17 @@ private:
 /**
  * K-Nearest neighbour result set. Ensures that the elements inserted are unique
  */
-template <typename DistanceType>
-class KNNResultSet : public ResultSet<DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
+class KNNResultSet : public ResultSet<DistanceType, IndexType>
 {
 public:
-	typedef DistanceIndex<DistanceType> DistIndex;
+	typedef DistanceIndex<DistanceType, IndexType> DistIndex;
 
-    KNNResultSet(size_t capacity_) : ResultSet(capacity_)
+    KNNResultSet(size_t capacity_) : ResultSet<DistanceType, IndexType>(capacity_)
 
     {
 		// reserving capacity to prevent memory re-allocations
-		dist_index_.resize(capacity_, DistIndex(std::numeric_limits<DistanceType>::max(),-1));
+		dist_index_.resize(capacity_, DistIndex(std::numeric_limits<DistanceType>::max(),(IndexType)-1));
     	clear();
     }
 
@@ -253,7 +254,7 @@ public:
     }
 
 
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
         if (dist >= worst_distance_) return;
         size_t i;
@@ -289,11 +290,12 @@ public:
      * @param num_elements Number of elements to copy
      * @param sorted Indicates if results should be sorted
      */
-    void copy(size_t* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
+    template<typename OutIndexType>
+    void copy(OutIndexType* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
     {
     	size_t n = std::min(count_, num_elements);
     	for (size_t i=0; i<n; ++i) {
-    		*indices++ = dist_index_[i].index_;
+    		*indices++ = (OutIndexType)dist_index_[i].index_;
     		*dists++ = dist_index_[i].dist_;
     	}
     }
@@ -312,13 +314,13 @@ private:
 
 
 
-template <typename DistanceType>
-class KNNResultSet2 : public ResultSet<DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
+class KNNResultSet2 : public ResultSet<DistanceType, IndexType>
 {
 public:
-	typedef DistanceIndex<DistanceType> DistIndex;
+	typedef DistanceIndex<DistanceType, IndexType> DistIndex;
 
-	KNNResultSet2(size_t capacity_) : ResultSet(capacity_)
+	KNNResultSet2(size_t capacity_) : ResultSet<DistanceType, IndexType>(capacity_)
 
     {
 		// reserving capacity to prevent memory re-allocations
@@ -364,7 +366,7 @@ public:
      * @param index index of point
      * Pre-conditions: capacity_>0
      */
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
     	if (dist>=worst_dist_) return;
 
@@ -397,7 +399,8 @@ public:
      * @param num_elements Number of elements to copy
      * @param sorted Indicates if results should be sorted
      */
-    void copy(size_t* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
+    template<typename OutIndexType>
+    void copy(OutIndexType* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
     {
     	if (sorted) {
     		// std::sort_heap(dist_index_.begin(), dist_index_.end());
@@ -412,7 +415,7 @@ public:
 
     	size_t n = std::min(dist_index_.size(), num_elements);
     	for (size_t i=0; i<n; ++i) {
-    		*indices++ = dist_index_[i].index_;
+    		*indices++ = (OutIndexType)dist_index_[i].index_;
     		*dists++ = dist_index_[i].dist_;
     	}
     }
@@ -433,14 +436,14 @@ private:
  * Unbounded radius result set. It will hold as many elements as
  * are added to it.
  */
-template <typename DistanceType>
-class RadiusResultSet : public ResultSet<DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
+class RadiusResultSet : public ResultSet<DistanceType, IndexType>
 {
 public:
-	typedef DistanceIndex<DistanceType> DistIndex;
+	typedef DistanceIndex<DistanceType, IndexType> DistIndex;
 
 	RadiusResultSet(DistanceType radius_) :
-        radius_(radius_), ResultSet(0)
+        ResultSet<DistanceType, IndexType>(0), radius_(radius_)
     {
 		// reserving some memory to limit number of re-allocations
 		dist_index_.reserve(1024);
@@ -483,7 +486,7 @@ public:
      * @param index index of point
      * Pre-conditions: capacity_>0
      */
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
     	if (dist<radius_) {
 			// add new element
@@ -498,7 +501,8 @@ public:
      * @param num_elements Number of elements to copy
      * @param sorted Indicates if results should be sorted
      */
-    void copy(size_t* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
+    template<typename OutIndexType>
+    void copy(OutIndexType* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
     {
     	if (sorted) {
     		// std::sort_heap(dist_index_.begin(), dist_index_.end());
@@ -513,7 +517,7 @@ public:
 
     	size_t n = std::min(dist_index_.size(), num_elements);
     	for (size_t i=0; i<n; ++i) {
-    		*indices++ = dist_index_[i].index_;
+    		*indices++ = (OutIndexType)dist_index_[i].index_;
     		*dists++ = dist_index_[i].dist_;
     	}
     }
@@ -534,14 +538,14 @@ private:
  * Bounded radius result set. It limits the number of elements
  * it can hold to a preset capacity.
  */
-template <typename DistanceType>
-class KNNRadiusResultSet : public ResultSet<DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
+class KNNRadiusResultSet : public ResultSet<DistanceType, IndexType>
 {
 public:
-	typedef DistanceIndex<DistanceType> DistIndex;
+	typedef DistanceIndex<DistanceType, IndexType> DistIndex;
 
 	KNNRadiusResultSet(DistanceType radius_, size_t capacity_) :
-		radius_(radius_), ResultSet(capacity_)
+		ResultSet<DistanceType, IndexType>(capacity_), radius_(radius_)
     {
 		// reserving capacity to prevent memory re-allocations
 		dist_index_.reserve(capacity_);
@@ -586,7 +590,7 @@ public:
      * @param index index of point
      * Pre-conditions: capacity_>0
      */
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
     	if (dist>=worst_dist_) return;
 
@@ -620,7 +624,8 @@ public:
      * @param num_elements Number of elements to copy
      * @param sorted Indicates if results should be sorted
      */
-    void copy(size_t* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
+    template<typename OutIndexType>
+    void copy(OutIndexType* indices, DistanceType* dists, size_t num_elements, bool sorted = true)
     {
     	if (sorted) {
     		// std::sort_heap(dist_index_.begin(), dist_index_.end());
@@ -635,7 +640,7 @@ public:
 
     	size_t n = std::min(dist_index_.size(), num_elements);
     	for (size_t i=0; i<n; ++i) {
-    		*indices++ = dist_index_[i].index_;
+    		*indices++ = (OutIndexType)dist_index_[i].index_;
     		*dists++ = dist_index_[i].dist_;
     	}
     }
@@ -658,15 +663,15 @@ private:
  * This is a result set that only counts the neighbors within a radius.
  */
 
-template <typename DistanceType>
-class CountRadiusResultSet : public ResultSet<DistanceType>
+template <typename DistanceType, typename IndexType = size_t>
+class CountRadiusResultSet : public ResultSet<DistanceType, IndexType>
 {
     DistanceType radius;
     size_t count;
 
 public:
 	CountRadiusResultSet(DistanceType radius_) :
-		radius(radius_), ResultSet(0)
+		ResultSet<DistanceType, IndexType>(0), radius(radius_)
     {
         clear();
     }
@@ -690,7 +695,7 @@ public:
         return true;
     }
 
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
         if (dist<radius) {
             count++;
@@ -710,13 +715,13 @@ public:
 
 /** Class that holds the k NN neighbors
  */
-template<typename DistanceType>
-class UniqueResultSet : public ResultSet<DistanceType>
+template<typename DistanceType, typename IndexType = size_t>
+class UniqueResultSet : public ResultSet<DistanceType, IndexType>
 {
 public:
     struct DistIndex
     {
-        DistIndex(DistanceType dist, unsigned int index) :
+        DistIndex(DistanceType dist, IndexType index) :
             dist_(dist), index_(index)
         {
         }
@@ -725,11 +730,11 @@ public:
             return (dist_ < dist_index.dist_) || ((dist_ == dist_index.dist_) && index_ < dist_index.index_);
         }
         DistanceType dist_;
-        unsigned int index_;
+        IndexType index_;
     };
 
     /** Default cosntructor */
-    UniqueResultSet() : ResultSet(0),
+    UniqueResultSet() : ResultSet<DistanceType, IndexType>(0),
         worst_distance_(std::numeric_limits<DistanceType>::max())
     {
     }
@@ -747,14 +752,15 @@ public:
      * @param dist pointer to a C array of distances
      * @param n_neighbors the number of neighbors to copy
      */
-    void copy(size_t* indices, DistanceType* dist, int n_neighbors, bool sorted = true)
+    template<typename OutIndexType>
+    void copy(OutIndexType* indices, DistanceType* dist, int n_neighbors, bool sorted = true)
     {
     	if (n_neighbors<0) n_neighbors = dist_indices_.size();
     	int i = 0;
     	typedef typename std::set<DistIndex>::const_iterator Iterator;
     	for (Iterator dist_index = dist_indices_.begin(), dist_index_end =
     			dist_indices_.end(); (dist_index != dist_index_end) && (i < n_neighbors); ++dist_index, ++indices, ++dist, ++i) {
-    		*indices = dist_index->index_;
+    		*indices = (OutIndexType)dist_index->index_;
     		*dist = dist_index->dist_;
     	}
     }
@@ -791,8 +797,8 @@ protected:
 /** Class that holds the k NN neighbors
  * Faster than KNNResultSet as it uses a binary heap and does not maintain two arrays
  */
-template<typename DistanceType>
-class KNNUniqueResultSet : public UniqueResultSet<DistanceType>
+template<typename DistanceType, typename IndexType = size_t>
+class KNNUniqueResultSet : public UniqueResultSet<DistanceType, IndexType>
 {
 public:
     /** Constructor
@@ -808,7 +814,7 @@ public:
      * @param dist distance for that neighbor
      * @param index index of that neighbor
      */
-    inline void addPoint(DistanceType dist, size_t index)
+    inline void addPoint(DistanceType dist, IndexType index)
     {
         // Don't do anything if we are worse than the worst
         if (dist >= worst_distance_) return;
@@ -836,10 +842,10 @@ public:
     }
 
 protected:
-    typedef typename UniqueResultSet<DistanceType>::DistIndex DistIndex;
-    using UniqueResultSet<DistanceType>::is_full_;
-    using UniqueResultSet<DistanceType>::worst_distance_;
-    using UniqueResultSet<DistanceType>::dist_indices_;
+    typedef typename UniqueResultSet<DistanceType, IndexType>::DistIndex DistIndex;
+    using UniqueResultSet<DistanceType, IndexType>::is_full_;
+    using UniqueResultSet<DistanceType, IndexType>::worst_distance_;
+    using UniqueResultSet<DistanceType, IndexType>::dist_indices_;
 
     /** The number of neighbors to keep */
 	size_t capacity_;
@@ -850,15 +856,15 @@ protected:
 /** Class that holds the radius nearest neighbors
  * It is more accurate than RadiusResult as it is not limited in the number of neighbors
  */
-template<typename DistanceType>
-class RadiusUniqueResultSet : public UniqueResultSet<DistanceType>
+template<typename DistanceType, typename IndexType = size_t>
+class RadiusUniqueResultSet : public UniqueResultSet<DistanceType, IndexType>
 {
 public:
     /** Constructor
      * @param capacity the number of neighbors to store at max
      */
     RadiusUniqueResultSet(DistanceType radius) :
-        radius_(radius), ResultSet(0)
+        radius_(radius)
     {
         is_full_ = true;
     }
@@ -867,7 +873,7 @@ public:
      * @param dist distance for that neighbor
      * @param index index of that neighbor
      */
-    void addPoint(DistanceType dist, size_t index)
+    void addPoint(DistanceType dist, IndexType index)
     {
         if (dist < radius_) dist_indices_.insert(DistIndex(dist, index));
     }
@@ -897,9 +903,9 @@ public:
         return radius_;
     }
 private:
-    typedef typename UniqueResultSet<DistanceType>::DistIndex DistIndex;
-    using UniqueResultSet<DistanceType>::dist_indices_;
-    using UniqueResultSet<DistanceType>::is_full_;
+    typedef typename UniqueResultSet<DistanceType, IndexType>::DistIndex DistIndex;
+    using UniqueResultSet<DistanceType, IndexType>::dist_indices_;
+    using UniqueResultSet<DistanceType, IndexType>::is_full_;
 
     /** The furthest distance a neighbor can be */
     DistanceType radius_;
@@ -909,14 +915,14 @@ private:
 
 /** Class that holds the k NN neighbors within a radius distance
  */
-template<typename DistanceType>
-class KNNRadiusUniqueResultSet : public KNNUniqueResultSet<DistanceType>
+template<typename DistanceType, typename IndexType = size_t>
+class KNNRadiusUniqueResultSet : public KNNUniqueResultSet<DistanceType, IndexType>
 {
 public:
     /** Constructor
      * @param capacity the number of neighbors to store at max
      */
-    KNNRadiusUniqueResultSet(DistanceType radius, size_t capacity) : KNNUniqueResultSet<DistanceType>(capacity)
+    KNNRadiusUniqueResultSet(DistanceType radius, size_t capacity) : KNNUniqueResultSet<DistanceType, IndexType>(capacity)
     {
         this->radius_ = radius;
         this->clear();
@@ -931,9 +937,9 @@ public:
         is_full_ = true;
     }
 private:
-    using KNNUniqueResultSet<DistanceType>::dist_indices_;
-    using KNNUniqueResultSet<DistanceType>::is_full_;
-    using KNNUniqueResultSet<DistanceType>::worst_distance_;
+    using KNNUniqueResultSet<DistanceType, IndexType>::dist_indices_;
+    using KNNUniqueResultSet<DistanceType, IndexType>::is_full_;
+    using KNNUniqueResultSet<DistanceType, IndexType>::worst_distance_;
 
     /** The maximum distance of a neighbor */
     DistanceType radius_;
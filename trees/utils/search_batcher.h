@@ -0,0 +1,341 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+
+#ifndef TREES_SEARCH_BATCHER_H_
+#define TREES_SEARCH_BATCHER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tools/utils/matrix.h"
+
+namespace trees
+{
+	/**
+		Result of an asynchronous k-nearest neighbor search
+	*/
+	template<typename ElementType>
+	struct KnnResult
+	{
+		/**
+			Indices of the nearest neighbors
+		*/
+		std::vector<size_t> indices;
+
+		/**
+			Distances to the nearest neighbors
+		*/
+		std::vector<ElementType> dists;
+	};
+
+	/**
+		Collects single k-nearest neighbor searches which are requested concurrently by several 
+		threads into batches and answers every batch with one search. A batch is searched as soon 
+		as it is full or its oldest request has waited for the maximal delay, so the latency of a
+		request is bounded by the delay plus the duration of one batch. The batches are searched by 
+		long-lived worker threads.
+	*/
+	template<typename ElementType>
+	class SearchBatcher
+	{
+	public:
+
+		/**
+			Function which searches the neighbors of a batch, see NNIndex::knnSearch with offsets
+		*/
+		typedef std::function<void(const utils::Matrix<ElementType>&, const std::vector<size_t>&,
+			std::vector<size_t>&, std::vector<ElementType>&, std::vector<size_t>&)> SearchFunction;
+
+		/**
+			Constructor
+
+			@param[in] search_ Function which searches the neighbors of a batch
+			@param[in] veclen_ Dimension of the points
+			@param[in] max_batch_ Maximal number of requests in a batch
+			@param[in] max_delay_ Maximal time a request waits for further requests
+			@param[in] workers_ Number of threads which search batches
+		*/
+		SearchBatcher(const SearchFunction& search_, size_t veclen_, size_t max_batch_, 
+			std::chrono::microseconds max_delay_, size_t workers_) :
+			search(search_), veclen(veclen_), max_batch(std::max<size_t>(1, max_batch_)), 
+			max_delay(max_delay_), stopped(false), batches(0), requests(0)
+		{
+			for (size_t i = 0; i < std::max<size_t>(1, workers_); i++) {
+				workers.push_back(std::thread(&SearchBatcher::work, this));
+			}
+		}
+
+		/**
+			Destructor, the pending requests are answered before the threads terminate
+		*/
+		~SearchBatcher()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+			}
+			changed.notify_all();
+
+			for (size_t i = 0; i < workers.size(); i++) {
+				workers[i].join();
+			}
+		}
+
+		/**
+			Copy constructor, deleted
+		*/
+		SearchBatcher(const SearchBatcher&) = delete;
+
+		/**
+			Copy assignment, deleted
+		*/
+		SearchBatcher& operator=(const SearchBatcher&) = delete;
+
+		/**
+			Requests the k-nearest neighbors of a point
+
+			@param[in] point_ Query point with veclen elements
+			@param[in] knn_ Number of nearest neighbors to return
+			@return Future of the result
+		*/
+		std::future<KnnResult<ElementType>> knnSearch(const ElementType* point_, size_t knn_)
+		{
+			Request request;
+			request.point.assign(point_, point_ + veclen);
+			request.knn = knn_;
+			request.arrival = std::chrono::steady_clock::now();
+			std::future<KnnResult<ElementType>> future = request.promise.get_future();
+
+			bool full;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				pending.push_back(std::move(request));
+				full = pending.size() >= max_batch;
+			}
+
+			/**
+				The workers are woken when a batch is complete or the first request of a batch 
+				arrives, which starts the time window
+			*/
+			if (full) {
+				changed.notify_all();
+			}
+			else {
+				changed.notify_one();
+			}
+
+			return future;
+		}
+
+		/**
+			Get the number of searched batches
+
+			@return Number of batches
+		*/
+		size_t getBatches() const
+		{
+			return batches;
+		}
+
+		/**
+			Get the number of answered requests
+
+			@return Number of requests
+		*/
+		size_t getRequests() const
+		{
+			return requests;
+		}
+
+	private:
+
+		/**
+			Single request
+		*/
+		struct Request
+		{
+			std::vector<ElementType> point;
+			size_t knn;
+			std::chrono::steady_clock::time_point arrival;
+			std::promise<KnnResult<ElementType>> promise;
+		};
+
+		/**
+			Takes batches and answers them until the batcher is destroyed
+		*/
+		void work()
+		{
+			std::vector<Request> batch;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [this]() { return !pending.empty() || stopped; });
+					if (pending.empty()) {
+						return;
+					}
+
+					/**
+						Wait until the batch is full or the window of the oldest request has passed
+					*/
+					while (!stopped && pending.size() < max_batch && !pending.empty()) {
+						std::chrono::steady_clock::time_point deadline = pending.front().arrival + max_delay;
+						if (changed.wait_until(lock, deadline) == std::cv_status::timeout) {
+							break;
+						}
+					}
+					if (pending.empty()) {
+						continue;
+					}
+
+					size_t number = std::min(max_batch, pending.size());
+					batch.clear();
+					for (size_t i = 0; i < number; i++) {
+						batch.push_back(std::move(pending.front()));
+						pending.pop_front();
+					}
+				}
+
+				/**
+					Further requests may wait for another worker
+				*/
+				changed.notify_one();
+
+				answer(batch);
+			}
+		}
+
+		/**
+			Searches the neighbors of a batch and fulfils the promises
+
+			@param[in,out] batch_ Requests
+		*/
+		void answer(std::vector<Request>& batch_)
+		{
+			utils::Matrix<ElementType> queries(batch_.size(), veclen);
+			std::vector<size_t> knn(batch_.size());
+			for (size_t i = 0; i < batch_.size(); i++) {
+				std::memcpy(queries[i], batch_[i].point.data(), sizeof(ElementType) * veclen);
+				knn[i] = batch_[i].knn;
+			}
+
+			std::vector<size_t> indices;
+			std::vector<ElementType> dists;
+			std::vector<size_t> offsets;
+			try {
+				search(queries, knn, indices, dists, offsets);
+			}
+			catch (...) {
+				for (size_t i = 0; i < batch_.size(); i++) {
+					batch_[i].promise.set_exception(std::current_exception());
+				}
+				return;
+			}
+
+			for (size_t i = 0; i < batch_.size(); i++) {
+				KnnResult<ElementType> result;
+				result.indices.assign(indices.begin() + offsets[i], indices.begin() + offsets[i + 1]);
+				result.dists.assign(dists.begin() + offsets[i], dists.begin() + offsets[i + 1]);
+				batch_[i].promise.set_value(std::move(result));
+			}
+
+			batches++;
+			requests += batch_.size();
+		}
+
+		/**
+			Function which searches the neighbors of a batch
+		*/
+		SearchFunction search;
+
+		/**
+			Dimension of the points
+		*/
+		size_t veclen;
+
+		/**
+			Maximal number of requests in a batch
+		*/
+		size_t max_batch;
+
+		/**
+			Maximal time a request waits for further requests
+		*/
+		std::chrono::microseconds max_delay;
+
+		/**
+			Requests which have not been taken by a worker
+		*/
+		std::deque<Request> pending;
+
+		/**
+			Flag whether the batcher is destroyed
+		*/
+		bool stopped;
+
+		/**
+			Mutex of the pending requests
+		*/
+		std::mutex mutex;
+
+		/**
+			Signaled when requests arrive or the batcher is destroyed
+		*/
+		std::condition_variable changed;
+
+		/**
+			Worker threads
+		*/
+		std::vector<std::thread> workers;
+
+		/**
+			Number of searched batches
+		*/
+		std::atomic<size_t> batches;
+
+		/**
+			Number of answered requests
+		*/
+		std::atomic<size_t> requests;
+	};
+}
+
+#endif /* TREES_SEARCH_BATCHER_H_ */
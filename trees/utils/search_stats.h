@@ -0,0 +1,279 @@
+/***********************************************************************
+* Software License Agreement (BSD License)
+*
+* Copyright 2017	Wolfgang Brandenburger
+*					(w.brandenburger@unibw.de).
+*					All rights reserved.
+*
+* THE BSD LICENSE
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions
+* are met:
+*
+* 1. Redistributions of source code must retain the above copyright
+*    notice, this list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright
+*    notice, this list of conditions and the following disclaimer in the
+*    documentation and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*************************************************************************/
+
+#ifndef TREES_SEARCH_STATS_H_
+#define TREES_SEARCH_STATS_H_
+
+#include <atomic>
+#include <iostream>
+
+/**
+	The instrumentation of the search is enabled by defining TREES_SEARCH_STATS at build time,
+	otherwise all counting statements vanish and the search is not affected
+*/
+#ifdef TREES_SEARCH_STATS
+	#define TREES_SEARCH_COUNT(counter_, number_) (trees::getSearchCounters().counter_ += (number_))
+#else
+	#define TREES_SEARCH_COUNT(counter_, number_)
+#endif
+
+namespace trees
+{
+	/**
+		Structure which holds the counters of the searches performed by one thread
+	*/
+	struct SearchCounters
+	{
+		/**
+			Constructor
+		*/
+		SearchCounters()
+		{
+			clear();
+		}
+
+		/**
+			Reset the counters
+		*/
+		void clear()
+		{
+			queries = 0;
+			nodes_visited = 0;
+			leaves_scanned = 0;
+			distance_evaluations = 0;
+			insertions = 0;
+			pruned_branches = 0;
+		}
+
+		/**
+			Number of queries
+		*/
+		size_t queries;
+
+		/**
+			Number of visited nodes
+		*/
+		size_t nodes_visited;
+
+		/**
+			Number of scanned leaf nodes
+		*/
+		size_t leaves_scanned;
+
+		/**
+			Number of evaluated distances between the query and points of the pointcloud
+		*/
+		size_t distance_evaluations;
+
+		/**
+			Number of points which has been passed to the result set
+		*/
+		size_t insertions;
+
+		/**
+			Number of branches which has not been examined
+		*/
+		size_t pruned_branches;
+	};
+
+	/**
+		Returns the counters of the calling thread
+
+		@return Counters of the calling thread
+	*/
+	inline SearchCounters& getSearchCounters()
+	{
+		static thread_local SearchCounters counters;
+
+		return counters;
+	}
+
+	/**
+		Class which aggregates the counters of all threads taking part in a search
+	*/
+	class SearchStats
+	{
+	public:
+
+		/**
+			Constructor
+		*/
+		SearchStats()
+		{
+			clear();
+		}
+
+		/**
+			Copy constructor
+		*/
+		SearchStats(const SearchStats& stats) = delete;
+
+		/**
+			Operator =
+		*/
+		SearchStats& operator=(const SearchStats& stats) = delete;
+
+		/**
+			Reset the counters
+		*/
+		void clear()
+		{
+			queries = 0;
+			nodes_visited = 0;
+			leaves_scanned = 0;
+			distance_evaluations = 0;
+			insertions = 0;
+			pruned_branches = 0;
+			max_nodes_visited = 0;
+		}
+
+		/**
+			Add the counters of a thread
+
+			@param[in] counters Counters of a thread
+		*/
+		void add(const SearchCounters& counters)
+		{
+			queries += counters.queries;
+			nodes_visited += counters.nodes_visited;
+			leaves_scanned += counters.leaves_scanned;
+			distance_evaluations += counters.distance_evaluations;
+			insertions += counters.insertions;
+			pruned_branches += counters.pruned_branches;
+
+			size_t max_nodes = max_nodes_visited;
+			while (counters.nodes_visited > max_nodes &&
+				!max_nodes_visited.compare_exchange_weak(max_nodes, counters.nodes_visited));
+		}
+
+		/**
+			Get number of queries
+
+			@return Number of queries
+		*/
+		size_t getQueries() const
+		{
+			return queries;
+		}
+
+		/**
+			Get number of visited nodes
+
+			@return Number of visited nodes
+		*/
+		size_t getNodesVisited() const
+		{
+			return nodes_visited;
+		}
+
+		/**
+			Get number of scanned leaf nodes
+
+			@return Number of scanned leaf nodes
+		*/
+		size_t getLeavesScanned() const
+		{
+			return leaves_scanned;
+		}
+
+		/**
+			Get number of evaluated distances
+
+			@return Number of evaluated distances
+		*/
+		size_t getDistanceEvaluations() const
+		{
+			return distance_evaluations;
+		}
+
+		/**
+			Get number of points which has been passed to the result set
+
+			@return Number of insertions
+		*/
+		size_t getInsertions() const
+		{
+			return insertions;
+		}
+
+		/**
+			Get number of branches which has not been examined
+
+			@return Number of pruned branches
+		*/
+		size_t getPrunedBranches() const
+		{
+			return pruned_branches;
+		}
+
+		/**
+			Get the maximal number of nodes visited by a single query
+
+			@return Maximal number of visited nodes
+		*/
+		size_t getMaxNodesVisited() const
+		{
+			return max_nodes_visited;
+		}
+
+	private:
+
+		std::atomic<size_t> queries;
+		std::atomic<size_t> nodes_visited;
+		std::atomic<size_t> leaves_scanned;
+		std::atomic<size_t> distance_evaluations;
+		std::atomic<size_t> insertions;
+		std::atomic<size_t> pruned_branches;
+		std::atomic<size_t> max_nodes_visited;
+	};
+
+	/**
+		Operator << Prints the counters of the search
+
+		@param[in,out] out_ Outstream in which the counters will be printed
+		@param[in] stats_ Counters which shall be printed
+	*/
+	inline std::ostream& operator<<(std::ostream& out_, const SearchStats& stats_)
+	{
+		size_t queries = stats_.getQueries() ? stats_.getQueries() : 1;
+
+		out_ << "Queries: " << stats_.getQueries() << std::endl;
+		out_ << "Nodes visited: " << stats_.getNodesVisited() << " (" << (double)stats_.getNodesVisited() / queries << " per query, max " << stats_.getMaxNodesVisited() << ")" << std::endl;
+		out_ << "Leaves scanned: " << stats_.getLeavesScanned() << " (" << (double)stats_.getLeavesScanned() / queries << " per query)" << std::endl;
+		out_ << "Distance evaluations: " << stats_.getDistanceEvaluations() << " (" << (double)stats_.getDistanceEvaluations() / queries << " per query)" << std::endl;
+		out_ << "Insertions: " << stats_.getInsertions() << " (" << (double)stats_.getInsertions() / queries << " per query)" << std::endl;
+		out_ << "Pruned branches: " << stats_.getPrunedBranches() << " (" << (double)stats_.getPrunedBranches() / queries << " per query)" << std::endl;
+
+		return out_;
+	}
+}
+
+#endif /* TREES_SEARCH_STATS_H_ */